@@ -0,0 +1,294 @@
+#include "client_pool.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+#include "log.h"
+#include "log_ring.h"
+#include "metrics.h"
+#include "status_surface.h"
+
+ClientPool g_clientPool;
+
+namespace {
+
+int64_t steadyMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// A "Key:  value" field of /proc/self/status (Threads, VmRSS in kB)
+int64_t procStatus(const char* key) {
+    FILE* file = std::fopen("/proc/self/status", "r");
+    if (!file) return 0;
+    char line[256];
+    size_t keyLength = std::strlen(key);
+    int64_t value = 0;
+    while (std::fgets(line, sizeof(line), file)) {
+        if (std::strncmp(line, key, keyLength) == 0 && line[keyLength] == ':') {
+            value = std::strtoll(line + keyLength + 1, nullptr, 10);
+            break;
+        }
+    }
+    std::fclose(file);
+    return value;
+}
+
+} // namespace
+
+bool ClientPool::routable(uint64_t applicationId) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return refused_.count(applicationId) == 0;
+}
+
+ClientPool::Entry* ClientPool::find(uint64_t applicationId) {
+    for (auto& entry : entries_) {
+        if (entry.applicationId == applicationId) return &entry;
+    }
+    return nullptr;
+}
+
+ClientPool::Entry* ClientPool::findSerial(uint64_t serial) {
+    for (auto& entry : entries_) {
+        if (entry.serial == serial) return &entry;
+    }
+    return nullptr;
+}
+
+void ClientPool::submit(PendingActivity activity) {
+    runOnPump([this, activity = std::move(activity)]() mutable {
+        int64_t now = steadyMs();
+        uint64_t applicationId = activity.applicationId;
+        for (auto& entry : entries_) {
+            if (entry.applicationId == applicationId) continue;
+            entry.pending.reset();
+            if (entry.showing && entry.ready) entry.client->ClearRichPresence();
+            entry.showing = false;
+        }
+
+        Entry* entry = find(applicationId);
+        if (!entry) {
+            if (parentToken_.empty()) {
+                // Nothing to exchange yet (not signed in): primary client for now
+                LOGE("Client pool: no session to exchange for application %llu", (unsigned long long)applicationId);
+                activity.applicationId = 0;
+                setPendingActivity(std::move(activity));
+                return;
+            }
+            entry = create(applicationId, now);
+        }
+        entry->lastUsedMs = now;
+        entry->pending = std::move(activity);
+        if (entry->ready) send(*entry);
+    });
+}
+
+void ClientPool::clearAll() {
+    if (size_.load(std::memory_order_relaxed) == 0) return;
+    runOnPump([this]() {
+        for (auto& entry : entries_) {
+            entry.pending.reset();
+            if (entry.showing && entry.ready) entry.client->ClearRichPresence();
+            entry.showing = false;
+        }
+    });
+}
+
+ClientPool::Entry* ClientPool::create(uint64_t applicationId, int64_t nowMs) {
+    if (entries_.size() >= kMaxClients) {
+        auto oldest = entries_.begin();
+        for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+            if (it->lastUsedMs < oldest->lastUsedMs) oldest = it;
+        }
+        evict(oldest);
+    }
+
+    int64_t threadsBefore = procStatus("Threads");
+    int64_t rssBefore = procStatus("VmRSS");
+    Entry entry;
+    entry.applicationId = applicationId;
+    entry.serial = nextSerial_++;
+    entry.lastUsedMs = nowMs;
+    entry.client = std::make_shared<discordpp::Client>(g_schedPolicy.createOptions());
+    g_schedPolicy.applyToClient(*entry.client);
+
+    uint64_t serial = entry.serial;
+    entry.client->SetStatusChangedCallback(onPump([this, serial](discordpp::Client::Status status, discordpp::Client::Error error, int32_t errorDetail) {
+        Entry* entry = findSerial(serial);
+        if (!entry) return;  // evicted, disconnecting
+        if (status == discordpp::Client::Status::Ready) {
+            LOGI("Client pool: application %llu ready", (unsigned long long)entry->applicationId);
+            entry->ready = true;
+            if (entry->pending) send(*entry);
+        } else if (error != discordpp::Client::Error::None) {
+            LOGE("Client pool: application %llu error %s (%d)", (unsigned long long)entry->applicationId,
+                 discordpp::Client::ErrorToString(error).c_str(), errorDetail);
+            entry->ready = false;
+        }
+    }));
+    entry.client->ExchangeChildToken(parentToken_, applicationId,
+        onPump([this, serial](discordpp::ClientResult result, std::string accessToken, discordpp::AuthorizationTokenType tokenType, int32_t expiresIn, std::string scopes) {
+            if (result.Successful()) {
+                connect(serial, accessToken);
+            } else {
+                refuse(serial, result.Error());
+            }
+        }));
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        totals_.created++;
+        threadsAdded_ += procStatus("Threads") - threadsBefore;
+        rssKbAdded_ += procStatus("VmRSS") - rssBefore;
+    }
+    LOGI("Client pool: created client for application %llu (%zu in pool)", (unsigned long long)applicationId,
+         entries_.size() + 1);
+    entries_.push_back(std::move(entry));
+    size_.store((uint32_t)entries_.size(), std::memory_order_relaxed);
+    return &entries_.back();
+}
+
+void ClientPool::connect(uint64_t serial, const std::string& childToken) {
+    Entry* entry = findSerial(serial);
+    if (!entry) return;
+    std::shared_ptr<discordpp::Client> client = entry->client;
+    client->UpdateToken(discordpp::AuthorizationTokenType::Bearer, childToken, onPump([this, serial](discordpp::ClientResult result) {
+        Entry* entry = findSerial(serial);
+        if (!entry) return;
+        if (!result.Successful()) {
+            refuse(serial, result.Error());
+            return;
+        }
+        entry->client->Connect();
+    }));
+}
+
+// The exchange (or the exchanged token) was refused: this application's
+// presence goes through the primary client from now on
+void ClientPool::refuse(uint64_t serial, const std::string& error) {
+    auto it = entries_.begin();
+    while (it != entries_.end() && it->serial != serial) ++it;
+    if (it == entries_.end()) return;
+    LOGE("Client pool: no token for application %llu (%s); using the primary client",
+         (unsigned long long)it->applicationId, error.c_str());
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        refused_.insert(it->applicationId);
+        totals_.exchangeFailures++;
+    }
+    std::optional<PendingActivity> pending = std::move(it->pending);
+    evict(it);
+    if (pending) {
+        pending->applicationId = 0;
+        setPendingActivity(std::move(*pending));
+    }
+}
+
+void ClientPool::send(Entry& entry) {
+    RLOGI("Client pool: presence for application %llu", (unsigned long long)entry.applicationId);
+    g_metrics.add(Counter::PresenceSubmits);
+    uint64_t applicationId = entry.applicationId;
+    entry.client->UpdateRichPresence(buildActivity(*entry.pending), [applicationId](discordpp::ClientResult result) {
+        g_metrics.add(result.Successful() ? Counter::PresenceAcks : Counter::PresenceFailures);
+        if (!result.Successful()) {
+            RLOGE("Client pool: presence for application %llu failed: %s", (unsigned long long)applicationId, result.Error());
+        }
+    });
+    entry.showing = true;
+    armExpiry(entry);
+}
+
+void ClientPool::armExpiry(Entry& entry) {
+    cancelPumpTimer(entry.expiryTimer);
+    entry.expiryTimer = 0;
+    int64_t expiresIn = expiryDelayMs(*entry.pending);
+    if (expiresIn < 0) return;
+    uint64_t serial = entry.serial;
+    entry.expiryTimer = schedulePumpTimer(std::chrono::milliseconds(expiresIn), [this, serial] { expire(serial); });
+}
+
+// Same as the primary client's expiry (presence_core.h); a timer outliving its
+// presence finds the entry gone, or a presence without an end
+void ClientPool::expire(uint64_t serial) {
+    Entry* entry = findSerial(serial);
+    if (!entry) return;
+    entry->expiryTimer = 0;
+    if (!entry->pending) return;
+    int64_t expiresIn = expiryDelayMs(*entry->pending);
+    if (expiresIn < 0) return;
+    if (expiresIn > 0) {
+        armExpiry(*entry);
+        return;
+    }
+    g_metrics.add(Counter::PresenceExpiries);
+    if (expiryAction() == ExpiryAction::Untimed) {
+        LOGI("Client pool: presence for application %llu ended; dropping its timestamps", (unsigned long long)entry->applicationId);
+        entry->pending->hasTimestamps = false;
+        entry->pending->start = 0;
+        entry->pending->end = 0;
+        if (entry->ready) send(*entry);
+        g_statusSurface.expire(false);
+        return;
+    }
+    LOGI("Client pool: presence for application %llu ended; clearing it", (unsigned long long)entry->applicationId);
+    entry->pending.reset();
+    if (entry->showing && entry->ready) entry->client->ClearRichPresence();
+    entry->showing = false;
+    g_statusSurface.expire(true);
+}
+
+void ClientPool::evict(std::vector<Entry>::iterator it) {
+    LOGI("Client pool: evicting application %llu", (unsigned long long)it->applicationId);
+    it->client->Disconnect();
+    retireClient(std::move(it->client));
+    entries_.erase(it);
+    size_.store((uint32_t)entries_.size(), std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(mutex_);
+    totals_.evicted++;
+}
+
+void ClientPool::setParentToken(const std::string& token) {
+    parentToken_ = token;
+}
+
+void ClientPool::tick(int64_t nowMs) {
+    for (auto it = entries_.begin(); it != entries_.end();) {
+        if (!it->showing && nowMs - it->lastUsedMs > kIdleEvictMs) {
+            evict(it);
+            it = entries_.begin();
+        } else {
+            ++it;
+        }
+    }
+}
+
+void ClientPool::retireAll() {
+    for (auto& entry : entries_) {
+        if (entry.showing && entry.ready) entry.client->ClearRichPresence();
+        entry.client->Disconnect();
+        retireClient(std::move(entry.client));
+    }
+    entries_.clear();
+    size_.store(0, std::memory_order_relaxed);
+}
+
+void ClientPool::applySchedPolicy() {
+    for (auto& entry : entries_) g_schedPolicy.applyToClient(*entry.client);
+}
+
+void ClientPool::reset() {
+    entries_.clear();
+    parentToken_.clear();
+    size_.store(0, std::memory_order_relaxed);
+}
+
+ClientPoolStats ClientPool::stats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ClientPoolStats stats = totals_;
+    stats.clients = size_.load(std::memory_order_relaxed);
+    if (totals_.created > 0) {
+        stats.threadsPerClient = threadsAdded_ / (int64_t)totals_.created;
+        stats.rssKbPerClient = rssKbAdded_ / (int64_t)totals_.created;
+    }
+    return stats;
+}
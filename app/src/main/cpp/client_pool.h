@@ -0,0 +1,95 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "presence_core.h"
+
+struct ClientPoolStats {
+    uint32_t clients = 0;
+    uint64_t created = 0;
+    uint64_t evicted = 0;
+    uint64_t exchangeFailures = 0;
+    // Averages over every client created: what one more client costs
+    int64_t threadsPerClient = 0;
+    int64_t rssKbPerClient = 0;
+};
+
+// Extra clients for media apps mapped to their own Discord application, so
+// their presence shows under that application's name and art assets. Each
+// client gets its token by exchanging the primary session's token
+// (ExchangeChildToken), so the apps must be children of the primary
+// application; one the exchange is refused for falls back to the primary
+// client from then on.
+//
+// Clients are created and connected on first use and share the primary
+// client's pump thread (RunCallbacks serves every client). One that hasn't
+// shown anything for kIdleEvictMs, or the least recently used one past
+// kMaxClients, is disconnected and released on the pump.
+class ClientPool {
+public:
+    static constexpr size_t kMaxClients = 4;
+    static constexpr int64_t kIdleEvictMs = 5 * 60 * 1000;
+
+    // False when presence for |applicationId| has to go through the primary client
+    bool routable(uint64_t applicationId);
+    // Shows |activity| through the client for activity.applicationId and
+    // clears whatever the other pool clients show. Posts to the pump.
+    void submit(PendingActivity activity);
+    // Clears every pool client's presence; a no-op while the pool is empty
+    void clearAll();
+
+    bool empty() const { return size_.load(std::memory_order_relaxed) == 0; }
+
+    // Pump thread only
+    void setParentToken(const std::string& token);
+    void tick(int64_t nowMs);
+    // Clears, disconnects and hands every client to retireClient (shutdown)
+    void retireAll();
+    // Thread priorities of every client after a g_schedPolicy change
+    void applySchedPolicy();
+    void reset();
+
+    ClientPoolStats stats();
+
+private:
+    struct Entry {
+        uint64_t applicationId = 0;
+        uint64_t serial = 0;
+        std::shared_ptr<discordpp::Client> client;
+        bool ready = false;
+        bool showing = false;
+        std::optional<PendingActivity> pending;
+        int64_t lastUsedMs = 0;
+        TimerId expiryTimer = 0;
+    };
+
+    Entry* find(uint64_t applicationId);
+    Entry* findSerial(uint64_t serial);
+    Entry* create(uint64_t applicationId, int64_t nowMs);
+    void connect(uint64_t serial, const std::string& childToken);
+    void refuse(uint64_t serial, const std::string& error);
+    void send(Entry& entry);
+    void armExpiry(Entry& entry);
+    void expire(uint64_t serial);
+    void evict(std::vector<Entry>::iterator it);
+
+    // Pump thread only
+    std::vector<Entry> entries_;
+    std::string parentToken_;
+    uint64_t nextSerial_ = 1;
+
+    std::atomic<uint32_t> size_{0};
+    std::mutex mutex_;  // guards refused_ and the counters below
+    std::unordered_set<uint64_t> refused_;
+    ClientPoolStats totals_;
+    int64_t threadsAdded_ = 0;
+    int64_t rssKbAdded_ = 0;
+};
+
+extern ClientPool g_clientPool;
@@ -0,0 +1,55 @@
+#include "config_store.h"
+
+#include "log.h"
+#include "string_intern.h"
+
+ConfigStore g_configStore;
+
+uint64_t PackageTable::hashOf(std::string_view package) {
+    uint64_t hash = InternPool::hashOf(package);
+    return hash ? hash : 1;
+}
+
+std::string_view PackageTable::nameOf(const Entry& entry) const {
+    return std::string_view(names_).substr(entry.nameOffset, entry.nameLength);
+}
+
+void PackageTable::add(std::string_view package, const AppSettings& settings) {
+    entries_.push_back({(uint32_t)names_.size(), (uint32_t)package.size(), hashOf(package), settings});
+    names_.append(package);
+}
+
+void PackageTable::build() {
+    uint32_t capacity = 8;
+    while (capacity < entries_.size() * 2) capacity *= 2;
+    slots_.assign(capacity, Slot());
+    mask_ = capacity - 1;
+    for (uint32_t i = 0; i < entries_.size(); i++) {
+        const Entry& entry = entries_[i];
+        uint32_t slot = (uint32_t)entry.hash & mask_;
+        while (slots_[slot].hash != 0) {
+            // A package pushed twice: the later settings win
+            if (slots_[slot].hash == entry.hash && nameOf(entries_[slots_[slot].entry]) == nameOf(entry)) break;
+            slot = (slot + 1) & mask_;
+        }
+        slots_[slot] = {entry.hash, i};
+    }
+}
+
+const AppSettings* PackageTable::find(std::string_view package) const {
+    if (slots_.empty()) return nullptr;
+    uint64_t hash = hashOf(package);
+    for (uint32_t slot = (uint32_t)hash & mask_; slots_[slot].hash != 0; slot = (slot + 1) & mask_) {
+        if (slots_[slot].hash != hash) continue;
+        const Entry& entry = entries_[slots_[slot].entry];
+        if (nameOf(entry) == package) return &entry.settings;
+    }
+    return nullptr;
+}
+
+void ConfigStore::publish(std::shared_ptr<ConfigSnapshot> snapshot) {
+    snapshot->version = ++version_;
+    LOGI("Config v%llu: RPC %s, %zu apps configured, %zu allowed", (unsigned long long)snapshot->version,
+         snapshot->rpcEnabled ? "on" : "off", snapshot->apps.size(), snapshot->allowedCount);
+    std::atomic_store(&current_, std::shared_ptr<const ConfigSnapshot>(std::move(snapshot)));
+}
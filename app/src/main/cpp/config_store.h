@@ -0,0 +1,77 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// The service's settings that media callbacks consult on every update, kept
+// natively so the hot path never reads SharedPreferences. Kotlin pushes the
+// whole configuration when a preference changes; it is built into an
+// immutable ConfigSnapshot and swapped in, and readers keep whichever
+// snapshot they loaded for as long as they hold it.
+
+struct AppSettings {
+    bool allowed = false;
+    int activityType = 2;  // Listening
+    // Discord application to show it under; 0 = the primary client's
+    uint64_t applicationId = 0;
+};
+
+// Package name -> AppSettings in one flat open-addressing table: 16-byte
+// slots (hash, entry index) at no more than half load, entries in a vector
+// and every name in a single arena, so a lookup touches two or three cache
+// lines and the whole table a few kB.
+class PackageTable {
+public:
+    void add(std::string_view package, const AppSettings& settings);
+    // Sizes the slot array and indexes every added package; call once, last
+    void build();
+
+    const AppSettings* find(std::string_view package) const;
+    size_t size() const { return entries_.size(); }
+
+private:
+    struct Slot {
+        uint64_t hash = 0;  // 0 = empty
+        uint32_t entry = 0;
+    };
+    struct Entry {
+        uint32_t nameOffset;
+        uint32_t nameLength;
+        uint64_t hash;
+        AppSettings settings;
+    };
+
+    static uint64_t hashOf(std::string_view package);
+    std::string_view nameOf(const Entry& entry) const;
+
+    std::vector<Slot> slots_;
+    uint32_t mask_ = 0;
+    std::vector<Entry> entries_;
+    std::string names_;
+};
+
+struct ConfigSnapshot {
+    uint64_t version = 0;
+    bool rpcEnabled = true;
+    size_t allowedCount = 0;
+    PackageTable apps;
+};
+
+class ConfigStore {
+public:
+    // Makes |snapshot| current; it gets the next version number
+    void publish(std::shared_ptr<ConfigSnapshot> snapshot);
+
+    // Null until the first publish
+    std::shared_ptr<const ConfigSnapshot> snapshot() const { return std::atomic_load(&current_); }
+
+private:
+    std::shared_ptr<const ConfigSnapshot> current_;
+    std::atomic<uint64_t> version_{0};
+};
+
+extern ConfigStore g_configStore;
@@ -0,0 +1,147 @@
+#include "friend_search.h"
+
+#include <algorithm>
+
+FriendSearchIndex g_friendSearch;
+
+static char fold(char c) { return c >= 'A' && c <= 'Z' ? (char)(c - 'A' + 'a') : c; }
+
+static bool isSeparator(char c) { return c == ' ' || c == '_' || c == '.' || c == '-'; }
+
+static bool equalsFolded(std::string_view folded, std::string_view text) {
+    if (folded.size() != text.size()) return false;
+    for (size_t i = 0; i < text.size(); i++) {
+        if (folded[i] != fold(text[i])) return false;
+    }
+    return true;
+}
+
+FriendSearchIndex::Names FriendSearchIndex::append(const FriendInfo& info) {
+    Names names{(uint32_t)text_.size(), (uint32_t)info.displayName.size(), (uint32_t)info.username.size()};
+    for (char c : info.displayName) text_.push_back(fold(c));
+    for (char c : info.username) text_.push_back(fold(c));
+    return names;
+}
+
+bool FriendSearchIndex::less(const Key& a, const Key& b) const {
+    int order = textOf(a).compare(textOf(b));
+    return order != 0 ? order < 0 : a.userId < b.userId;
+}
+
+template <typename Fn>
+void FriendSearchIndex::forEachKey(uint64_t userId, const Names& names, Fn fn) const {
+    auto words = [&](uint32_t begin, uint32_t end) {
+        for (uint32_t i = begin; i < end; i++) {
+            if (isSeparator(text_[i]) || (i > begin && !isSeparator(text_[i - 1]))) continue;
+            fn(Key{i, end - i, userId});
+        }
+    };
+    uint32_t split = names.offset + names.displayLength;
+    words(names.offset, split);
+    words(split, split + names.usernameLength);
+}
+
+void FriendSearchIndex::eraseKeys(uint64_t userId, const Names& names) {
+    forEachKey(userId, names, [this](const Key& key) {
+        // Equal text and user means interchangeable: a friend whose two names
+        // share a word has it twice, and both go
+        auto it = std::lower_bound(keys_.begin(), keys_.end(), key, [this](const Key& a, const Key& b) { return less(a, b); });
+        if (it != keys_.end() && it->userId == key.userId && textOf(*it) == textOf(key)) keys_.erase(it);
+    });
+    garbage_ += names.displayLength + names.usernameLength;
+}
+
+bool FriendSearchIndex::update(const FriendInfo& info) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = names_.find(info.userId);
+    if (it != names_.end()) {
+        const Names& old = it->second;
+        std::string_view text(text_);
+        if (equalsFolded(text.substr(old.offset, old.displayLength), info.displayName) &&
+            equalsFolded(text.substr(old.offset + old.displayLength, old.usernameLength), info.username)) {
+            return false;
+        }
+        eraseKeys(info.userId, old);
+    }
+    Names names = append(info);
+    names_[info.userId] = names;
+    // One sorted insert per word, each a memmove of the tail: ~20 µs for a
+    // rename at 5k friends, where a query is well under one
+    forEachKey(info.userId, names, [this](const Key& key) {
+        auto at = std::lower_bound(keys_.begin(), keys_.end(), key, [this](const Key& a, const Key& b) { return less(a, b); });
+        keys_.insert(at, key);
+    });
+    if (garbage_ > text_.size() - garbage_) compact();
+    return true;
+}
+
+bool FriendSearchIndex::remove(uint64_t userId) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = names_.find(userId);
+    if (it == names_.end()) return false;
+    eraseKeys(userId, it->second);
+    names_.erase(it);
+    if (garbage_ > text_.size() - garbage_) compact();
+    return true;
+}
+
+void FriendSearchIndex::replaceAll(const std::vector<FriendInfo>& friends) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    names_.clear();
+    text_.clear();
+    garbage_ = 0;
+    for (const FriendInfo& info : friends) names_[info.userId] = append(info);
+    // Builds the keys, and drops the text of anyone listed twice
+    compact();
+}
+
+void FriendSearchIndex::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    keys_.clear();
+    names_.clear();
+    text_.clear();
+    garbage_ = 0;
+}
+
+// Rewrites text_ with only live names and rebuilds the keys from it
+void FriendSearchIndex::compact() {
+    size_t live = 0;
+    for (const auto& [userId, names] : names_) live += names.displayLength + names.usernameLength;
+    std::string text;
+    text.reserve(live);
+    for (auto& [userId, names] : names_) {
+        uint32_t offset = (uint32_t)text.size();
+        text.append(text_, names.offset, names.displayLength + names.usernameLength);
+        names.offset = offset;
+    }
+    text_ = std::move(text);
+    garbage_ = 0;
+
+    keys_.clear();
+    for (const auto& [userId, names] : names_) {
+        forEachKey(userId, names, [this](const Key& key) { keys_.push_back(key); });
+    }
+    std::sort(keys_.begin(), keys_.end(), [this](const Key& a, const Key& b) { return less(a, b); });
+}
+
+void FriendSearchIndex::search(std::string_view prefix, size_t limit, std::vector<uint64_t>* out) {
+    if (prefix.empty() || limit == 0) return;
+    std::string folded(prefix);
+    for (char& c : folded) c = fold(c);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t first = out->size();
+    auto it = std::lower_bound(keys_.begin(), keys_.end(), folded,
+                               [this](const Key& key, const std::string& value) { return textOf(key) < value; });
+    for (; it != keys_.end() && out->size() - first < limit; ++it) {
+        std::string_view text = textOf(*it);
+        if (text.compare(0, folded.size(), folded) != 0) break;
+        // A friend can match through several words; the first one places them
+        if (std::find(out->begin() + first, out->end(), it->userId) == out->end()) out->push_back(it->userId);
+    }
+}
+
+size_t FriendSearchIndex::keys() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return keys_.size();
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "relationship_store.h"
+
+// Search-as-you-type over the friends list without an SDK round trip per
+// keystroke (Client::SearchFriendsByUsername returns a fresh vector of
+// handles every call). Every word of a friend's display name and username
+// is a key; the keys sit in one vector sorted by their case-folded text, so
+// a prefix query is a binary search followed by a short forward scan, and
+// the first K distinct friends it meets are the top K, in name order.
+//
+// Kept up to date by presence_core.cpp next to the relationship store: a user
+// update only touches the index when one of the two names changed, and then
+// erases and inserts just that friend's keys. Queries come from the UI thread,
+// updates from the pump; both hold mutex_ for microseconds.
+class FriendSearchIndex {
+public:
+    // False if |info|'s names are what the index already has
+    bool update(const FriendInfo& info);
+    bool remove(uint64_t userId);
+    // A full load, sorted once rather than inserted friend by friend
+    void replaceAll(const std::vector<FriendInfo>& friends);
+    void clear();
+
+    // Up to |limit| friends with a word of either name starting with
+    // |prefix| (ASCII case-insensitively), appended to |out| in the order of
+    // the word that matched; an empty prefix matches nobody
+    void search(std::string_view prefix, size_t limit, std::vector<uint64_t>* out);
+    size_t keys();
+
+private:
+    // A word start to the end of its name, in text_
+    struct Key {
+        uint32_t offset;
+        uint32_t length;
+        uint64_t userId;
+    };
+    // Both names of one friend, folded, back to back in text_
+    struct Names {
+        uint32_t offset;
+        uint32_t displayLength;
+        uint32_t usernameLength;
+    };
+
+    std::string_view textOf(const Key& key) const { return std::string_view(text_).substr(key.offset, key.length); }
+    // The order of keys_
+    bool less(const Key& a, const Key& b) const;
+    Names append(const FriendInfo& info);
+    // Calls |fn| with every key of |names|
+    template <typename Fn>
+    void forEachKey(uint64_t userId, const Names& names, Fn fn) const;
+    void eraseKeys(uint64_t userId, const Names& names);
+    void compact();
+
+    std::mutex mutex_;
+    std::vector<Key> keys_;  // sorted by folded text, then user id
+    std::unordered_map<uint64_t, Names> names_;
+    std::string text_;
+    size_t garbage_ = 0;  // bytes of text_ no friend's names are in
+};
+
+extern FriendSearchIndex g_friendSearch;
@@ -0,0 +1,99 @@
+#include "bench_harness.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+std::function<AllocSample()> g_extraAllocs;
+
+namespace {
+
+std::atomic<uint64_t> g_newCount{0};
+std::atomic<uint64_t> g_newBytes{0};
+
+AllocSample sampleAllocs() {
+    AllocSample sample{g_newCount.load(std::memory_order_relaxed), g_newBytes.load(std::memory_order_relaxed)};
+    if (g_extraAllocs) {
+        AllocSample extra = g_extraAllocs();
+        sample.count += extra.count;
+        sample.bytes += extra.bytes;
+    }
+    return sample;
+}
+
+void* countedAlloc(size_t size) {
+    g_newCount.fetch_add(1, std::memory_order_relaxed);
+    g_newBytes.fetch_add(size, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+} // namespace
+
+void* operator new(size_t size) { return countedAlloc(size); }
+void* operator new[](size_t size) { return countedAlloc(size); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+
+void BenchState::pause() {
+    elapsedNs_ += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - started_).count();
+    AllocSample now = sampleAllocs();
+    allocs_.count += now.count - allocStart_.count;
+    allocs_.bytes += now.bytes - allocStart_.bytes;
+}
+
+void BenchState::resume() {
+    allocStart_ = sampleAllocs();
+    started_ = std::chrono::steady_clock::now();
+}
+
+BenchResult BenchRunner::run(const Benchmark& benchmark) const {
+    int64_t iterations = 1;
+    while (true) {
+        BenchState state;
+        state.iterations = iterations;
+        state.resume();
+        benchmark.body(state);
+        state.pause();
+
+        if (state.elapsedNs_ >= minNs_ || iterations >= (1LL << 30)) {
+            double n = (double)iterations;
+            return {benchmark.name, iterations, state.elapsedNs_ / n, state.allocs_.count / n, state.allocs_.bytes / n};
+        }
+        // Aim a little past the target so the final run usually qualifies
+        double perOp = state.elapsedNs_ > 0 ? (double)state.elapsedNs_ / iterations : 1;
+        int64_t next = (int64_t)(minNs_ * 1.2 / perOp);
+        iterations = std::max(iterations * 2, std::min(next, iterations * 100));
+    }
+}
+
+std::string toJson(const BenchResult& r) {
+    char buffer[512];
+    std::snprintf(buffer, sizeof(buffer),
+                  "{\"name\": \"%s\", \"iterations\": %lld, \"ns_per_op\": %.2f, \"allocs_per_op\": %.3f, \"bytes_per_op\": %.1f}",
+                  r.name.c_str(), (long long)r.iterations, r.nsPerOp, r.allocsPerOp, r.bytesPerOp);
+    return buffer;
+}
+
+bool fromJson(const std::string& line, BenchResult* r) {
+    auto number = [&](const char* key, double* out) {
+        size_t at = line.find(std::string("\"") + key + "\":");
+        if (at == std::string::npos) return false;
+        *out = std::strtod(line.c_str() + at + std::strlen(key) + 3, nullptr);
+        return true;
+    };
+    size_t name = line.find("\"name\": \"");
+    if (name == std::string::npos) return false;
+    name += 9;
+    size_t close = line.find('"', name);
+    if (close == std::string::npos) return false;
+    r->name = line.substr(name, close - name);
+    double iterations = 0;
+    return number("iterations", &iterations) && number("ns_per_op", &r->nsPerOp) &&
+           number("allocs_per_op", &r->allocsPerOp) && number("bytes_per_op", &r->bytesPerOp) &&
+           (r->iterations = (int64_t)iterations, true);
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Minimal benchmark runner for native_bench. Each benchmark body runs
+// state.iterations operations; the runner grows the count until a run takes
+// at least the minimum time, then reports ns/op, allocations/op and bytes/op.
+//
+// Allocations are counted by replacing global operator new (bench_harness.cpp)
+// plus whatever g_extraAllocs reports, e.g. Discord_Alloc calls in the SDK.
+
+struct AllocSample {
+    uint64_t count;
+    uint64_t bytes;
+};
+
+extern std::function<AllocSample()> g_extraAllocs;
+
+class BenchState {
+public:
+    // Excludes setup work inside a body from the timing and allocation counts
+    void pause();
+    void resume();
+
+    int64_t iterations = 0;
+
+private:
+    friend class BenchRunner;
+
+    std::chrono::steady_clock::time_point started_;
+    int64_t elapsedNs_ = 0;
+    AllocSample allocStart_ = {};
+    AllocSample allocs_ = {};
+};
+
+struct Benchmark {
+    std::string name;
+    std::function<void(BenchState&)> body;
+};
+
+struct BenchResult {
+    std::string name;
+    int64_t iterations;
+    double nsPerOp;
+    double allocsPerOp;
+    double bytesPerOp;
+};
+
+class BenchRunner {
+public:
+    explicit BenchRunner(double minSeconds) : minNs_(minSeconds * 1e9) {}
+
+    BenchResult run(const Benchmark& benchmark) const;
+
+private:
+    double minNs_;
+};
+
+// One JSON object per line, so results from two commits diff and parse easily
+std::string toJson(const BenchResult& result);
+bool fromJson(const std::string& line, BenchResult* result);
@@ -0,0 +1,875 @@
+#include "fake_discord_sdk.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "cdiscord.h"
+
+namespace {
+
+struct FakeAssets {
+    std::string largeImage, largeText;
+};
+
+struct FakeTimestamps {
+    uint64_t start = 0, end = 0;
+};
+
+struct FakeActivity {
+    std::string name;
+    std::optional<std::string> details, state;
+    Discord_ActivityTypes type = Discord_ActivityTypes_Playing;
+    std::optional<Discord_StatusDisplayTypes> displayType;
+    std::optional<FakeAssets> assets;
+    std::optional<FakeTimestamps> timestamps;
+};
+
+struct FakeResult {
+    Discord_ErrorType type = Discord_ErrorType_None;
+    std::string error;
+    Discord_HttpStatusCode status = Discord_HttpStatusCode_None;
+    bool retryable = false;
+    float retryAfter = 0;
+};
+
+struct FakeUser {
+    uint64_t id;
+    std::string username;
+    std::string avatar;
+    std::optional<std::string> globalName;
+    Discord_StatusType status = Discord_StatusType_Online;
+    std::optional<FakeActivity> activity;
+};
+
+struct FakeRelationship {
+    uint64_t id;
+    Discord_RelationshipType type = Discord_RelationshipType_None;
+    std::optional<FakeUser> user;
+};
+
+struct FakeVerifier {
+    std::string verifier;
+};
+
+struct LogSink {
+    Discord_Client_LogCallback cb;
+    Discord_FreeFn free;
+    void* data;
+    Discord_LoggingSeverity minSeverity;
+};
+
+template <typename Callback>
+struct Handler {
+    Callback cb = nullptr;
+    Discord_FreeFn free = nullptr;
+    void* data = nullptr;
+
+    void release() {
+        if (free) free(data);
+    }
+};
+
+struct FakeClient {
+    Discord_Client_OnStatusChanged statusCb = nullptr;
+    Discord_FreeFn statusFree = nullptr;
+    void* statusData = nullptr;
+    std::vector<LogSink> logs;
+    Handler<Discord_Client_RelationshipCreatedCallback> relationshipCreated;
+    Handler<Discord_Client_RelationshipDeletedCallback> relationshipDeleted;
+    Handler<Discord_Client_UserUpdatedCallback> userUpdated;
+    std::string token;
+    Discord_Client_Status status = Discord_Client_Status_Disconnected;
+    bool transitionPending = false;  // a connect/drop sequence is queued
+    std::deque<int64_t> recentUpdates;
+};
+
+// A callback waiting for its simulated latency; |cancel| frees user data if
+// the client goes away first
+struct Scheduled {
+    int64_t dueMs;
+    uint64_t seq;
+    FakeClient* client;
+    std::function<void()> run;
+    std::function<void()> cancel;
+};
+
+std::mutex g_fakeMutex;
+FakeSdkConfig g_config;
+FakeSdkStats g_stats = {};
+std::mt19937 g_rng(1);
+std::vector<Scheduled> g_queue;
+uint64_t g_seq = 0;
+std::vector<FakeClient*> g_clients;
+std::optional<FakeActivity> g_lastPresence;
+// The signed-in user's, whichever client asks; by id
+std::vector<FakeRelationship> g_relationships;
+
+std::atomic<uint64_t> g_allocs{0};
+std::atomic<uint64_t> g_allocBytes{0};
+
+int64_t nowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+bool roll(double rate) {
+    return rate > 0 && std::uniform_real_distribution<double>(0, 1)(g_rng) < rate;
+}
+
+std::string toString(Discord_String s) {
+    return std::string(reinterpret_cast<const char*>(s.ptr), s.size);
+}
+
+void putString(Discord_String* out, const std::string& s) {
+    out->ptr = static_cast<uint8_t*>(Discord_Alloc(s.size() + 1));
+    std::memcpy(out->ptr, s.data(), s.size());
+    out->size = s.size();
+}
+
+Discord_ClientResult makeResult(FakeResult result) {
+    return Discord_ClientResult{new FakeResult(std::move(result))};
+}
+
+FakeClient* clientOf(Discord_Client* self) { return static_cast<FakeClient*>(self->opaque); }
+FakeActivity* activityOf(Discord_Activity* self) { return static_cast<FakeActivity*>(self->opaque); }
+
+const char* statusName(Discord_Client_Status status) {
+    switch (status) {
+    case Discord_Client_Status_Disconnected: return "Disconnected";
+    case Discord_Client_Status_Connecting: return "Connecting";
+    case Discord_Client_Status_Connected: return "Connected";
+    case Discord_Client_Status_Ready: return "Ready";
+    case Discord_Client_Status_Reconnecting: return "Reconnecting";
+    case Discord_Client_Status_Disconnecting: return "Disconnecting";
+    case Discord_Client_Status_HttpWait: return "HttpWait";
+    default: return "Unknown";
+    }
+}
+
+const char* errorName(Discord_Client_Error error) {
+    switch (error) {
+    case Discord_Client_Error_None: return "None";
+    case Discord_Client_Error_ConnectionFailed: return "ConnectionFailed";
+    case Discord_Client_Error_UnexpectedClose: return "UnexpectedClose";
+    case Discord_Client_Error_ConnectionCanceled: return "ConnectionCanceled";
+    default: return "Unknown";
+    }
+}
+
+// Caller holds g_fakeMutex
+// Free-threaded mode (Discord_SetFreeThreaded): a dispatcher thread delivers
+// callbacks as they come due, as the real SDK does from its own threads.
+// Dropping a client waits out a batch in flight, so none runs on a freed client.
+struct Dispatcher {
+    std::thread thread;
+    std::condition_variable changed;  // queue grew, a batch finished, or stop
+    bool dispatching = false;
+    bool stop = false;
+
+    ~Dispatcher();
+};
+Dispatcher g_dispatcher;
+
+void schedule(FakeClient* client, int64_t delayMs, std::function<void()> run, std::function<void()> cancel = {}) {
+    g_queue.push_back({nowMs() + delayMs, g_seq++, client, std::move(run), std::move(cancel)});
+    if (g_dispatcher.thread.joinable()) g_dispatcher.changed.notify_all();
+}
+
+// Caller holds g_fakeMutex
+std::vector<Scheduled> takeDue() {
+    std::vector<Scheduled> due;
+    int64_t now = nowMs();
+    auto split = std::partition(g_queue.begin(), g_queue.end(), [now](const Scheduled& s) { return s.dueMs > now; });
+    due.assign(std::make_move_iterator(split), std::make_move_iterator(g_queue.end()));
+    g_queue.erase(split, g_queue.end());
+    g_stats.callbacks += due.size();
+    std::sort(due.begin(), due.end(), [](const Scheduled& a, const Scheduled& b) {
+        return a.dueMs != b.dueMs ? a.dueMs < b.dueMs : a.seq < b.seq;
+    });
+    return due;
+}
+
+void dispatchLoop() {
+    std::unique_lock<std::mutex> lock(g_fakeMutex);
+    while (!g_dispatcher.stop) {
+        if (g_queue.empty()) {
+            g_dispatcher.changed.wait(lock);
+            continue;
+        }
+        int64_t next = std::min_element(g_queue.begin(), g_queue.end(), [](const Scheduled& a, const Scheduled& b) {
+            return a.dueMs < b.dueMs;
+        })->dueMs;
+        int64_t now = nowMs();
+        if (next > now) {
+            g_dispatcher.changed.wait_for(lock, std::chrono::milliseconds(next - now));
+            continue;
+        }
+        std::vector<Scheduled> due = takeDue();
+        g_dispatcher.dispatching = true;
+        lock.unlock();
+        for (auto& s : due) s.run();
+        lock.lock();
+        g_dispatcher.dispatching = false;
+        g_dispatcher.changed.notify_all();
+    }
+}
+
+Dispatcher::~Dispatcher() {
+    if (!thread.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(g_fakeMutex);
+        stop = true;
+    }
+    changed.notify_all();
+    thread.join();
+}
+
+// Caller holds g_fakeMutex. The status is applied when the change is delivered,
+// which is also when the app hears about it.
+void scheduleStatus(FakeClient* client, int64_t delayMs, Discord_Client_Status status,
+                    Discord_Client_Error error = Discord_Client_Error_None, int32_t detail = 0, bool last = false) {
+    schedule(client, delayMs, [client, status, error, detail, last]() {
+        Discord_Client_OnStatusChanged cb;
+        void* data;
+        std::vector<LogSink> logs;
+        {
+            std::lock_guard<std::mutex> lock(g_fakeMutex);
+            client->status = status;
+            if (last) client->transitionPending = false;
+            if (status == Discord_Client_Status_Ready) g_stats.readies++;
+            cb = client->statusCb;
+            data = client->statusData;
+            logs = client->logs;
+        }
+        for (const auto& sink : logs) {
+            if (sink.minSeverity > Discord_LoggingSeverity_Info) continue;
+            Discord_String message;
+            putString(&message, std::string("[fake] status ") + statusName(status) + ", error " + errorName(error));
+            sink.cb(message, Discord_LoggingSeverity_Info, sink.data);
+        }
+        if (cb) cb(status, error, detail, data);
+    });
+}
+
+// Caller holds g_fakeMutex
+void scheduleDrop(FakeClient* client) {
+    if (client->transitionPending) return;
+    client->transitionPending = true;
+    g_stats.disconnects++;
+    scheduleStatus(client, 0, Discord_Client_Status_Disconnected, Discord_Client_Error_UnexpectedClose, 1006);
+    scheduleStatus(client, 0, Discord_Client_Status_Reconnecting);
+    scheduleStatus(client, g_config.reconnectMs, Discord_Client_Status_Ready, Discord_Client_Error_None, 0, true);
+}
+
+template <typename Callback>
+void scheduleResult(FakeClient* client, int64_t delayMs, FakeResult result, Callback cb, Discord_FreeFn free, void* data) {
+    schedule(client, delayMs, [result, cb, free, data]() {
+        Discord_ClientResult native = makeResult(result);
+        cb(&native, data);
+        if (free) free(data);
+    }, [free, data]() {
+        if (free) free(data);
+    });
+}
+
+// Caller holds g_fakeMutex. |client|'s handler, read when the callback runs,
+// so one set (or replaced) meanwhile is the one called.
+template <typename Callback, typename... Args>
+void scheduleHandler(FakeClient* client, Handler<Callback> FakeClient::*member, Args... args) {
+    g_stats.friendEvents++;
+    schedule(client, 0, [client, member, args...]() {
+        Handler<Callback> handler;
+        {
+            std::lock_guard<std::mutex> lock(g_fakeMutex);
+            handler = client->*member;
+        }
+        if (handler.cb) handler.cb(args..., handler.data);
+    });
+}
+
+template <typename Callback>
+void setHandler(FakeClient* client, Handler<Callback> FakeClient::*member, Callback cb, Discord_FreeFn free, void* data) {
+    Handler<Callback> old;
+    {
+        std::lock_guard<std::mutex> lock(g_fakeMutex);
+        old = client->*member;
+        client->*member = {cb, free, data};
+    }
+    old.release();
+}
+
+FakeRelationship* findRelationship(uint64_t userId) {
+    auto it = std::lower_bound(g_relationships.begin(), g_relationships.end(), userId,
+                               [](const FakeRelationship& r, uint64_t id) { return r.id < id; });
+    return it != g_relationships.end() && it->id == userId ? &*it : nullptr;
+}
+
+// Caller holds g_fakeMutex: a new activity and status for |user|
+void changeActivity(FakeUser* user) {
+    static const Discord_StatusType kStatuses[] = {Discord_StatusType_Online, Discord_StatusType_Idle,
+                                                   Discord_StatusType_Dnd, Discord_StatusType_Offline};
+    user->status = kStatuses[g_rng() % 4];
+    uint32_t kind = g_rng() % 3;
+    if (user->status == Discord_StatusType_Offline || kind == 0) {
+        user->activity.reset();
+        return;
+    }
+    FakeActivity activity;
+    uint32_t track = g_rng() % 10000;
+    activity.type = kind == 1 ? Discord_ActivityTypes_Listening : Discord_ActivityTypes_Playing;
+    activity.name = kind == 1 ? "Music" : "Game";
+    activity.details = "Track " + std::to_string(track);
+    activity.state = "Artist " + std::to_string(track % 97);
+    user->activity = std::move(activity);
+}
+
+FakeResult notReady() {
+    FakeResult r;
+    r.type = Discord_ErrorType_ClientNotReady;
+    r.error = "client not ready";
+    return r;
+}
+
+} // namespace
+
+void fakeSdkConfigure(const FakeSdkConfig& config) {
+    std::lock_guard<std::mutex> lock(g_fakeMutex);
+    g_config = config;
+    g_rng.seed(config.seed);
+    g_relationships.clear();
+    for (int i = 0; i < config.friends; i++) {
+        FakeUser user{500000000000000000ull + (uint64_t)i, "friend" + std::to_string(i), ""};
+        if (i % 2) user.globalName = "Friend " + std::to_string(i);
+        changeActivity(&user);
+        g_relationships.push_back({user.id, Discord_RelationshipType_Friend, std::move(user)});
+    }
+}
+
+FakeSdkStats fakeSdkStats() {
+    std::lock_guard<std::mutex> lock(g_fakeMutex);
+    FakeSdkStats stats = g_stats;
+    stats.allocs = g_allocs;
+    stats.allocBytes = g_allocBytes;
+    return stats;
+}
+
+void fakeSdkResetStats() {
+    std::lock_guard<std::mutex> lock(g_fakeMutex);
+    // What live clients were created with still holds
+    FakeSdkStats kept = {};
+    kept.cpuAffinityMask = g_stats.cpuAffinityMask;
+    kept.threadPriority = g_stats.threadPriority;
+    g_stats = kept;
+    g_allocs = 0;
+    g_allocBytes = 0;
+}
+
+size_t fakeSdkQueuedCallbacks() {
+    std::lock_guard<std::mutex> lock(g_fakeMutex);
+    return g_queue.size();
+}
+
+void fakeSdkDropConnections() {
+    std::lock_guard<std::mutex> lock(g_fakeMutex);
+    for (FakeClient* client : g_clients) {
+        if (client->status == Discord_Client_Status_Ready) scheduleDrop(client);
+    }
+}
+
+void fakeSdkChangeFriends(int count) {
+    std::lock_guard<std::mutex> lock(g_fakeMutex);
+    if (g_relationships.empty()) return;
+    for (int i = 0; i < count; i++) {
+        FakeRelationship& relationship = g_relationships[g_rng() % g_relationships.size()];
+        bool toggle = g_rng() % 10 == 0;
+        if (toggle) {
+            relationship.type = relationship.type == Discord_RelationshipType_Friend ? Discord_RelationshipType_None
+                                                                                    : Discord_RelationshipType_Friend;
+        } else {
+            changeActivity(&*relationship.user);
+        }
+        for (FakeClient* client : g_clients) {
+            if (client->status != Discord_Client_Status_Ready) continue;
+            if (!toggle) {
+                scheduleHandler(client, &FakeClient::userUpdated, relationship.id);
+            } else if (relationship.type == Discord_RelationshipType_Friend) {
+                scheduleHandler(client, &FakeClient::relationshipCreated, relationship.id, true);
+            } else {
+                scheduleHandler(client, &FakeClient::relationshipDeleted, relationship.id, true);
+            }
+        }
+    }
+}
+
+bool fakeSdkLastPresence(std::string* details, std::string* state) {
+    std::lock_guard<std::mutex> lock(g_fakeMutex);
+    if (!g_lastPresence) return false;
+    *details = g_lastPresence->details.value_or("");
+    *state = g_lastPresence->state.value_or("");
+    return true;
+}
+
+extern "C" {
+
+void* Discord_Alloc(size_t size) {
+    g_allocs.fetch_add(1, std::memory_order_relaxed);
+    g_allocBytes.fetch_add(size, std::memory_order_relaxed);
+    return std::malloc(size);
+}
+
+void Discord_Free(void* ptr) { std::free(ptr); }
+
+void Discord_SetFreeThreaded() {
+    std::lock_guard<std::mutex> lock(g_fakeMutex);
+    if (!g_dispatcher.thread.joinable()) g_dispatcher.thread = std::thread(dispatchLoop);
+}
+
+void Discord_RunCallbacks() {
+    std::vector<Scheduled> due;
+    {
+        std::lock_guard<std::mutex> lock(g_fakeMutex);
+        due = takeDue();
+    }
+    for (auto& s : due) s.run();
+}
+
+// Client
+
+void Discord_ClientCreateOptions_Init(Discord_ClientCreateOptions* self) { self->opaque = new uint64_t(0); }
+void Discord_ClientCreateOptions_Drop(Discord_ClientCreateOptions* self) { delete static_cast<uint64_t*>(self->opaque); }
+void Discord_ClientCreateOptions_Clone(Discord_ClientCreateOptions* self, Discord_ClientCreateOptions const* arg0) {
+    self->opaque = new uint64_t(*static_cast<uint64_t*>(arg0->opaque));
+}
+void Discord_ClientCreateOptions_SetCpuAffinityMask(Discord_ClientCreateOptions* self, uint64_t* value) {
+    *static_cast<uint64_t*>(self->opaque) = value ? *value : 0;
+}
+
+void Discord_Client_Init(Discord_Client* self) {
+    auto* client = new FakeClient();
+    self->opaque = client;
+    std::lock_guard<std::mutex> lock(g_fakeMutex);
+    g_clients.push_back(client);
+}
+
+void Discord_Client_InitWithOptions(Discord_Client* self, Discord_ClientCreateOptions* options) {
+    Discord_Client_Init(self);
+    std::lock_guard<std::mutex> lock(g_fakeMutex);
+    g_stats.cpuAffinityMask = *static_cast<uint64_t*>(options->opaque);
+}
+
+void Discord_Client_SetThreadPriority(Discord_Client* self, Discord_Client_Thread thread, int32_t priority) {
+    std::lock_guard<std::mutex> lock(g_fakeMutex);
+    if (thread == Discord_Client_Thread_Client) g_stats.threadPriority = priority;
+}
+
+void Discord_Client_Drop(Discord_Client* self) {
+    FakeClient* client = clientOf(self);
+    std::vector<Scheduled> orphaned;
+    {
+        std::unique_lock<std::mutex> lock(g_fakeMutex);
+        if (std::this_thread::get_id() != g_dispatcher.thread.get_id()) {
+            g_dispatcher.changed.wait(lock, [] { return !g_dispatcher.dispatching; });
+        }
+        g_clients.erase(std::remove(g_clients.begin(), g_clients.end(), client), g_clients.end());
+        auto split = std::partition(g_queue.begin(), g_queue.end(), [client](const Scheduled& s) { return s.client != client; });
+        orphaned.assign(std::make_move_iterator(split), std::make_move_iterator(g_queue.end()));
+        g_queue.erase(split, g_queue.end());
+    }
+    for (auto& s : orphaned) {
+        if (s.cancel) s.cancel();
+    }
+    if (client->statusFree) client->statusFree(client->statusData);
+    for (auto& sink : client->logs) {
+        if (sink.free) sink.free(sink.data);
+    }
+    client->relationshipCreated.release();
+    client->relationshipDeleted.release();
+    client->userUpdated.release();
+    delete client;
+    self->opaque = nullptr;
+}
+
+void Discord_Client_StatusToString(Discord_Client_Status type, Discord_String* returnValue) {
+    putString(returnValue, statusName(type));
+}
+
+void Discord_Client_ErrorToString(Discord_Client_Error type, Discord_String* returnValue) {
+    putString(returnValue, errorName(type));
+}
+
+void Discord_Client_AddLogCallback(Discord_Client* self, Discord_Client_LogCallback callback, Discord_FreeFn callback__userDataFree,
+                                   void* callback__userData, Discord_LoggingSeverity minSeverity) {
+    std::lock_guard<std::mutex> lock(g_fakeMutex);
+    clientOf(self)->logs.push_back({callback, callback__userDataFree, callback__userData, minSeverity});
+}
+
+void Discord_Client_SetStatusChangedCallback(Discord_Client* self, Discord_Client_OnStatusChanged cb, Discord_FreeFn cb__userDataFree,
+                                             void* cb__userData) {
+    FakeClient* client = clientOf(self);
+    Discord_FreeFn oldFree;
+    void* oldData;
+    {
+        std::lock_guard<std::mutex> lock(g_fakeMutex);
+        oldFree = client->statusFree;
+        oldData = client->statusData;
+        client->statusCb = cb;
+        client->statusFree = cb__userDataFree;
+        client->statusData = cb__userData;
+    }
+    if (oldFree) oldFree(oldData);
+}
+
+void Discord_Client_SetRelationshipCreatedCallback(Discord_Client* self, Discord_Client_RelationshipCreatedCallback cb,
+                                                   Discord_FreeFn cb__userDataFree, void* cb__userData) {
+    setHandler(clientOf(self), &FakeClient::relationshipCreated, cb, cb__userDataFree, cb__userData);
+}
+
+void Discord_Client_SetRelationshipDeletedCallback(Discord_Client* self, Discord_Client_RelationshipDeletedCallback cb,
+                                                   Discord_FreeFn cb__userDataFree, void* cb__userData) {
+    setHandler(clientOf(self), &FakeClient::relationshipDeleted, cb, cb__userDataFree, cb__userData);
+}
+
+void Discord_Client_SetUserUpdatedCallback(Discord_Client* self, Discord_Client_UserUpdatedCallback cb,
+                                           Discord_FreeFn cb__userDataFree, void* cb__userData) {
+    setHandler(clientOf(self), &FakeClient::userUpdated, cb, cb__userDataFree, cb__userData);
+}
+
+Discord_Client_Status Discord_Client_GetStatus(Discord_Client* self) {
+    std::lock_guard<std::mutex> lock(g_fakeMutex);
+    return clientOf(self)->status;
+}
+
+void Discord_Client_Connect(Discord_Client* self) {
+    FakeClient* client = clientOf(self);
+    std::lock_guard<std::mutex> lock(g_fakeMutex);
+    if (client->status != Discord_Client_Status_Disconnected || client->transitionPending) return;
+    client->transitionPending = true;
+    int latency = g_config.connectLatencyMs;
+    scheduleStatus(client, 0, Discord_Client_Status_Connecting);
+    if (client->token.empty()) {
+        // Gateway closes with "authentication failed"
+        scheduleStatus(client, latency, Discord_Client_Status_Disconnected, Discord_Client_Error_ConnectionFailed, 4004, true);
+        return;
+    }
+    scheduleStatus(client, latency / 2, Discord_Client_Status_Connected);
+    scheduleStatus(client, latency, Discord_Client_Status_Ready, Discord_Client_Error_None, 0, true);
+}
+
+void Discord_Client_Disconnect(Discord_Client* self) {
+    FakeClient* client = clientOf(self);
+    std::lock_guard<std::mutex> lock(g_fakeMutex);
+    if (client->status == Discord_Client_Status_Disconnected) return;
+    client->transitionPending = true;
+    scheduleStatus(client, 0, Discord_Client_Status_Disconnecting);
+    scheduleStatus(client, 0, Discord_Client_Status_Disconnected, Discord_Client_Error_None, 0, true);
+}
+
+void Discord_Client_CreateAuthorizationCodeVerifier(Discord_Client* self, Discord_AuthorizationCodeVerifier* returnValue) {
+    returnValue->opaque = new FakeVerifier{"fake-verifier"};
+}
+
+void Discord_Client_UpdateToken(Discord_Client* self, Discord_AuthorizationTokenType tokenType, Discord_String token,
+                                Discord_Client_UpdateTokenCallback callback, Discord_FreeFn callback__userDataFree,
+                                void* callback__userData) {
+    FakeClient* client = clientOf(self);
+    std::lock_guard<std::mutex> lock(g_fakeMutex);
+    client->token = toString(token);
+    scheduleResult(client, g_config.tokenLatencyMs, FakeResult(), callback, callback__userDataFree, callback__userData);
+}
+
+void Discord_Client_GetToken(Discord_Client* self, uint64_t applicationId, Discord_String code, Discord_String codeVerifier,
+                             Discord_String redirectUri, Discord_Client_TokenExchangeCallback callback,
+                             Discord_FreeFn callback__userDataFree, void* callback__userData) {
+    FakeClient* client = clientOf(self);
+    std::string issued = "access-" + toString(code);
+    std::lock_guard<std::mutex> lock(g_fakeMutex);
+    schedule(client, g_config.tokenLatencyMs, [issued, callback, callback__userDataFree, callback__userData]() {
+        Discord_ClientResult result = makeResult(FakeResult());
+        Discord_String access, refresh, scopes;
+        putString(&access, issued);
+        putString(&refresh, "refresh-" + issued);
+        putString(&scopes, "openid sdk.social_layer_presence");
+        callback(&result, access, refresh, Discord_AuthorizationTokenType_Bearer, 604800, scopes, callback__userData);
+        if (callback__userDataFree) callback__userDataFree(callback__userData);
+    }, [callback__userDataFree, callback__userData]() {
+        if (callback__userDataFree) callback__userDataFree(callback__userData);
+    });
+}
+
+void Discord_Client_ExchangeChildToken(Discord_Client* self, Discord_String parentApplicationToken, uint64_t childApplicationId,
+                                       Discord_Client_ExchangeChildTokenCallback callback, Discord_FreeFn callback__userDataFree,
+                                       void* callback__userData) {
+    FakeClient* client = clientOf(self);
+    std::string issued = "child-" + std::to_string(childApplicationId) + "-" + toString(parentApplicationToken);
+    std::lock_guard<std::mutex> lock(g_fakeMutex);
+    FakeResult outcome;
+    if (roll(g_config.childTokenFailRate)) {
+        outcome.type = Discord_ErrorType_HTTPError;
+        outcome.status = Discord_HttpStatusCode_Forbidden;
+        outcome.error = "application is not a child of the token's application";
+    }
+    schedule(client, g_config.tokenLatencyMs, [issued, outcome, callback, callback__userDataFree, callback__userData]() {
+        Discord_ClientResult result = makeResult(outcome);
+        Discord_String access, scopes;
+        putString(&access, outcome.type == Discord_ErrorType_None ? issued : "");
+        putString(&scopes, "openid sdk.social_layer_presence");
+        callback(&result, access, Discord_AuthorizationTokenType_Bearer, 604800, scopes, callback__userData);
+        if (callback__userDataFree) callback__userDataFree(callback__userData);
+    }, [callback__userDataFree, callback__userData]() {
+        if (callback__userDataFree) callback__userDataFree(callback__userData);
+    });
+}
+
+void Discord_Client_UpdateRichPresence(Discord_Client* self, Discord_Activity* activity, Discord_Client_UpdateRichPresenceCallback cb,
+                                       Discord_FreeFn cb__userDataFree, void* cb__userData) {
+    FakeClient* client = clientOf(self);
+    std::lock_guard<std::mutex> lock(g_fakeMutex);
+    g_stats.updates++;
+    FakeResult result;
+    int64_t now = nowMs();
+    if (client->status != Discord_Client_Status_Ready) {
+        g_stats.failed++;
+        scheduleResult(client, 0, notReady(), cb, cb__userDataFree, cb__userData);
+        return;
+    }
+    if (roll(g_config.disconnectRate)) scheduleDrop(client);
+
+    auto& recent = client->recentUpdates;
+    while (!recent.empty() && now - recent.front() >= g_config.rateLimitWindowMs) recent.pop_front();
+    if (g_config.rateLimitBurst > 0 && (int)recent.size() >= g_config.rateLimitBurst) {
+        g_stats.rateLimited++;
+        result.type = Discord_ErrorType_HTTPError;
+        result.status = Discord_HttpStatusCode_TooManyRequests;
+        result.error = "rate limited";
+        result.retryable = true;
+        result.retryAfter = (float)(g_config.rateLimitWindowMs - (now - recent.front())) / 1000.0f;
+    } else if (roll(g_config.failRate)) {
+        g_stats.failed++;
+        result.type = Discord_ErrorType_NetworkError;
+        result.error = "injected network error";
+        result.retryable = true;
+    } else {
+        g_stats.accepted++;
+        recent.push_back(now);
+        g_lastPresence = *activityOf(activity);
+    }
+    scheduleResult(client, g_config.updateLatencyMs, result, cb, cb__userDataFree, cb__userData);
+}
+
+void Discord_Client_ClearRichPresence(Discord_Client* self) {
+    std::lock_guard<std::mutex> lock(g_fakeMutex);
+    g_stats.clears++;
+    g_lastPresence.reset();
+}
+
+bool Discord_Client_GetCurrentUserV2(Discord_Client* self, Discord_UserHandle* returnValue) {
+    std::lock_guard<std::mutex> lock(g_fakeMutex);
+    if (clientOf(self)->status != Discord_Client_Status_Ready) return false;
+    returnValue->opaque = new FakeUser{80351110224678912, "fakeuser", "a_fakeavatarhash"};
+    return true;
+}
+
+// Empty until Ready, as the relationship list arrives with READY
+void Discord_Client_GetRelationships(Discord_Client* self, Discord_RelationshipHandleSpan* returnValue) {
+    std::lock_guard<std::mutex> lock(g_fakeMutex);
+    std::vector<const FakeRelationship*> friends;
+    if (clientOf(self)->status == Discord_Client_Status_Ready) {
+        for (const auto& relationship : g_relationships) {
+            if (relationship.type != Discord_RelationshipType_None) friends.push_back(&relationship);
+        }
+    }
+    returnValue->ptr = static_cast<Discord_RelationshipHandle*>(Discord_Alloc(sizeof(Discord_RelationshipHandle) * friends.size()));
+    returnValue->size = friends.size();
+    for (size_t i = 0; i < friends.size(); i++) returnValue->ptr[i].opaque = new FakeRelationship(*friends[i]);
+}
+
+void Discord_Client_GetRelationshipHandle(Discord_Client* self, uint64_t userId, Discord_RelationshipHandle* returnValue) {
+    std::lock_guard<std::mutex> lock(g_fakeMutex);
+    const FakeRelationship* relationship = findRelationship(userId);
+    returnValue->opaque = new FakeRelationship(relationship ? *relationship : FakeRelationship{userId});
+}
+
+// Verifier
+
+void Discord_AuthorizationCodeVerifier_Drop(Discord_AuthorizationCodeVerifier* self) {
+    delete static_cast<FakeVerifier*>(self->opaque);
+}
+
+void Discord_AuthorizationCodeVerifier_Clone(Discord_AuthorizationCodeVerifier* self, Discord_AuthorizationCodeVerifier const* arg0) {
+    self->opaque = new FakeVerifier(*static_cast<FakeVerifier*>(arg0->opaque));
+}
+
+void Discord_AuthorizationCodeVerifier_Verifier(Discord_AuthorizationCodeVerifier* self, Discord_String* returnValue) {
+    putString(returnValue, static_cast<FakeVerifier*>(self->opaque)->verifier);
+}
+
+// Activity and its parts
+
+void Discord_Activity_Init(Discord_Activity* self) { self->opaque = new FakeActivity(); }
+void Discord_Activity_Drop(Discord_Activity* self) { delete activityOf(self); }
+void Discord_Activity_Clone(Discord_Activity* self, Discord_Activity const* arg0) {
+    self->opaque = new FakeActivity(*static_cast<FakeActivity*>(arg0->opaque));
+}
+void Discord_Activity_SetName(Discord_Activity* self, Discord_String value) { activityOf(self)->name = toString(value); }
+void Discord_Activity_SetType(Discord_Activity* self, Discord_ActivityTypes value) { activityOf(self)->type = value; }
+void Discord_Activity_Name(Discord_Activity* self, Discord_String* returnValue) { putString(returnValue, activityOf(self)->name); }
+Discord_ActivityTypes Discord_Activity_Type(Discord_Activity* self) { return activityOf(self)->type; }
+bool Discord_Activity_Details(Discord_Activity* self, Discord_String* returnValue) {
+    if (!activityOf(self)->details) return false;
+    putString(returnValue, *activityOf(self)->details);
+    return true;
+}
+bool Discord_Activity_State(Discord_Activity* self, Discord_String* returnValue) {
+    if (!activityOf(self)->state) return false;
+    putString(returnValue, *activityOf(self)->state);
+    return true;
+}
+void Discord_Activity_SetStatusDisplayType(Discord_Activity* self, Discord_StatusDisplayTypes* value) {
+    activityOf(self)->displayType = value ? std::optional<Discord_StatusDisplayTypes>(*value) : std::nullopt;
+}
+void Discord_Activity_SetDetails(Discord_Activity* self, Discord_String* value) {
+    activityOf(self)->details = value ? std::optional<std::string>(toString(*value)) : std::nullopt;
+}
+void Discord_Activity_SetState(Discord_Activity* self, Discord_String* value) {
+    activityOf(self)->state = value ? std::optional<std::string>(toString(*value)) : std::nullopt;
+}
+void Discord_Activity_SetAssets(Discord_Activity* self, Discord_ActivityAssets* value) {
+    activityOf(self)->assets = value ? std::optional<FakeAssets>(*static_cast<FakeAssets*>(value->opaque)) : std::nullopt;
+}
+void Discord_Activity_SetTimestamps(Discord_Activity* self, Discord_ActivityTimestamps* value) {
+    activityOf(self)->timestamps = value ? std::optional<FakeTimestamps>(*static_cast<FakeTimestamps*>(value->opaque)) : std::nullopt;
+}
+
+void Discord_ActivityAssets_Init(Discord_ActivityAssets* self) { self->opaque = new FakeAssets(); }
+void Discord_ActivityAssets_Drop(Discord_ActivityAssets* self) { delete static_cast<FakeAssets*>(self->opaque); }
+void Discord_ActivityAssets_Clone(Discord_ActivityAssets* self, Discord_ActivityAssets const* arg0) {
+    self->opaque = new FakeAssets(*static_cast<FakeAssets*>(arg0->opaque));
+}
+void Discord_ActivityAssets_SetLargeImage(Discord_ActivityAssets* self, Discord_String* value) {
+    static_cast<FakeAssets*>(self->opaque)->largeImage = value ? toString(*value) : std::string();
+}
+void Discord_ActivityAssets_SetLargeText(Discord_ActivityAssets* self, Discord_String* value) {
+    static_cast<FakeAssets*>(self->opaque)->largeText = value ? toString(*value) : std::string();
+}
+
+void Discord_ActivityTimestamps_Init(Discord_ActivityTimestamps* self) { self->opaque = new FakeTimestamps(); }
+void Discord_ActivityTimestamps_Drop(Discord_ActivityTimestamps* self) { delete static_cast<FakeTimestamps*>(self->opaque); }
+void Discord_ActivityTimestamps_Clone(Discord_ActivityTimestamps* self, Discord_ActivityTimestamps const* arg0) {
+    self->opaque = new FakeTimestamps(*static_cast<FakeTimestamps*>(arg0->opaque));
+}
+void Discord_ActivityTimestamps_SetStart(Discord_ActivityTimestamps* self, uint64_t value) {
+    static_cast<FakeTimestamps*>(self->opaque)->start = value;
+}
+void Discord_ActivityTimestamps_SetEnd(Discord_ActivityTimestamps* self, uint64_t value) {
+    static_cast<FakeTimestamps*>(self->opaque)->end = value;
+}
+
+// ClientResult
+
+#define FAKE_RESULT(self) static_cast<FakeResult*>((self)->opaque)
+void Discord_ClientResult_Drop(Discord_ClientResult* self) { delete FAKE_RESULT(self); }
+void Discord_ClientResult_Clone(Discord_ClientResult* self, Discord_ClientResult const* arg0) {
+    self->opaque = new FakeResult(*FAKE_RESULT(arg0));
+}
+bool Discord_ClientResult_Successful(Discord_ClientResult* self) { return FAKE_RESULT(self)->type == Discord_ErrorType_None; }
+Discord_ErrorType Discord_ClientResult_Type(Discord_ClientResult* self) { return FAKE_RESULT(self)->type; }
+void Discord_ClientResult_Error(Discord_ClientResult* self, Discord_String* returnValue) { putString(returnValue, FAKE_RESULT(self)->error); }
+Discord_HttpStatusCode Discord_ClientResult_Status(Discord_ClientResult* self) { return FAKE_RESULT(self)->status; }
+bool Discord_ClientResult_Retryable(Discord_ClientResult* self) { return FAKE_RESULT(self)->retryable; }
+float Discord_ClientResult_RetryAfter(Discord_ClientResult* self) { return FAKE_RESULT(self)->retryAfter; }
+#undef FAKE_RESULT
+
+// RelationshipHandle
+
+#define FAKE_RELATIONSHIP(self) static_cast<FakeRelationship*>((self)->opaque)
+void Discord_RelationshipHandle_Drop(Discord_RelationshipHandle* self) { delete FAKE_RELATIONSHIP(self); }
+void Discord_RelationshipHandle_Clone(Discord_RelationshipHandle* self, Discord_RelationshipHandle const* arg0) {
+    self->opaque = new FakeRelationship(*FAKE_RELATIONSHIP(arg0));
+}
+uint64_t Discord_RelationshipHandle_Id(Discord_RelationshipHandle* self) { return FAKE_RELATIONSHIP(self)->id; }
+Discord_RelationshipType Discord_RelationshipHandle_DiscordRelationshipType(Discord_RelationshipHandle* self) {
+    return FAKE_RELATIONSHIP(self)->type;
+}
+Discord_RelationshipType Discord_RelationshipHandle_GameRelationshipType(Discord_RelationshipHandle* self) {
+    return Discord_RelationshipType_None;
+}
+bool Discord_RelationshipHandle_User(Discord_RelationshipHandle* self, Discord_UserHandle* returnValue) {
+    const auto& user = FAKE_RELATIONSHIP(self)->user;
+    if (!user) return false;
+    returnValue->opaque = new FakeUser(*user);
+    return true;
+}
+#undef FAKE_RELATIONSHIP
+
+// UserHandle
+
+void Discord_UserHandle_Drop(Discord_UserHandle* self) { delete static_cast<FakeUser*>(self->opaque); }
+void Discord_UserHandle_Clone(Discord_UserHandle* self, Discord_UserHandle const* arg0) {
+    self->opaque = new FakeUser(*static_cast<FakeUser*>(arg0->opaque));
+}
+uint64_t Discord_UserHandle_Id(Discord_UserHandle* self) { return static_cast<FakeUser*>(self->opaque)->id; }
+void Discord_UserHandle_Username(Discord_UserHandle* self, Discord_String* returnValue) {
+    putString(returnValue, static_cast<FakeUser*>(self->opaque)->username);
+}
+bool Discord_UserHandle_Avatar(Discord_UserHandle* self, Discord_String* returnValue) {
+    putString(returnValue, static_cast<FakeUser*>(self->opaque)->avatar);
+    return true;
+}
+bool Discord_UserHandle_GlobalName(Discord_UserHandle* self, Discord_String* returnValue) {
+    const auto& globalName = static_cast<FakeUser*>(self->opaque)->globalName;
+    if (!globalName) return false;
+    putString(returnValue, *globalName);
+    return true;
+}
+void Discord_UserHandle_DisplayName(Discord_UserHandle* self, Discord_String* returnValue) {
+    const FakeUser* user = static_cast<FakeUser*>(self->opaque);
+    putString(returnValue, user->globalName.value_or(user->username));
+}
+Discord_StatusType Discord_UserHandle_Status(Discord_UserHandle* self) { return static_cast<FakeUser*>(self->opaque)->status; }
+bool Discord_UserHandle_GameActivity(Discord_UserHandle* self, Discord_Activity* returnValue) {
+    const auto& activity = static_cast<FakeUser*>(self->opaque)->activity;
+    if (!activity) return false;
+    returnValue->opaque = new FakeActivity(*activity);
+    return true;
+}
+
+// discordpp.h keeps a static "nullobj" of every wrapper type, whose destructors
+// keep these referenced even after --gc-sections. None of them own anything here.
+#define FAKE_NOOP_DROP(Type) \
+    void Discord_##Type##_Drop(Discord_##Type* self) {}
+FAKE_NOOP_DROP(ActivityButton)
+FAKE_NOOP_DROP(ActivityInvite)
+FAKE_NOOP_DROP(ActivityParty)
+FAKE_NOOP_DROP(ActivitySecrets)
+FAKE_NOOP_DROP(AdditionalContent)
+FAKE_NOOP_DROP(AudioDevice)
+FAKE_NOOP_DROP(AuthorizationArgs)
+FAKE_NOOP_DROP(AuthorizationCodeChallenge)
+FAKE_NOOP_DROP(CallInfoHandle)
+FAKE_NOOP_DROP(Call)
+FAKE_NOOP_DROP(ChannelHandle)
+FAKE_NOOP_DROP(DeviceAuthorizationArgs)
+FAKE_NOOP_DROP(GuildChannel)
+FAKE_NOOP_DROP(GuildMinimal)
+FAKE_NOOP_DROP(LinkedChannel)
+FAKE_NOOP_DROP(LinkedLobby)
+FAKE_NOOP_DROP(LobbyHandle)
+FAKE_NOOP_DROP(LobbyMemberHandle)
+FAKE_NOOP_DROP(MessageHandle)
+FAKE_NOOP_DROP(UserApplicationProfileHandle)
+FAKE_NOOP_DROP(UserMessageSummary)
+FAKE_NOOP_DROP(VADThresholdSettings)
+FAKE_NOOP_DROP(VoiceStateHandle)
+#undef FAKE_NOOP_DROP
+
+} // extern "C"
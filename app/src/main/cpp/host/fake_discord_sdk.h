@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// In-process stand-in for the Discord partner SDK. It implements the part of
+// cdiscord.h the app uses (client create options/connect/status, token calls,
+// UpdateRichPresence/ClearRichPresence, Discord_RunCallbacks,
+// Discord_Alloc/Free, the Activity value types and a friends list with its
+// relationship and user-updated callbacks), so presence_core.cpp can
+// run unmodified on a Linux host. Callbacks are queued with simulated latency
+// and delivered from Discord_RunCallbacks, like the real SDK in its default
+// mode, or after Discord_SetFreeThreaded from a dispatcher thread of its own.
+//
+// Targets linking it are built with -ffunction-sections and --gc-sections, so
+// discordpp.h wrappers nobody calls are dropped along with their references to
+// the rest of the C API.
+
+struct FakeSdkConfig {
+    int connectLatencyMs = 50;    // Connect() until Ready
+    int tokenLatencyMs = 20;      // UpdateToken / GetToken round trip
+    int updateLatencyMs = 30;     // UpdateRichPresence / ClearRichPresence round trip
+    double failRate = 0;          // updates failing with a network error
+    int rateLimitBurst = 0;       // updates accepted per window, 0 = unlimited (Discord: 5 per 20 s)
+    int rateLimitWindowMs = 20000;
+    double disconnectRate = 0;    // chance per update of the gateway dropping
+    int reconnectMs = 500;        // Reconnecting until Ready again
+    double childTokenFailRate = 0; // ExchangeChildToken refusals (app not a linked child)
+    int friends = 0;              // in the signed-in user's relationship list
+    uint32_t seed = 1;
+};
+
+struct FakeSdkStats {
+    uint64_t updates;      // UpdateRichPresence calls
+    uint64_t accepted;
+    uint64_t failed;
+    uint64_t rateLimited;
+    uint64_t clears;
+    uint64_t callbacks;    // delivered by Discord_RunCallbacks
+    uint64_t readies;      // transitions to Ready
+    uint64_t disconnects;
+    uint64_t friendEvents; // relationship created/deleted and user-updated callbacks queued
+    uint64_t allocs;       // Discord_Alloc calls and bytes
+    uint64_t allocBytes;
+    uint64_t cpuAffinityMask;  // ClientCreateOptions of the last client created, 0 = none
+    int32_t threadPriority;    // last SetThreadPriority(Client, ...)
+};
+
+void fakeSdkConfigure(const FakeSdkConfig& config);
+FakeSdkStats fakeSdkStats();
+void fakeSdkResetStats();
+size_t fakeSdkQueuedCallbacks();
+
+// Drops every connected client with UnexpectedClose; they reconnect after reconnectMs
+void fakeSdkDropConnections();
+
+// Changes |count| random friends: most start or stop an activity or change
+// status (a user update), one in ten is unfriended or friended again (a
+// relationship deleted or created). Every Ready client is told.
+void fakeSdkChangeFriends(int count);
+
+// Details/state of the last presence the fake "server" accepted
+bool fakeSdkLastPresence(std::string* details, std::string* state);
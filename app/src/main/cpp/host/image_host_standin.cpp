@@ -0,0 +1,52 @@
+// Local stand-in for the cover-art image hosts.
+//
+//   image_host_standin [--port N] [--latency-ms N] [--jitter-ms N]
+//                      [--fail-rate F] [--stall-rate F] [--stall-ms N]
+//
+// Point a debug build's upload host list at http://<host-ip>:<port>/upload
+// (adb reverse tcp:<port> tcp:<port> works for a USB device) to test uploads
+// and failover with no network.
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+#include "standin_server.h"
+
+static volatile std::sig_atomic_t g_stop = 0;
+
+int main(int argc, char** argv) {
+    StandinProfile profile;
+    uint16_t port = 8089;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        const char* flag = argv[i];
+        const char* value = argv[i + 1];
+        if (!std::strcmp(flag, "--port")) port = (uint16_t)std::atoi(value);
+        else if (!std::strcmp(flag, "--latency-ms")) profile.latencyMs = std::atoi(value);
+        else if (!std::strcmp(flag, "--jitter-ms")) profile.jitterMs = std::atoi(value);
+        else if (!std::strcmp(flag, "--fail-rate")) profile.failRate = std::atof(value);
+        else if (!std::strcmp(flag, "--stall-rate")) profile.stallRate = std::atof(value);
+        else if (!std::strcmp(flag, "--stall-ms")) profile.stallMs = std::atoi(value);
+        else {
+            std::fprintf(stderr, "unknown flag %s\n", flag);
+            return 2;
+        }
+    }
+
+    StandinServer server(profile);
+    if (!server.start(port)) {
+        std::perror("bind");
+        return 1;
+    }
+    std::printf("image host stand-in listening on %s\n", server.url().c_str());
+    std::fflush(stdout);
+
+    std::signal(SIGINT, [](int) { g_stop = 1; });
+    std::signal(SIGTERM, [](int) { g_stop = 1; });
+    while (!g_stop) std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    server.stop();
+    std::printf("served %llu uploads, %llu bytes\n", (unsigned long long)server.served(), (unsigned long long)server.bytesReceived());
+    return 0;
+}
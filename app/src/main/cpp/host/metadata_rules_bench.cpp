@@ -0,0 +1,164 @@
+// Benchmarks every rule in metadata_rules.conf over a synthetic title corpus:
+// half the titles are generated from the rule's own pattern, half are
+// unrelated. Each rule is also run as the equivalent std::regex (what the
+// old Kotlin parser did per callback) as a baseline.
+//
+//   metadata_rules_bench [rules.conf] [--titles N]
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../metadata_rules.h"
+
+namespace {
+
+const char* kWords[] = {"The", "Night", "Of", "Breaking", "Bad", "Pilot", "Blue", "River", "Official", "Video",
+                        "Live", "At", "Wembley", "Remastered", "2011", "Part", "Two", "Chapter", "Dawn", "Echo"};
+
+std::string randomWords(std::mt19937& rng, int minWords, int maxWords) {
+    int count = std::uniform_int_distribution<int>(minWords, maxWords)(rng);
+    std::string out;
+    for (int i = 0; i < count; i++) {
+        if (i) out += ' ';
+        out += kWords[rng() % (sizeof(kWords) / sizeof(kWords[0]))];
+    }
+    return out;
+}
+
+std::string fromSpec(const std::string& spec, std::mt19937& rng) {
+    std::string out;
+    for (size_t i = 0; i < spec.size(); i++) {
+        char c = spec[i];
+        if (c == '#') {
+            int digits = 1 + rng() % 3;
+            for (int d = 0; d < digits; d++) out += (char)('0' + rng() % 10);
+        } else if (c == '@') {
+            int letters = 1 + rng() % 8;
+            for (int l = 0; l < letters; l++) out += (char)('a' + rng() % 26);
+        } else {
+            if (c == '\\' && i + 1 < spec.size()) c = spec[++i];
+            out += c;
+        }
+    }
+    return out;
+}
+
+std::string generate(const Rule& rule, std::mt19937& rng) {
+    std::string out;
+    for (const auto& seg : rule.segments) {
+        if (seg.kind == RuleSegment::Literal) out += seg.literal;
+        else if (seg.dfa >= 0) out += fromSpec(rule.dfas[seg.dfa].spec(), rng);
+        else out += randomWords(rng, 1, 4);
+    }
+    return out;
+}
+
+std::string escapeRegex(char c) {
+    if (std::strchr("\\^$.|?*+()[]{}", c)) return std::string("\\") + c;
+    return std::string(1, c);
+}
+
+std::string toRegex(const Rule& rule) {
+    std::string re;
+    for (const auto& seg : rule.segments) {
+        if (seg.kind == RuleSegment::Literal) {
+            for (char c : seg.literal) re += escapeRegex(c);
+        } else if (seg.dfa < 0) {
+            re += "(.*?)";
+        } else {
+            re += '(';
+            const std::string& spec = rule.dfas[seg.dfa].spec();
+            for (size_t i = 0; i < spec.size(); i++) {
+                char c = spec[i];
+                if (c == '#') re += "\\d+";
+                else if (c == '@') re += "[A-Za-z]+";
+                else {
+                    if (c == '\\' && i + 1 < spec.size()) c = spec[++i];
+                    re += escapeRegex(c);
+                }
+            }
+            re += ')';
+        }
+    }
+    return re;
+}
+
+template <typename F>
+double nsPerTitle(const std::vector<std::string>& corpus, int rounds, F&& body) {
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; r++) {
+        for (const auto& title : corpus) body(title);
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    return (double)elapsed / ((double)corpus.size() * rounds);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string path = DEFAULT_RULES_PATH;
+    int titles = 2000;
+    for (int i = 1; i < argc; i++) {
+        if (!std::strcmp(argv[i], "--titles") && i + 1 < argc) titles = std::atoi(argv[++i]);
+        else path = argv[i];
+    }
+
+    std::ifstream file(path);
+    if (!file) {
+        std::fprintf(stderr, "cannot open %s\n", path.c_str());
+        return 1;
+    }
+    std::stringstream text;
+    text << file.rdbuf();
+    MetadataRules rules;
+    std::string error;
+    if (!rules.load(text.str(), &error)) {
+        std::fprintf(stderr, "%s: %s\n", path.c_str(), error.c_str());
+        return 1;
+    }
+
+    auto set = rules.snapshot();
+    std::vector<std::pair<std::string, const Rule*>> all;
+    for (const auto& [package, list] : set->byPackage)
+        for (const auto& rule : list) all.emplace_back(package, &rule);
+    for (const auto& rule : set->wildcard) all.emplace_back("*", &rule);
+
+    std::printf("%-28s %-44s %7s %7s %10s %10s %8s\n", "package", "pattern", "titles", "match%", "rule ns", "regex ns", "speedup");
+    std::mt19937 rng(42);
+    for (const auto& [package, rule] : all) {
+        std::vector<std::string> corpus;
+        for (int i = 0; i < titles; i++) corpus.push_back(i % 2 ? generate(*rule, rng) : randomWords(rng, 2, 9));
+
+        std::regex re(toRegex(*rule));
+        int ruleMatches = 0, regexMatches = 0;
+        ParsedTitle parsed;
+        for (const auto& t : corpus) {
+            ruleMatches += MetadataRules::matchRule(*rule, t, "Artist", &parsed);
+            regexMatches += std::regex_match(t, re);
+        }
+        if (ruleMatches != regexMatches) {
+            std::fprintf(stderr, "%s: rule matched %d titles, regex %d\n", rule->pattern.c_str(), ruleMatches, regexMatches);
+        }
+
+        int rounds = std::max(1, 200000 / titles);
+        volatile int sink = 0;
+        double ruleNs = nsPerTitle(corpus, rounds, [&](const std::string& t) {
+            sink += MetadataRules::matchRule(*rule, t, "Artist", &parsed);
+        });
+        double regexNs = nsPerTitle(corpus, std::max(1, rounds / 10), [&](const std::string& t) {
+            std::smatch m;
+            sink += std::regex_match(t, m, re);
+        });
+        std::printf("%-28s %-44s %7d %6.1f%% %10.1f %10.1f %7.1fx\n", package.c_str(), rule->pattern.c_str(), titles,
+                    100.0 * ruleMatches / titles, ruleNs, regexNs, regexNs / ruleNs);
+    }
+    return 0;
+}
@@ -0,0 +1,499 @@
+// Micro-benchmarks for the presence path, from the strings JNI hands us to the
+// SDK callback: PendingActivity construction, discordpp::Activity build and
+// copy, UpdateRichPresence submit and callback dispatch against the fake SDK,
+// metrics registry writes, log ring records against formatting them in place,
+// the pump's timer wheel against an ordered multimap, the relationship store
+// at 5k friends and prefix search over it, plus JNI marshaling through an embedded JVM when one
+// was found at configure time (native_bench_jni.cpp).
+//
+//   native_bench [--filter SUBSTR] [--min-time SECONDS] [--json] [--compare OLD.jsonl]
+//
+// --json prints one result object per line; save it per commit and pass it to
+// --compare on a later run to see the change in each benchmark.
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <thread>
+
+#include "../friend_search.h"
+#include "../log_ring.h"
+#include "../metrics.h"
+#include "../presence_core.h"
+#include "../relationship_store.h"
+#include "../status_block.h"
+#include "../timer_wheel.h"
+#include "bench_harness.h"
+#include "fake_discord_sdk.h"
+#include "native_bench.h"
+
+namespace {
+
+volatile size_t g_sink;
+
+const char* kDetails = "Never Gonna Give You Up (Official Music Video)";
+const char* kState = "Rick Astley";
+const char* kImageKey = "https://files.catbox.moe/abc123.png";
+const char* kAppName = "YouTube Music";
+
+// A track 30 s in, so it isn't past its end (and expired on the pump) mid-run
+PendingActivity samplePending() {
+    long long now = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    return {kDetails, kState, kImageKey, kAppName, now - 30000, now + 183000, 2, 1, true};
+}
+
+void benchPendingConstruct(BenchState& state) {
+    for (int64_t i = 0; i < state.iterations; i++) {
+        // Same shape as the JNI entry point: four C strings and the scalars
+        PendingActivity activity{kDetails, kState, kImageKey, kAppName, 0, 0, 2, 1, false};
+        g_sink += activity.details.size();
+    }
+}
+
+void benchPendingSetDisconnected(BenchState& state) {
+    state.pause();
+    stopClient();
+    state.resume();
+    for (int64_t i = 0; i < state.iterations; i++) {
+        setPendingActivity(samplePending());
+    }
+}
+
+void benchActivityBuild(BenchState& state) {
+    PendingActivity pending = samplePending();
+    for (int64_t i = 0; i < state.iterations; i++) {
+        discordpp::Activity activity = buildActivity(pending);
+        g_sink += activity.Name().size();
+    }
+}
+
+void benchActivityCopy(BenchState& state) {
+    state.pause();
+    discordpp::Activity source = buildActivity(samplePending());
+    state.resume();
+    for (int64_t i = 0; i < state.iterations; i++) {
+        discordpp::Activity copy = source;
+        g_sink += copy.Type() == discordpp::ActivityTypes::Listening;
+    }
+}
+
+// Alternates two tracks: the same one twice is dropped once acknowledged
+void benchUpdateSubmit(BenchState& state) {
+    state.pause();
+    ensurePresenceClient();
+    PendingActivity pending[2] = {samplePending(), samplePending()};
+    pending[1].details += " (Live)";
+    state.resume();
+    for (int64_t i = 0; i < state.iterations; i++) {
+        setPendingActivity(pending[i & 1]);
+    }
+}
+
+void benchUpdateDeduped(BenchState& state) {
+    state.pause();
+    ensurePresenceClient();
+    PendingActivity pending = samplePending();
+    setPendingActivity(pending);
+    // Until the pump delivers the ack, it would still be sent
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    state.resume();
+    for (int64_t i = 0; i < state.iterations; i++) {
+        setPendingActivity(pending);
+    }
+}
+
+void benchCallbackDispatch(BenchState& state) {
+    state.pause();
+    // The core's callback thread would race us for RunCallbacks
+    stopClient();
+    static std::unique_ptr<discordpp::Client> client;
+    if (!client) {
+        client = std::make_unique<discordpp::Client>();
+        client->UpdateToken(discordpp::AuthorizationTokenType::Bearer, "bench-token", [](discordpp::ClientResult) {});
+        discordpp::RunCallbacks();
+        client->Connect();
+        while (client->GetStatus() != discordpp::Client::Status::Ready) discordpp::RunCallbacks();
+    }
+    discordpp::Activity activity = buildActivity(samplePending());
+
+    int64_t done = 0;
+    while (done < state.iterations) {
+        int64_t batch = std::min<int64_t>(256, state.iterations - done);
+        for (int64_t i = 0; i < batch; i++) {
+            client->UpdateRichPresence(activity, [](discordpp::ClientResult result) { g_sink += result.Successful(); });
+        }
+        state.resume();
+        discordpp::RunCallbacks();
+        state.pause();
+        done += batch;
+    }
+    state.resume();
+}
+
+// What the service's post costs, and what MainActivity pays per wakeup
+void benchStatusPublish(BenchState& state) {
+    PendingActivity pending = samplePending();
+    for (int64_t i = 0; i < state.iterations; i++) {
+        g_statusBlock.publishPresence(1, pending);
+    }
+    g_statusBlock.drainEvents();
+}
+
+void benchStatusRead(BenchState& state) {
+    state.pause();
+    g_statusBlock.publishPresence(1, samplePending());
+    StatusView view;
+    state.resume();
+    for (int64_t i = 0; i < state.iterations; i++) {
+        g_statusBlock.read(0, &view);
+        g_sink += view.details.size();
+    }
+}
+
+constexpr int kFriends = 5000;
+
+std::vector<FriendInfo> syntheticFriends(int count) {
+    std::vector<FriendInfo> friends(count);
+    for (int i = 0; i < count; i++) {
+        FriendInfo& info = friends[i];
+        info.userId = 500000000000000000ull + (uint64_t)i * 7919;
+        info.username = "friend" + std::to_string(i);
+        info.displayName = "Friend " + std::to_string(i);
+        info.status = i % 3 == 0 ? 1 : 0;
+        if (i % 4 == 0) {
+            info.activityType = 2;
+            info.activityName = "Music";
+            info.details = kDetails;
+            info.state = kState;
+        }
+    }
+    return friends;
+}
+
+// A user update that changed nothing the store keeps: the common case, since
+// the SDK reports avatars, flags and other fields through it too
+void benchFriendsUpsertUnchanged(BenchState& state) {
+    state.pause();
+    RelationshipStore store;
+    std::vector<FriendInfo> friends = syntheticFriends(kFriends);
+    store.replaceAll(friends);
+    state.resume();
+    for (int64_t i = 0; i < state.iterations; i++) {
+        g_sink += store.upsert(friends[i % kFriends]);
+    }
+}
+
+void benchFriendsUpsertChanged(BenchState& state) {
+    state.pause();
+    RelationshipStore store;
+    std::vector<FriendInfo> friends = syntheticFriends(kFriends);
+    store.replaceAll(friends);
+    state.resume();
+    for (int64_t i = 0; i < state.iterations; i++) {
+        FriendInfo& info = friends[i % kFriends];
+        info.status = info.status ? 0 : 1;
+        g_sink += store.upsert(info);
+        // What a publish would do every so often, so the arena doesn't grow unbounded
+        if (i % 1024 == 1023) store.publish();
+    }
+}
+
+// One friend changed, then the snapshot the pump timer publishes
+void benchFriendsPublish(BenchState& state) {
+    state.pause();
+    RelationshipStore store;
+    std::vector<FriendInfo> friends = syntheticFriends(kFriends);
+    store.replaceAll(friends);
+    state.resume();
+    for (int64_t i = 0; i < state.iterations; i++) {
+        FriendInfo& info = friends[i % kFriends];
+        info.status = info.status ? 0 : 1;
+        store.upsert(info);
+        store.publish();
+    }
+}
+
+// The UI's side of that: what moved since the version it holds
+void benchFriendsChangesSince(BenchState& state) {
+    state.pause();
+    RelationshipStore store;
+    std::vector<FriendInfo> friends = syntheticFriends(kFriends);
+    store.replaceAll(friends);
+    store.publish();
+    friends[kFriends / 2].details = "Another Track";
+    store.upsert(friends[kFriends / 2]);
+    store.publish();
+    auto snapshot = store.snapshot();
+    std::vector<const FriendRow*> changed;
+    std::vector<uint64_t> removed;
+    state.resume();
+    for (int64_t i = 0; i < state.iterations; i++) {
+        changed.clear();
+        snapshot->changesSince(snapshot->version - 1, &changed, &removed);
+        g_sink += changed.size();
+    }
+}
+
+// Search as you type over 5k friends: each keystroke is one query
+void benchFriendsSearch(BenchState& state, const char* prefix) {
+    state.pause();
+    FriendSearchIndex index;
+    index.replaceAll(syntheticFriends(kFriends));
+    std::vector<uint64_t> results;
+    results.reserve(8);
+    state.resume();
+    for (int64_t i = 0; i < state.iterations; i++) {
+        results.clear();
+        index.search(prefix, 8, &results);
+        g_sink += results.size();
+    }
+}
+
+// The same query answered by scanning every friend's names, as filtering the
+// list without an index would
+void benchFriendsSearchScan(BenchState& state) {
+    state.pause();
+    std::vector<FriendInfo> friends = syntheticFriends(kFriends);
+    std::vector<uint64_t> results;
+    results.reserve(8);
+    const std::string prefix = "friend 12";
+    auto matches = [&prefix](const std::string& name) {
+        return name.size() >= prefix.size() && std::equal(prefix.begin(), prefix.end(), name.begin(), [](char a, char b) {
+            return a == (b >= 'A' && b <= 'Z' ? (char)(b - 'A' + 'a') : b);
+        });
+    };
+    state.resume();
+    for (int64_t i = 0; i < state.iterations; i++) {
+        results.clear();
+        for (const FriendInfo& info : friends) {
+            if (matches(info.displayName) || matches(info.username)) results.push_back(info.userId);
+        }
+        g_sink += results.size();
+    }
+}
+
+// A friend renamed: their keys erased and reinserted in the sorted index
+void benchFriendsSearchUpdate(BenchState& state) {
+    state.pause();
+    FriendSearchIndex index;
+    std::vector<FriendInfo> friends = syntheticFriends(kFriends);
+    index.replaceAll(friends);
+    state.resume();
+    for (int64_t i = 0; i < state.iterations; i++) {
+        FriendInfo& info = friends[i % kFriends];
+        info.displayName[0] = info.displayName[0] == 'F' ? 'P' : 'F';
+        g_sink += index.update(info);
+    }
+}
+
+// Reconnects after renames, to a list that has shrunk meanwhile: the reload
+// starts a fresh arena smaller than the garbage the renames left in the old one
+void benchFriendsSearchReload(BenchState& state) {
+    state.pause();
+    FriendSearchIndex index;
+    std::vector<FriendInfo> friends = syntheticFriends(10);
+    std::vector<FriendInfo> shrunk(friends.begin(), friends.begin() + 1);
+    state.resume();
+    for (int64_t i = 0; i < state.iterations; i++) {
+        index.replaceAll(friends);
+        for (int renamed = 0; renamed < 4; renamed++) {
+            FriendInfo& info = friends[renamed];
+            info.displayName[0] = info.displayName[0] == 'F' ? 'P' : 'F';
+            index.update(info);
+        }
+        index.replaceAll(shrunk);
+    }
+    g_sink += index.keys();
+}
+
+void benchFriendsSearchBuild(BenchState& state) {
+    state.pause();
+    FriendSearchIndex index;
+    std::vector<FriendInfo> friends = syntheticFriends(kFriends);
+    state.resume();
+    for (int64_t i = 0; i < state.iterations; i++) {
+        index.replaceAll(friends);
+    }
+}
+
+void benchMetricsAdd(BenchState& state) {
+    for (int64_t i = 0; i < state.iterations; i++) {
+        g_metrics.add(Counter::CallbackWakeups);
+    }
+}
+
+void benchMetricsRecord(BenchState& state) {
+    for (int64_t i = 0; i < state.iterations; i++) {
+        g_metrics.record(Histogram::PresenceAckMs, (uint64_t)i & 1023);
+    }
+}
+
+void benchLogRing(BenchState& state) {
+    state.pause();
+    g_logRing.setRateLimit(0);
+    state.resume();
+    // Batches of half the ring, drained while paused, so no record is dropped
+    int64_t done = 0;
+    while (done < state.iterations) {
+        int64_t batch = std::min<int64_t>(LogRing::kCapacity / 2, state.iterations - done);
+        for (int64_t i = 0; i < batch; i++) {
+            RLOGI("Pending Rich Presence: App=%s, Type=%d, Display=%d", kAppName, 2, (int)i);
+        }
+        done += batch;
+        state.pause();
+        g_logRing.flush();
+        state.resume();
+    }
+}
+
+// Deadlines a pump might hold: a few per level of the wheel
+constexpr int64_t kTimerDelaysMs[] = {5, 40, 300, 2000, 30000, 300000, 3600000};
+
+void benchWheelScheduleCancel(BenchState& state) {
+    state.pause();
+    TimerWheel wheel;
+    for (int i = 0; i < 1000; i++) wheel.schedule(0, kTimerDelaysMs[i % 7] + i, [] {});
+    state.resume();
+    for (int64_t i = 0; i < state.iterations; i++) {
+        wheel.cancel(wheel.schedule(0, kTimerDelaysMs[i % 7], [] {}));
+    }
+}
+
+void benchMultimapScheduleCancel(BenchState& state) {
+    state.pause();
+    std::multimap<int64_t, std::function<void()>> timers;
+    for (int i = 0; i < 1000; i++) timers.emplace(kTimerDelaysMs[i % 7] + i, [] {});
+    state.resume();
+    for (int64_t i = 0; i < state.iterations; i++) {
+        timers.erase(timers.emplace(kTimerDelaysMs[i % 7], [] {}));
+    }
+}
+
+// Steady state: one timer due every millisecond, the clock moving 1 ms per op
+void benchWheelScheduleFire(BenchState& state) {
+    TimerWheel wheel;
+    for (int64_t i = 0; i < state.iterations; i++) {
+        wheel.schedule(i, kTimerDelaysMs[i % 3], [] { g_sink++; });
+        wheel.advance(i);
+    }
+}
+
+void benchLogFormat(BenchState& state) {
+    // What LOGI does on the caller's thread before the logcat write
+    char buffer[512];
+    for (int64_t i = 0; i < state.iterations; i++) {
+        g_sink += std::snprintf(buffer, sizeof(buffer), "Pending Rich Presence: App=%s, Type=%d, Display=%d", kAppName, 2, (int)i);
+    }
+}
+
+std::map<std::string, BenchResult> loadBaseline(const char* path) {
+    std::map<std::string, BenchResult> baseline;
+    std::ifstream file(path);
+    std::string line;
+    while (std::getline(file, line)) {
+        BenchResult r;
+        if (fromJson(line, &r)) baseline[r.name] = r;
+    }
+    return baseline;
+}
+
+} // namespace
+
+#ifndef NATIVE_BENCH_JNI
+void registerJniBenchmarks(std::vector<Benchmark>*) {
+    std::fprintf(stderr, "No JDK found at configure time, skipping jni/* benchmarks\n");
+}
+#endif
+
+void ensurePresenceClient() {
+    if (g_running && g_connected) return;
+    startClient(1, nullptr);
+    restoreToken("bench-token");
+    while (!g_connected) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+}
+
+int main(int argc, char** argv) {
+    const char* filter = nullptr;
+    const char* comparePath = nullptr;
+    double minSeconds = 0.3;
+    bool json = false;
+    for (int i = 1; i < argc; i++) {
+        if (!std::strcmp(argv[i], "--filter") && i + 1 < argc) filter = argv[++i];
+        else if (!std::strcmp(argv[i], "--min-time") && i + 1 < argc) minSeconds = std::atof(argv[++i]);
+        else if (!std::strcmp(argv[i], "--compare") && i + 1 < argc) comparePath = argv[++i];
+        else if (!std::strcmp(argv[i], "--json")) json = true;
+        else {
+            std::fprintf(stderr, "unknown argument %s\n", argv[i]);
+            return 2;
+        }
+    }
+
+    FakeSdkConfig config;
+    config.connectLatencyMs = 0;
+    config.tokenLatencyMs = 0;
+    config.updateLatencyMs = 0;
+    fakeSdkConfigure(config);
+    g_extraAllocs = []() {
+        FakeSdkStats stats = fakeSdkStats();
+        return AllocSample{stats.allocs, stats.allocBytes};
+    };
+
+    std::vector<Benchmark> benchmarks = {
+        {"pending_activity/construct", benchPendingConstruct},
+        {"pending_activity/set_disconnected", benchPendingSetDisconnected},
+        {"activity/build", benchActivityBuild},
+        {"activity/copy", benchActivityCopy},
+        {"presence/update_submit", benchUpdateSubmit},
+        {"presence/update_deduped", benchUpdateDeduped},
+        {"status/block_publish", benchStatusPublish},
+        {"status/block_read", benchStatusRead},
+        {"friends/upsert_unchanged", benchFriendsUpsertUnchanged},
+        {"friends/upsert_changed", benchFriendsUpsertChanged},
+        {"friends/publish_5k", benchFriendsPublish},
+        {"friends/changes_since_5k", benchFriendsChangesSince},
+        {"friends/search_1_char", [](BenchState& state) { benchFriendsSearch(state, "f"); }},
+        {"friends/search_9_chars", [](BenchState& state) { benchFriendsSearch(state, "friend 12"); }},
+        {"friends/search_no_match", [](BenchState& state) { benchFriendsSearch(state, "zz"); }},
+        {"friends/search_linear_scan", benchFriendsSearchScan},
+        {"friends/search_update", benchFriendsSearchUpdate},
+        {"friends/search_build_5k", benchFriendsSearchBuild},
+        {"friends/search_reload_shrunk", benchFriendsSearchReload},
+        {"metrics/counter_add", benchMetricsAdd},
+        {"metrics/histogram_record", benchMetricsRecord},
+        {"log/ring_record", benchLogRing},
+        {"log/snprintf_only", benchLogFormat},
+        {"timers/wheel_schedule_cancel", benchWheelScheduleCancel},
+        {"timers/multimap_schedule_cancel", benchMultimapScheduleCancel},
+        {"timers/wheel_schedule_fire", benchWheelScheduleFire},
+    };
+    registerJniBenchmarks(&benchmarks);
+    // Last: it stops the core client so it can own RunCallbacks
+    benchmarks.push_back({"sdk/callback_dispatch", benchCallbackDispatch});
+
+    std::map<std::string, BenchResult> baseline;
+    if (comparePath) baseline = loadBaseline(comparePath);
+
+    BenchRunner runner(minSeconds);
+    if (!json) std::printf("%-36s %12s %12s %10s %10s\n", "benchmark", "iterations", "ns/op", "allocs/op", "bytes/op");
+    for (const auto& benchmark : benchmarks) {
+        if (filter && benchmark.name.find(filter) == std::string::npos) continue;
+        BenchResult r = runner.run(benchmark);
+        if (json) {
+            std::printf("%s\n", toJson(r).c_str());
+            continue;
+        }
+        std::printf("%-36s %12lld %12.1f %10.2f %10.1f", r.name.c_str(), (long long)r.iterations, r.nsPerOp, r.allocsPerOp, r.bytesPerOp);
+        auto old = baseline.find(r.name);
+        if (old != baseline.end() && old->second.nsPerOp > 0) {
+            std::printf("   %+6.1f%% ns, %+.2f allocs", 100.0 * (r.nsPerOp - old->second.nsPerOp) / old->second.nsPerOp,
+                        r.allocsPerOp - old->second.allocsPerOp);
+        }
+        std::printf("\n");
+    }
+    stopClient();
+    return 0;
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <vector>
+
+#include "bench_harness.h"
+
+// Starts the presence core on the fake SDK and waits for Ready
+void ensurePresenceClient();
+
+// jni/* benchmarks (native_bench_jni.cpp), only built when CMake found a JDK
+void registerJniBenchmarks(std::vector<Benchmark>* out);
@@ -0,0 +1,81 @@
+// jni/* benchmarks: creates an embedded JVM and measures string marshaling the
+// way main.cpp does it, then calls the real JNI entry points with that env.
+#include <jni.h>
+
+#include <cstdio>
+#include <string>
+
+#include "../label_cache.h"
+#include "native_bench.h"
+
+extern "C" {
+JNIEXPORT void JNICALL Java_com_thepotato_discordrpc_DiscordGateway_updateRichPresence(
+    JNIEnv* env, jobject thiz, jint jlabelId, jstring jdetails, jstring jstate, jstring jimageKey, jint jtype, jint jStatusDisplayType,
+    jlong japplicationId);
+JNIEXPORT jobjectArray JNICALL Java_com_thepotato_discordrpc_DiscordGateway_parseMetadata(
+    JNIEnv* env, jobject thiz, jstring jpackage, jstring jtitle, jstring jartist);
+}
+
+namespace {
+
+JavaVM* g_vm = nullptr;
+JNIEnv* g_env = nullptr;
+volatile size_t g_sink;
+
+jstring make(const char* text) {
+    return (jstring)g_env->NewGlobalRef(g_env->NewStringUTF(text));
+}
+
+} // namespace
+
+void registerJniBenchmarks(std::vector<Benchmark>* out) {
+    JavaVMInitArgs args{};
+    args.version = JNI_VERSION_1_8;
+    args.ignoreUnrecognized = JNI_TRUE;
+    if (JNI_CreateJavaVM(&g_vm, (void**)&g_env, &args) != JNI_OK) {
+        std::fprintf(stderr, "JNI_CreateJavaVM failed, skipping jni/* benchmarks\n");
+        return;
+    }
+
+    static jstring details = make("Never Gonna Give You Up (Official Music Video)");
+    static jstring state = make("Rick Astley");
+    static jstring imageKey = make("https://files.catbox.moe/abc123.png");
+    static jstring package = make("com.google.android.youtube");
+
+    out->push_back({"jni/get_string_utf_chars", [](BenchState& s) {
+        for (int64_t i = 0; i < s.iterations; i++) {
+            const char* chars = g_env->GetStringUTFChars(details, nullptr);
+            g_sink += chars[0];
+            g_env->ReleaseStringUTFChars(details, chars);
+        }
+    }});
+    out->push_back({"jni/to_std_string", [](BenchState& s) {
+        for (int64_t i = 0; i < s.iterations; i++) {
+            const char* chars = g_env->GetStringUTFChars(details, nullptr);
+            std::string copy(chars);
+            g_env->ReleaseStringUTFChars(details, chars);
+            g_sink += copy.size();
+        }
+    }});
+    out->push_back({"jni/new_string_utf", [](BenchState& s) {
+        for (int64_t i = 0; i < s.iterations; i++) {
+            jstring text = g_env->NewStringUTF("Never Gonna Give You Up (Official Music Video)");
+            g_env->DeleteLocalRef(text);
+        }
+    }});
+    out->push_back({"jni/update_rich_presence", [](BenchState& s) {
+        s.pause();
+        ensurePresenceClient();
+        int32_t labelId = g_labelCache.put("com.google.android.apps.youtube.music", "YouTube Music");
+        s.resume();
+        for (int64_t i = 0; i < s.iterations; i++) {
+            Java_com_thepotato_discordrpc_DiscordGateway_updateRichPresence(g_env, nullptr, labelId, details, state, imageKey, 2, 1, 0);
+        }
+    }});
+    out->push_back({"jni/parse_metadata", [](BenchState& s) {
+        for (int64_t i = 0; i < s.iterations; i++) {
+            jobjectArray result = Java_com_thepotato_discordrpc_DiscordGateway_parseMetadata(g_env, nullptr, package, details, state);
+            if (result) g_env->DeleteLocalRef(result);
+        }
+    }});
+}
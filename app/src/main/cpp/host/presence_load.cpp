@@ -0,0 +1,479 @@
+// Drives presence_core.cpp (the code behind the JNI entry points) against the
+// fake SDK: restores a session, waits for Ready, then pushes presence updates
+// at a target rate and reports what the core and the fake gateway saw.
+//
+//   presence_load [--rate N] [--seconds S] [--update-ms N] [--connect-ms N]
+//                 [--fail-rate F] [--rate-limit N] [--window-ms N]
+//                 [--disconnect-rate F] [--reconnect-ms N] [--journal PATH]
+//                 [--swap-ms N] [--pool N] [--child-fail-rate F]
+//                 [--profile battery_saver|balanced|low_latency]
+//                 [--free-threaded 0|1] [--probes N] [--idle-seconds S]
+//                 [--looper 0|1] [--friends N] [--friend-churn N]
+//
+// --rate 0 submits as fast as the core accepts them. With --journal, a second
+// run on the same file reports the presence restored from it on Ready, as
+// after the app's process is killed; --seconds 0 stops right there. --swap-ms
+// switches the client to another application id that often mid-load, as
+// initDiscord does when the client id changes, and reports what the switch
+// cost the calling thread. --pool spreads the updates over N more application
+// ids, served by the client pool, and reports what each pooled client costs.
+// Every run ends with the asynchronous shutdown shutdownDiscord uses, timed.
+// --profile picks the scheduling profile of the pump and SDK threads; compare
+// the CPU time runs with each report.
+//
+// --free-threaded 1 runs the SDK free-threaded, callbacks handed to the pump
+// as posted work instead of polled every 16 ms. Compare a run with and one
+// without, e.g. --rate 100 --seconds 2 --probes 50 --idle-seconds 5: --probes
+// sends N updates one at a time after the load and times each until its
+// result reached the core; --idle-seconds then sits connected with nothing to
+// send and reports the pump wakeups and process CPU time that costs.
+// --looper 1 runs the pump from an epoll loop over an eventfd and a timerfd,
+// the way looper_pump.cpp does from the service's Looper on a device.
+//
+// --friends gives the signed-in user N friends and --friend-churn changes that
+// many of them per second during the load; a reader thread follows the
+// relationship store's snapshots the way the UI does, applying only what
+// changed and searching the friend index as it goes, and the report says
+// whether it ended up matching the store.
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include "../client_pool.h"
+#include "../friend_search.h"
+#include "../metrics.h"
+#include "../presence_core.h"
+#include "../presence_journal.h"
+#include "../relationship_store.h"
+#include "../sched_policy.h"
+#include "../startup_timeline.h"
+#include "fake_discord_sdk.h"
+
+namespace {
+
+double percentile(std::vector<double>& samples, double p) {
+    if (samples.empty()) return 0;
+    size_t k = std::min(samples.size() - 1, (size_t)(p * samples.size()));
+    std::nth_element(samples.begin(), samples.begin() + k, samples.end());
+    return samples[k];
+}
+
+int64_t processCpuNowUs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+// A Looper stand-in: one thread polling a wake eventfd, a timerfd and a stop
+// eventfd, running the pump through the same driver API as LooperPump
+class HostLooper {
+public:
+    void start() {
+        wakeFd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        stopFd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        timerFd_ = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        std::atomic<bool> attached{false};
+        thread_ = std::thread([this, &attached] {
+            int wakeFd = wakeFd_;
+            attachPumpDriver({[wakeFd]() {
+                uint64_t one = 1;
+                (void)write(wakeFd, &one, sizeof(one));
+            }});
+            attached = true;
+            loop();
+            detachPumpDriver();
+        });
+        while (!attached) std::this_thread::yield();
+    }
+
+    void stop() {
+        uint64_t one = 1;
+        (void)write(stopFd_, &one, sizeof(one));
+        thread_.join();
+        close(wakeFd_);
+        close(stopFd_);
+        close(timerFd_);
+    }
+
+private:
+    void loop() {
+        int epoll = epoll_create1(EPOLL_CLOEXEC);
+        for (int fd : {wakeFd_, stopFd_, timerFd_}) {
+            epoll_event event = {};
+            event.events = EPOLLIN;
+            event.data.fd = fd;
+            epoll_ctl(epoll, EPOLL_CTL_ADD, fd, &event);
+        }
+        while (true) {
+            epoll_event events[3];
+            int n = epoll_wait(epoll, events, 3, -1);
+            bool run = false;
+            for (int i = 0; i < n; i++) {
+                uint64_t count;
+                (void)read(events[i].data.fd, &count, sizeof(count));
+                if (events[i].data.fd == stopFd_) {
+                    close(epoll);
+                    return;
+                }
+                run = true;
+            }
+            if (!run) continue;
+            auto next = runDrivenPump();
+            itimerspec spec = {};
+            if (next != std::chrono::steady_clock::time_point::max()) {
+                auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(next.time_since_epoch()).count();
+                if (ns <= 0) ns = 1;
+                spec.it_value.tv_sec = ns / 1000000000;
+                spec.it_value.tv_nsec = ns % 1000000000;
+            }
+            timerfd_settime(timerFd_, TFD_TIMER_ABSTIME, &spec, nullptr);
+        }
+    }
+
+    std::thread thread_;
+    int wakeFd_ = -1;
+    int stopFd_ = -1;
+    int timerFd_ = -1;
+};
+
+// What the UI keeps of the friends list, brought up to date from each
+// snapshot's changes since the version it last applied
+class FriendsMirror {
+public:
+    void start() {
+        thread_ = std::thread([this] {
+            while (!stop_) {
+                poll();
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            }
+        });
+    }
+    void stop() {
+        stop_ = true;
+        if (thread_.joinable()) thread_.join();
+    }
+
+    void poll() {
+        // A keystroke's worth of search against the index the pump is updating
+        std::vector<uint64_t> found;
+        g_friendSearch.search("friend 1", 8, &found);
+        searchHits_ += found.size();
+        auto snapshot = g_relationshipStore.snapshot();
+        if (!snapshot || snapshot->version == version_) return;
+        std::vector<const FriendRow*> changed;
+        std::vector<uint64_t> removed;
+        if (snapshot->changesSince(version_, &changed, &removed)) {
+            rows_.clear();
+            fullRefreshes_++;
+        }
+        for (uint64_t userId : removed) rows_.erase(userId);
+        for (const FriendRow* row : changed) rows_[row->userId] = describe(*snapshot, *row);
+        rowsApplied_ += changed.size() + removed.size();
+        version_ = snapshot->version;
+    }
+
+    bool matches(const RelationshipSnapshot& snapshot) const {
+        if (rows_.size() != snapshot.rows.size()) return false;
+        for (const FriendRow& row : snapshot.rows) {
+            auto it = rows_.find(row.userId);
+            if (it == rows_.end() || it->second != describe(snapshot, row)) return false;
+        }
+        return true;
+    }
+
+    uint64_t rowsApplied() const { return rowsApplied_; }
+    uint64_t fullRefreshes() const { return fullRefreshes_; }
+    uint64_t searchHits() const { return searchHits_; }
+
+private:
+    static std::string describe(const RelationshipSnapshot& snapshot, const FriendRow& row) {
+        std::string text(snapshot.textOf(row.displayName));
+        for (TextRef ref : {row.username, row.activityName, row.details, row.state}) {
+            text += '\n';
+            text += snapshot.textOf(ref);
+        }
+        return text + '\n' + std::to_string(row.status) + '/' + std::to_string(row.activityType);
+    }
+
+    std::thread thread_;
+    std::atomic<bool> stop_{false};
+    uint64_t version_ = 0;
+    std::map<uint64_t, std::string> rows_;
+    uint64_t rowsApplied_ = 0;
+    uint64_t fullRefreshes_ = 0;
+    uint64_t searchHits_ = 0;
+};
+
+} // namespace
+
+int main(int argc, char** argv) {
+    FakeSdkConfig config;
+    double rate = 1000;
+    double seconds = 3;
+    const char* journalPath = nullptr;
+    int swapMs = 0;
+    int poolApps = 0;
+    SchedProfile profile = SchedProfile::Balanced;
+    bool freeThreaded = false;
+    bool looper = false;
+    int probes = 0;
+    double idleSeconds = 0;
+    int friendChurn = 0;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        const char* flag = argv[i];
+        const char* value = argv[i + 1];
+        if (!std::strcmp(flag, "--rate")) rate = std::atof(value);
+        else if (!std::strcmp(flag, "--seconds")) seconds = std::atof(value);
+        else if (!std::strcmp(flag, "--update-ms")) config.updateLatencyMs = std::atoi(value);
+        else if (!std::strcmp(flag, "--connect-ms")) config.connectLatencyMs = std::atoi(value);
+        else if (!std::strcmp(flag, "--fail-rate")) config.failRate = std::atof(value);
+        else if (!std::strcmp(flag, "--rate-limit")) config.rateLimitBurst = std::atoi(value);
+        else if (!std::strcmp(flag, "--window-ms")) config.rateLimitWindowMs = std::atoi(value);
+        else if (!std::strcmp(flag, "--disconnect-rate")) config.disconnectRate = std::atof(value);
+        else if (!std::strcmp(flag, "--reconnect-ms")) config.reconnectMs = std::atoi(value);
+        else if (!std::strcmp(flag, "--journal")) journalPath = value;
+        else if (!std::strcmp(flag, "--swap-ms")) swapMs = std::atoi(value);
+        else if (!std::strcmp(flag, "--pool")) poolApps = std::atoi(value);
+        else if (!std::strcmp(flag, "--child-fail-rate")) config.childTokenFailRate = std::atof(value);
+        else if (!std::strcmp(flag, "--free-threaded")) freeThreaded = std::atoi(value) != 0;
+        else if (!std::strcmp(flag, "--probes")) probes = std::atoi(value);
+        else if (!std::strcmp(flag, "--looper")) looper = std::atoi(value) != 0;
+        else if (!std::strcmp(flag, "--idle-seconds")) idleSeconds = std::atof(value);
+        else if (!std::strcmp(flag, "--friends")) config.friends = std::atoi(value);
+        else if (!std::strcmp(flag, "--friend-churn")) friendChurn = std::atoi(value);
+        else if (!std::strcmp(flag, "--profile")) {
+            profile = SchedProfile::Count;
+            for (int32_t p = 0; p < (int32_t)SchedProfile::Count; p++) {
+                if (!std::strcmp(value, SchedPolicy::name((SchedProfile)p))) profile = (SchedProfile)p;
+            }
+            if (profile == SchedProfile::Count) {
+                std::fprintf(stderr, "unknown profile %s\n", value);
+                return 2;
+            }
+        }
+        else {
+            std::fprintf(stderr, "unknown flag %s\n", flag);
+            return 2;
+        }
+    }
+    fakeSdkConfigure(config);
+    setSchedProfile(profile);
+    if (freeThreaded) enableFreeThreaded();
+    HostLooper hostLooper;
+    if (looper) hostLooper.start();
+    FriendsMirror friendsMirror;
+    if (config.friends > 0) friendsMirror.start();
+    if (journalPath) {
+        std::string error;
+        if (!g_presenceJournal.open(journalPath, &error)) {
+            std::fprintf(stderr, "journal: %s\n", error.c_str());
+            return 1;
+        }
+    }
+
+    constexpr uint64_t kApplicationId = 1435558259892293662;
+    std::atomic<int> readies{0};
+    auto onReady = [&]() { readies++; };
+    auto connectStart = std::chrono::steady_clock::now();
+    startClient(kApplicationId, onReady);
+    restoreToken("fake-access-token");
+    while (!g_connected) {
+        if (std::chrono::steady_clock::now() - connectStart > std::chrono::seconds(10)) {
+            std::fprintf(stderr, "client never became ready\n");
+            return 1;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    double connectMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - connectStart).count();
+    if (journalPath) {
+        // The restored update is submitted from the Ready callback; give its result time to land
+        std::this_thread::sleep_for(std::chrono::milliseconds(config.updateLatencyMs + 50));
+        std::string details, state;
+        if (fakeSdkLastPresence(&details, &state)) {
+            std::printf("restored from journal   %s / %s\n", details.c_str(), state.c_str());
+        } else {
+            std::printf("restored from journal   (nothing current)\n");
+        }
+    }
+    fakeSdkResetStats();
+
+    std::vector<double> callNs;
+    std::vector<double> swapNs;
+    uint64_t submitted = 0;
+    auto start = std::chrono::steady_clock::now();
+    auto end = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(seconds));
+    auto interval = rate > 0 ? std::chrono::duration<double>(1.0 / rate) : std::chrono::duration<double>(0);
+    auto next = start;
+    auto nextSwap = start + std::chrono::milliseconds(swapMs);
+    auto nextChurn = start;
+    while (true) {
+        auto now = std::chrono::steady_clock::now();
+        if (now >= end) break;
+        if (friendChurn > 0 && now >= nextChurn) {
+            fakeSdkChangeFriends(std::max(friendChurn / 10, 1));
+            nextChurn += std::chrono::milliseconds(100);
+        }
+        if (swapMs > 0 && now >= nextSwap) {
+            startClient(kApplicationId + (swapNs.size() % 2 == 0 ? 1 : 0), onReady);
+            restoreToken("fake-access-token");
+            swapNs.push_back(std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - now).count());
+            nextSwap += std::chrono::milliseconds(swapMs);
+        }
+        if (rate > 0 && now < next) {
+            std::this_thread::sleep_until(next);
+            continue;
+        }
+        PendingActivity activity;
+        activity.details = "Track " + std::to_string(submitted);
+        activity.state = "Artist " + std::to_string(submitted % 97);
+        activity.imageKey = "https://files.catbox.moe/" + std::to_string(submitted % 13) + ".png";
+        activity.appName = "Load Test";
+        activity.start = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        activity.end = activity.start + 180000;
+        activity.hasTimestamps = true;
+        if (poolApps > 0) activity.applicationId = kApplicationId + 100 + submitted % poolApps;
+
+        auto callStart = std::chrono::steady_clock::now();
+        setPendingActivity(std::move(activity));
+        callNs.push_back(std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - callStart).count());
+        submitted++;
+        next += std::chrono::duration_cast<std::chrono::steady_clock::duration>(interval);
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    auto settled = [] {
+        return fakeSdkQueuedCallbacks() == 0 && g_metrics.gauge(Gauge::PresenceInFlight) == 0;
+    };
+    auto settleStart = std::chrono::steady_clock::now();
+    while ((probes > 0 || idleSeconds > 0) && !settled() &&
+           std::chrono::steady_clock::now() - settleStart < std::chrono::seconds(5)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    std::vector<double> probeUs;
+    for (int i = 0; i < probes; i++) {
+        uint64_t before = g_metrics.counter(Counter::PresenceAcks) + g_metrics.counter(Counter::PresenceFailures);
+        PendingActivity activity;
+        activity.details = "Probe " + std::to_string(i);
+        activity.state = "Latency";
+        activity.appName = "Load Test";
+        auto probeStart = std::chrono::steady_clock::now();
+        setPendingActivity(std::move(activity));
+        while (g_metrics.counter(Counter::PresenceAcks) + g_metrics.counter(Counter::PresenceFailures) == before &&
+               std::chrono::steady_clock::now() - probeStart < std::chrono::seconds(5)) {
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+        probeUs.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - probeStart).count());
+    }
+    uint64_t idleWakeups = g_metrics.counter(Counter::CallbackWakeups);
+    int64_t idleCpuUs = processCpuNowUs();
+    if (idleSeconds > 0) std::this_thread::sleep_for(std::chrono::duration<double>(idleSeconds));
+    idleWakeups = g_metrics.counter(Counter::CallbackWakeups) - idleWakeups;
+    idleCpuUs = processCpuNowUs() - idleCpuUs;
+
+    std::string details, state;
+    bool hasPresence = fakeSdkLastPresence(&details, &state);
+    ClientPoolStats pool = g_clientPool.stats();
+
+    // The last changes are published once they settle; shutdown clears the store
+    std::shared_ptr<const RelationshipSnapshot> friends;
+    bool friendsInSync = false;
+    if (config.friends > 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(400));
+        friendsMirror.stop();
+        friendsMirror.poll();
+        friends = g_relationshipStore.snapshot();
+        friendsInSync = friends && friendsMirror.matches(*friends);
+    }
+
+    // As shutdownDiscord does: in-flight results drain through the pump, which
+    // then disconnects and reports back
+    std::atomic<int> shutdownResult{-1};
+    auto shutdownStart = std::chrono::steady_clock::now();
+    shutdownClient(std::chrono::milliseconds(1500), [&shutdownResult](bool clean) { shutdownResult = clean ? 1 : 0; });
+    double shutdownCallUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - shutdownStart).count();
+    while (shutdownResult < 0 && std::chrono::steady_clock::now() - shutdownStart < std::chrono::seconds(5)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    double shutdownMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - shutdownStart).count();
+    FakeSdkStats stats = fakeSdkStats();
+    int64_t pumpCpuUs = g_metrics.gauge(Gauge::PumpCpuUs);
+    int64_t processCpuUs = g_metrics.gauge(Gauge::ProcessCpuUs);
+    if (looper) hostLooper.stop();
+    stopClient();
+
+    std::printf("connect -> ready        %10.1f ms\n", connectMs);
+    std::printf("submitted               %10llu (%.0f/s over %.2f s)\n", (unsigned long long)submitted, submitted / elapsed, elapsed);
+    std::printf("sdk updates             %10llu\n", (unsigned long long)stats.updates);
+    std::printf("  accepted              %10llu\n", (unsigned long long)stats.accepted);
+    std::printf("  rate limited          %10llu\n", (unsigned long long)stats.rateLimited);
+    std::printf("  failed                %10llu\n", (unsigned long long)stats.failed);
+    std::printf("callbacks delivered     %10llu\n", (unsigned long long)stats.callbacks);
+    std::printf("disconnects / readies   %10llu / %llu\n", (unsigned long long)stats.disconnects, (unsigned long long)stats.readies);
+    std::printf("sdk allocs per update   %10.2f (%.1f bytes)\n", stats.updates ? (double)stats.allocs / stats.updates : 0.0,
+                stats.updates ? (double)stats.allocBytes / stats.updates : 0.0);
+    std::printf("setPendingActivity      %10.0f ns p50, %.0f ns p99\n", percentile(callNs, 0.5), percentile(callNs, 0.99));
+    std::printf("core submits/acks/fails %10llu / %llu / %llu, %llu reconnects\n",
+                (unsigned long long)g_metrics.counter(Counter::PresenceSubmits),
+                (unsigned long long)g_metrics.counter(Counter::PresenceAcks),
+                (unsigned long long)g_metrics.counter(Counter::PresenceFailures),
+                (unsigned long long)g_metrics.counter(Counter::Reconnects));
+    if (poolApps > 0) {
+        std::printf("pool clients            %10u (%llu created, %llu evicted, %llu refused)\n", pool.clients,
+                    (unsigned long long)pool.created, (unsigned long long)pool.evicted,
+                    (unsigned long long)pool.exchangeFailures);
+        std::printf("per pooled client       %10lld threads, %lld kB RSS\n", (long long)pool.threadsPerClient,
+                    (long long)pool.rssKbPerClient);
+    }
+    if (!swapNs.empty()) {
+        double maxNs = *std::max_element(swapNs.begin(), swapNs.end());
+        std::printf("client swaps            %10zu (%.0f ns p50, %.0f ns max on the caller)\n", swapNs.size(),
+                    percentile(swapNs, 0.5), maxNs);
+    }
+    std::printf("shutdown                %10.1f us on the caller, %s after %.1f ms\n", shutdownCallUs,
+                shutdownResult == 1 ? "clean" : shutdownResult == 0 ? "cut short" : "unfinished", shutdownMs);
+    SchedSettings sched = g_schedPolicy.settings();
+    std::printf("sched profile           %10s (cpus 0x%llx of 0x%llx, nice %d; sdk got 0x%llx, %d)\n",
+                SchedPolicy::name(g_schedPolicy.profile()), (unsigned long long)sched.cpuMask,
+                (unsigned long long)g_schedPolicy.allCores(), sched.nice, (unsigned long long)stats.cpuAffinityMask,
+                stats.threadPriority);
+    std::printf("cpu time                %10.1f ms pump, %.1f ms process\n", pumpCpuUs / 1000.0, processCpuUs / 1000.0);
+    std::printf("sdk callbacks           %10s, pump on %s\n", freeThreaded ? "free-threaded" : "polled",
+                looper ? "an event loop" : "its own thread");
+    if (!probeUs.empty()) {
+        std::printf("probe update -> result  %10.0f us p50, %.0f us p99 (sdk latency %d ms)\n", percentile(probeUs, 0.5),
+                    percentile(probeUs, 0.99), config.updateLatencyMs);
+    }
+    if (idleSeconds > 0) {
+        std::printf("idle                    %10.1f wakeups/s, %.0f us cpu/s\n", idleWakeups / idleSeconds,
+                    idleCpuUs / idleSeconds);
+    }
+    if (friends) {
+        std::printf("friends                 %10zu (snapshot v%llu, %llu sdk events)\n", friends->rows.size(),
+                    (unsigned long long)friends->version, (unsigned long long)stats.friendEvents);
+        std::printf("friends reader          %10llu rows applied, %llu full refreshes, %llu search hits, %s\n",
+                    (unsigned long long)friendsMirror.rowsApplied(), (unsigned long long)friendsMirror.fullRefreshes(),
+                    (unsigned long long)friendsMirror.searchHits(), friendsInSync ? "in sync" : "OUT OF SYNC");
+    }
+    if (hasPresence) std::printf("last accepted           %s / %s\n", details.c_str(), state.c_str());
+    std::printf("startup (ms since exec)");
+    for (uint32_t i = 0; i < (uint32_t)StartupPhase::Count; i++) {
+        int64_t at = g_startupTimeline.sinceProcessStartMs((StartupPhase)i);
+        if (at >= 0) std::printf(" %s=%lld", StartupTimeline::name((StartupPhase)i), (long long)at);
+    }
+    std::printf("\n");
+    return 0;
+}
@@ -0,0 +1,175 @@
+#include "standin_server.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstring>
+#include <random>
+
+namespace {
+
+bool readRequest(int fd, std::string* head, size_t* bodyLength) {
+    std::string data;
+    char buf[16384];
+    size_t headerEnd = std::string::npos;
+    while (headerEnd == std::string::npos) {
+        ssize_t n = recv(fd, buf, sizeof(buf), 0);
+        if (n <= 0) return false;
+        data.append(buf, (size_t)n);
+        headerEnd = data.find("\r\n\r\n");
+    }
+    *head = data.substr(0, headerEnd);
+
+    size_t contentLength = 0;
+    const char* key = "Content-Length:";
+    size_t pos = head->find(key);
+    if (pos == std::string::npos) pos = head->find("content-length:");
+    if (pos != std::string::npos) contentLength = std::strtoull(head->c_str() + pos + std::strlen(key), nullptr, 10);
+
+    size_t have = data.size() - headerEnd - 4;
+    while (have < contentLength) {
+        ssize_t n = recv(fd, buf, sizeof(buf), 0);
+        if (n <= 0) return false;
+        have += (size_t)n;
+    }
+    *bodyLength = contentLength;
+    return true;
+}
+
+void writeAll(int fd, const std::string& data) {
+    size_t off = 0;
+    while (off < data.size()) {
+        ssize_t n = send(fd, data.data() + off, data.size() - off, MSG_NOSIGNAL);
+        if (n <= 0) return;
+        off += (size_t)n;
+    }
+}
+
+void setTimeout(int fd, int timeoutMs) {
+    timeval tv{timeoutMs / 1000, (timeoutMs % 1000) * 1000};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+}
+
+} // namespace
+
+bool StandinServer::start(uint16_t port) {
+    listenFd_ = socket(AF_INET, SOCK_STREAM, 0);
+    if (listenFd_ < 0) return false;
+    int one = 1;
+    setsockopt(listenFd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(port);
+    if (bind(listenFd_, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(listenFd_, 128) != 0) {
+        close(listenFd_);
+        listenFd_ = -1;
+        return false;
+    }
+    socklen_t len = sizeof(addr);
+    getsockname(listenFd_, (sockaddr*)&addr, &len);
+    port_ = ntohs(addr.sin_port);
+
+    running_ = true;
+    acceptThread_ = std::thread(&StandinServer::acceptLoop, this);
+    return true;
+}
+
+void StandinServer::stop() {
+    if (!running_.exchange(false)) return;
+    shutdown(listenFd_, SHUT_RDWR);
+    close(listenFd_);
+    listenFd_ = -1;
+    if (acceptThread_.joinable()) acceptThread_.join();
+    while (active_.load() > 0) std::this_thread::sleep_for(std::chrono::milliseconds(5));
+}
+
+void StandinServer::acceptLoop() {
+    while (running_) {
+        int fd = accept(listenFd_, nullptr, nullptr);
+        if (fd < 0) continue;
+        active_++;
+        std::thread([this, fd] {
+            handle(fd);
+            close(fd);
+            active_--;
+        }).detach();
+    }
+}
+
+void StandinServer::handle(int fd) {
+    thread_local std::mt19937 rng{std::random_device{}()};
+    setTimeout(fd, 30000);
+
+    std::string head;
+    size_t bodyLength = 0;
+    if (!readRequest(fd, &head, &bodyLength)) return;
+    bytesReceived_ += bodyLength;
+
+    StandinProfile p;
+    {
+        std::lock_guard<std::mutex> lock(profileMutex_);
+        p = profile_;
+    }
+    std::uniform_real_distribution<double> coin(0.0, 1.0);
+    int delay = p.latencyMs;
+    if (p.jitterMs > 0) delay += std::uniform_int_distribution<int>(0, p.jitterMs)(rng);
+    if (coin(rng) < p.stallRate) delay += p.stallMs;
+    if (delay > 0) std::this_thread::sleep_for(std::chrono::milliseconds(delay));
+
+    uint64_t id = ++served_;
+    std::string body;
+    std::string status;
+    if (coin(rng) < p.failRate) {
+        status = "500 Internal Server Error";
+        body = "stand-in failure";
+    } else {
+        status = "200 OK";
+        body = "http://127.0.0.1:" + std::to_string(port_) + "/f/" + std::to_string(id) + ".png";
+    }
+    writeAll(fd, "HTTP/1.1 " + status + "\r\nContent-Type: text/plain\r\nContent-Length: " +
+                     std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n" + body);
+}
+
+int httpPost(const std::string& url, const std::string& body, int timeoutMs, std::string* response) {
+    // Only "http://127.0.0.1:<port>/<path>" is understood; this is a test client
+    const std::string prefix = "http://127.0.0.1:";
+    if (url.compare(0, prefix.size(), prefix) != 0) return -1;
+    size_t slash = url.find('/', prefix.size());
+    uint16_t port = (uint16_t)std::stoi(url.substr(prefix.size(), slash - prefix.size()));
+    std::string path = slash == std::string::npos ? "/" : url.substr(slash);
+
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    setTimeout(fd, timeoutMs);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(port);
+    if (connect(fd, (sockaddr*)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+
+    writeAll(fd, "POST " + path + " HTTP/1.1\r\nHost: 127.0.0.1\r\nContent-Type: application/octet-stream\r\nContent-Length: " +
+                     std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n");
+    writeAll(fd, body);
+
+    std::string data;
+    char buf[4096];
+    ssize_t n;
+    while ((n = recv(fd, buf, sizeof(buf), 0)) > 0) data.append(buf, (size_t)n);
+    close(fd);
+
+    if (data.compare(0, 9, "HTTP/1.1 ") != 0) return -1;
+    int status = std::atoi(data.c_str() + 9);
+    size_t headerEnd = data.find("\r\n\r\n");
+    if (response) *response = headerEnd == std::string::npos ? "" : data.substr(headerEnd + 4);
+    return status;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Minimal local HTTP server that behaves like an image host (catbox style):
+// any POST gets the uploaded file's URL back as the plain-text body.
+// Latency, jitter, errors and stalls are configurable so the upload path can
+// be exercised without network access.
+struct StandinProfile {
+    int latencyMs = 50;
+    int jitterMs = 0;
+    double failRate = 0;   // fraction of requests answered with HTTP 500
+    double stallRate = 0;  // fraction of requests held for stallMs first
+    int stallMs = 5000;
+};
+
+class StandinServer {
+public:
+    explicit StandinServer(StandinProfile profile) : profile_(profile) {}
+    ~StandinServer() { stop(); }
+
+    // Binds 127.0.0.1:|port| (0 picks a free port) and starts serving
+    bool start(uint16_t port = 0);
+    void stop();
+
+    uint16_t port() const { return port_; }
+    std::string url() const { return "http://127.0.0.1:" + std::to_string(port_) + "/upload"; }
+
+    void setProfile(StandinProfile profile) {
+        std::lock_guard<std::mutex> lock(profileMutex_);
+        profile_ = profile;
+    }
+    uint64_t served() const { return served_.load(); }
+    uint64_t bytesReceived() const { return bytesReceived_.load(); }
+
+private:
+    void acceptLoop();
+    void handle(int fd);
+
+    std::mutex profileMutex_;
+    StandinProfile profile_;
+    int listenFd_ = -1;
+    uint16_t port_ = 0;
+    std::thread acceptThread_;
+    std::atomic<bool> running_{false};
+    std::atomic<int> active_{0};
+    std::atomic<uint64_t> served_{0};
+    std::atomic<uint64_t> bytesReceived_{0};
+};
+
+// Blocking HTTP POST of |body| to a 127.0.0.1 URL. Returns the HTTP status
+// (or -1 on socket error/timeout) and fills |response| with the body.
+int httpPost(const std::string& url, const std::string& body, int timeoutMs, std::string* response);
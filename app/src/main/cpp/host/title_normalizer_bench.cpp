@@ -0,0 +1,160 @@
+// Measures title cleanup throughput with title_noise.conf over a synthetic
+// corpus of YouTube-style titles. The baseline lowercases the title and runs
+// std::string::find once per dictionary phrase, which is what a loop over the
+// dictionary costs before doing any of the actual cleanup; the automaton's
+// own detection pass is the like-for-like comparison. Each run repeats with
+// the dictionary padded by phrases that never match, since the per-phrase
+// scan slows down with every phrase and the automaton doesn't.
+//
+//   title_normalizer_bench [title_noise.conf] [--titles N] [--show N]
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../title_normalizer.h"
+
+namespace {
+
+const char* kWords[] = {"Never", "Gonna", "Give", "You", "Up", "Blue", "Monday", "Midnight", "City", "Dreams",
+                        "Take", "On", "Me", "Heart", "Of", "Glass", "Running", "Hill", "Echo", "Lights"};
+const char* kTags[] = {"(Official Music Video)", "[4K]", "(Lyrics)", "[Official Audio]", "(Visualizer)",
+                       "(Remastered 2011)", "[HD]", "(feat. Someone Else)", "(Live at Wembley)", "[MV]"};
+const char* kSeparators[] = {" - ", " | "};
+
+std::string words(std::mt19937& rng, int minWords, int maxWords) {
+    int count = std::uniform_int_distribution<int>(minWords, maxWords)(rng);
+    std::string out;
+    for (int i = 0; i < count; i++) {
+        if (i) out += ' ';
+        out += kWords[rng() % (sizeof(kWords) / sizeof(kWords[0]))];
+    }
+    return out;
+}
+
+std::string noisyTitle(std::mt19937& rng) {
+    std::string artist = words(rng, 1, 2);
+    std::string song = words(rng, 1, 5);
+    std::string out;
+    switch (rng() % 4) {
+    case 0: out = song; break;
+    case 1: out = artist + kSeparators[0] + song; break;
+    case 2: out = song + kSeparators[1] + artist; break;
+    default: out = artist + kSeparators[0] + song + " ft. " + words(rng, 1, 2); break;
+    }
+    int tags = rng() % 3;
+    for (int i = 0; i < tags; i++) {
+        out += ' ';
+        out += kTags[rng() % (sizeof(kTags) / sizeof(kTags[0]))];
+    }
+    return out;
+}
+
+// Never in the corpus: "zq" plus a number spelled in letters
+std::string paddingPhrases(int count) {
+    std::string text = "\n[bracket]\n";
+    for (int i = 0; i < count; i++) {
+        text += "zq";
+        for (int n = i; n; n /= 26) text += (char)('a' + n % 26);
+        text += '\n';
+    }
+    return text;
+}
+
+template <typename F>
+double megabytesPerSecond(const std::vector<std::string>& corpus, size_t corpusBytes, int rounds, F&& body) {
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; r++) {
+        for (const auto& title : corpus) body(title);
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return (double)corpusBytes * rounds / seconds / 1e6;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string path = DEFAULT_NOISE_PATH;
+    int titles = 20000;
+    int show = 8;
+    for (int i = 1; i < argc; i++) {
+        if (!std::strcmp(argv[i], "--titles") && i + 1 < argc) titles = std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--show") && i + 1 < argc) show = std::atoi(argv[++i]);
+        else path = argv[i];
+    }
+
+    std::ifstream file(path);
+    if (!file) {
+        std::fprintf(stderr, "cannot open %s\n", path.c_str());
+        return 1;
+    }
+    std::stringstream text;
+    text << file.rdbuf();
+    TitleNormalizer normalizer;
+    std::string error;
+    if (!normalizer.load(text.str(), &error)) {
+        std::fprintf(stderr, "%s: %s\n", path.c_str(), error.c_str());
+        return 1;
+    }
+    auto dictionary = normalizer.snapshot();
+
+    std::mt19937 rng(7);
+    std::vector<std::string> corpus;
+    size_t corpusBytes = 0;
+    for (int i = 0; i < titles; i++) {
+        corpus.push_back(noisyTitle(rng));
+        corpusBytes += corpus.back().size();
+    }
+
+    NormalizedTitle out;
+    int changed = 0;
+    for (int i = 0; i < (int)corpus.size(); i++) {
+        bool c = TitleNormalizer::normalizeWith(*dictionary, corpus[i], "Some Channel VEVO", &out);
+        changed += c;
+        if (i < show) std::printf("%-62s -> \"%s\" / \"%s\"\n", corpus[i].c_str(), out.title.c_str(), out.artist.c_str());
+    }
+
+    int rounds = std::max<int>(1, (int)(50000000 / std::max<size_t>(1, corpusBytes)));
+    std::printf("\n%d titles, %.1f KB, %d titles changed\n\n", titles, corpusBytes / 1024.0, changed);
+    std::printf("%8s %8s %12s %12s %12s %8s\n", "phrases", "states", "normalize", "ac detect", "find each", "detect");
+    for (int padding : {0, 200, 1000}) {
+        TitleNormalizer padded;
+        if (!padded.load(text.str() + paddingPhrases(padding), &error)) {
+            std::fprintf(stderr, "padded dictionary: %s\n", error.c_str());
+            return 1;
+        }
+        auto dict = padded.snapshot();
+        const NoiseAutomaton& automaton = dict->automaton;
+        std::vector<std::string> phrases;
+        for (size_t id = 0; id < automaton.patternCount(); id++) phrases.push_back(automaton.pattern((int)id).text);
+
+        volatile size_t sink = 0;
+        double normalizeMbs = megabytesPerSecond(corpus, corpusBytes, rounds, [&](const std::string& t) {
+            TitleNormalizer::normalizeWith(*dict, t, "Some Channel VEVO", &out);
+            sink += out.title.size();
+        });
+        double detectMbs = megabytesPerSecond(corpus, corpusBytes, rounds, [&](const std::string& t) {
+            int state = automaton.start();
+            size_t hits = 0;
+            for (unsigned char c : t) {
+                state = automaton.step(state, c);
+                automaton.forEachMatch(state, [&](int) { hits++; });
+            }
+            sink += hits;
+        });
+        std::string lowered;
+        double scanMbs = megabytesPerSecond(corpus, corpusBytes, rounds, [&](const std::string& t) {
+            lowered.assign(t);
+            for (auto& c : lowered) c = (char)NoiseAutomaton::lower((unsigned char)c);
+            for (const auto& phrase : phrases) sink += lowered.find(phrase) != std::string::npos;
+        });
+        std::printf("%8zu %8zu %7.1f MB/s %7.1f MB/s %7.1f MB/s %7.1fx\n", phrases.size(), automaton.stateCount(),
+                    normalizeMbs, detectMbs, scanMbs, detectMbs / scanMbs);
+    }
+    return 0;
+}
@@ -0,0 +1,211 @@
+// Drives UploadScheduler against in-process image host stand-ins, using the
+// same plan / hedge / failover loop as ImageUploader.kt, and reports
+// throughput and latency for a few host behaviours.
+//
+//   upload_failover_bench [--uploads N] [--concurrency N] [--payload-kb N]
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "../upload_scheduler.h"
+#include "standin_server.h"
+
+namespace {
+
+int64_t nowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+struct Attempt {
+    int host;
+    bool ok;
+    int64_t latencyMs;
+};
+
+struct UploadOutcome {
+    bool ok = false;
+    int winner = -1;
+    int hedges = 0;
+    int failovers = 0;
+    int64_t elapsedMs = 0;
+};
+
+struct AttemptQueue {
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<Attempt> done;
+};
+
+UploadOutcome hedgedUpload(UploadScheduler& scheduler, const std::vector<std::string>& urls, const std::string& payload) {
+    UploadOutcome out;
+    int64_t begin = nowMs();
+    std::vector<int> plan = scheduler.plan(begin);
+    auto queue = std::make_shared<AttemptQueue>();
+    size_t next = 0;
+    int inFlight = 0;
+
+    auto launch = [&]() {
+        int host = plan[next++];
+        inFlight++;
+        std::string url = urls[host];
+        std::thread([queue, host, url, &payload] {
+            int64_t start = nowMs();
+            std::string response;
+            int status = httpPost(url, payload, 10000, &response);
+            Attempt a{host, status == 200 && !response.empty(), nowMs() - start};
+            std::lock_guard<std::mutex> lock(queue->mutex);
+            queue->done.push_back(a);
+            queue->cv.notify_one();
+        }).detach();
+    };
+
+    launch();
+    std::unique_lock<std::mutex> lock(queue->mutex);
+    while (inFlight > 0) {
+        if (queue->done.empty()) {
+            if (next < plan.size()) {
+                int64_t hedgeAfter = scheduler.hedgeDelayMs(plan[next - 1]);
+                if (!queue->cv.wait_for(lock, std::chrono::milliseconds(hedgeAfter), [&] { return !queue->done.empty(); })) {
+                    lock.unlock();
+                    launch();
+                    out.hedges++;
+                    lock.lock();
+                    continue;
+                }
+            } else {
+                queue->cv.wait(lock, [&] { return !queue->done.empty(); });
+            }
+        }
+        Attempt a = queue->done.front();
+        queue->done.pop_front();
+        inFlight--;
+        scheduler.report(a.host, a.ok, a.latencyMs, nowMs());
+        if (a.ok) {
+            out.ok = true;
+            out.winner = a.host;
+            break;
+        }
+        if (inFlight == 0 && next < plan.size()) {
+            lock.unlock();
+            launch();
+            out.failovers++;
+            lock.lock();
+        }
+    }
+    // Losing attempts are abandoned like the cancelled calls in Kotlin
+    lock.unlock();
+    out.elapsedMs = nowMs() - begin;
+    return out;
+}
+
+struct Scenario {
+    const char* name;
+    std::vector<StandinProfile> hosts;
+    // Applied to host 0 halfway through the run, if set
+    bool outageAtHalf = false;
+};
+
+void runScenario(const Scenario& scenario, int uploads, int concurrency, const std::string& payload) {
+    std::vector<std::unique_ptr<StandinServer>> servers;
+    std::vector<std::string> urls;
+    std::vector<std::string> names;
+    for (size_t i = 0; i < scenario.hosts.size(); i++) {
+        servers.push_back(std::make_unique<StandinServer>(scenario.hosts[i]));
+        if (!servers.back()->start()) {
+            std::fprintf(stderr, "failed to start stand-in\n");
+            std::exit(1);
+        }
+        urls.push_back(servers.back()->url());
+        names.push_back("standin-" + std::to_string(i));
+    }
+
+    UploadScheduler scheduler;
+    scheduler.configure(names);
+
+    std::mutex resultsMutex;
+    std::vector<UploadOutcome> results;
+    std::atomic<int> issued{0};
+    int64_t begin = nowMs();
+
+    std::vector<std::thread> workers;
+    for (int w = 0; w < concurrency; w++) {
+        workers.emplace_back([&] {
+            int n;
+            while ((n = issued++) < uploads) {
+                if (scenario.outageAtHalf && n == uploads / 2) {
+                    StandinProfile down = scenario.hosts[0];
+                    down.failRate = 1.0;
+                    servers[0]->setProfile(down);
+                }
+                UploadOutcome o = hedgedUpload(scheduler, urls, payload);
+                std::lock_guard<std::mutex> lock(resultsMutex);
+                results.push_back(o);
+            }
+        });
+    }
+    for (auto& t : workers) t.join();
+    double seconds = (double)(nowMs() - begin) / 1000.0;
+
+    std::vector<int64_t> latencies;
+    int ok = 0, hedges = 0, failovers = 0;
+    std::vector<int> wins(names.size());
+    for (const auto& r : results) {
+        latencies.push_back(r.elapsedMs);
+        if (r.ok) {
+            ok++;
+            wins[r.winner]++;
+        }
+        hedges += r.hedges;
+        failovers += r.failovers;
+    }
+    std::sort(latencies.begin(), latencies.end());
+    auto pct = [&](int p) { return latencies.empty() ? 0 : latencies[(latencies.size() - 1) * p / 100]; };
+
+    std::printf("%-8s %5d/%-5d ok  %7.1f up/s  %7.2f MB/s  p50 %5lld ms  p95 %5lld ms  max %5lld ms  hedges %4d  failovers %4d  wins",
+                scenario.name, ok, uploads, uploads / seconds, (double)payload.size() * uploads / seconds / (1024 * 1024),
+                (long long)pct(50), (long long)pct(95), (long long)latencies.back(), hedges, failovers);
+    for (size_t i = 0; i < wins.size(); i++) std::printf(" %d", wins[i]);
+    std::printf("\n");
+
+    // stop() waits for in-flight handlers, including abandoned attempts
+    for (auto& s : servers) s->stop();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int uploads = 300;
+    int concurrency = 8;
+    int payloadKb = 96;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (!std::strcmp(argv[i], "--uploads")) uploads = std::atoi(argv[i + 1]);
+        else if (!std::strcmp(argv[i], "--concurrency")) concurrency = std::atoi(argv[i + 1]);
+        else if (!std::strcmp(argv[i], "--payload-kb")) payloadKb = std::atoi(argv[i + 1]);
+    }
+    std::string payload((size_t)payloadKb * 1024, '\x89');
+
+    StandinProfile fast{30, 20, 0, 0, 0};
+    StandinProfile medium{120, 40, 0, 0, 0};
+    StandinProfile slow{300, 100, 0, 0, 0};
+    StandinProfile stally{30, 20, 0, 0.1, 3000};
+    StandinProfile flaky{30, 20, 0.3, 0, 0};
+
+    std::vector<Scenario> scenarios = {
+        {"steady", {slow, medium, fast}},
+        {"tail", {stally, medium}},
+        {"flaky", {flaky, medium}},
+        {"outage", {fast, medium}, true},
+    };
+    std::printf("%d uploads x %d KB, concurrency %d\n", uploads, payloadKb, concurrency);
+    for (const auto& s : scenarios) runScenario(s, uploads, concurrency, payload);
+    return 0;
+}
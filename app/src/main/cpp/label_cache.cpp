@@ -0,0 +1,84 @@
+#include "label_cache.h"
+
+#include "log.h"
+#include "metrics.h"
+
+LabelCache g_labelCache;
+
+int32_t LabelCache::find(std::string_view package) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (firstLookup_ == std::chrono::steady_clock::time_point{}) firstLookup_ = std::chrono::steady_clock::now();
+    auto it = byPackage_.find(package);
+    if (it == byPackage_.end()) {
+        misses_++;
+        g_metrics.add(Counter::LabelCacheMisses);
+        return kMiss;
+    }
+    hits_++;
+    g_metrics.add(Counter::LabelCacheHits);
+    return it->second;
+}
+
+int32_t LabelCache::put(std::string_view package, std::string_view label) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = byPackage_.find(package);
+    if (it != byPackage_.end()) {
+        // Same text keeps its id, so Kotlin's copy of the label stays good
+        if (labels_[it->second]->text == label) return it->second;
+        forget(packages_[it->second], it->second);
+    }
+    auto id = (int32_t)labels_.size();
+    const InternedString* name = g_internPool.acquire(package);
+    labels_.push_back(g_internPool.acquire(label));
+    packages_.push_back(name);
+    byPackage_.emplace(std::string_view(name->text), id);
+    return id;
+}
+
+bool LabelCache::label(int32_t id, std::string* out) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (id < 0 || (size_t)id >= labels_.size() || !labels_[id]) return false;
+    *out = labels_[id]->text;
+    return true;
+}
+
+void LabelCache::invalidate(std::string_view package) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = byPackage_.find(package);
+    if (it == byPackage_.end()) return;
+    forget(packages_[it->second], it->second);
+    invalidations_++;
+}
+
+void LabelCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    while (!byPackage_.empty()) {
+        int32_t id = byPackage_.begin()->second;
+        forget(packages_[id], id);
+        invalidations_++;
+    }
+}
+
+// Caller holds mutex_
+void LabelCache::forget(const InternedString* package, int32_t id) {
+    byPackage_.erase(std::string_view(package->text));
+    g_internPool.release(labels_[id]);
+    g_internPool.release(package);
+    labels_[id] = nullptr;
+    packages_[id] = nullptr;
+}
+
+LabelCacheStats LabelCache::stats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    LabelCacheStats stats;
+    stats.entries = byPackage_.size();
+    stats.hits = hits_;
+    stats.misses = misses_;
+    stats.invalidations = invalidations_;
+    if (firstLookup_ != std::chrono::steady_clock::time_point{}) {
+        auto elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - firstLookup_).count();
+        if (elapsedMs > 0) stats.hitsPerHour = hits_ * 3600000ull / (uint64_t)elapsedMs;
+    }
+    return stats;
+}
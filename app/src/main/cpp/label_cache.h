@@ -0,0 +1,59 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "string_intern.h"
+
+struct LabelCacheStats {
+    uint64_t entries = 0;
+    uint64_t hits = 0;           // PackageManager label lookups the cache answered
+    uint64_t misses = 0;         // ... and the ones it sent back to Kotlin
+    uint64_t invalidations = 0;
+    // Each hit is a getApplicationInfo binder call not made; this is the rate
+    // since the first lookup
+    uint64_t hitsPerHour = 0;
+};
+
+// Package name -> application label, so a media callback doesn't make two
+// binder calls to system_server for a name that changes only when the app is
+// installed, updated or removed (the service invalidates on those broadcasts).
+//
+// Each label gets an id that presence updates carry instead of a fresh
+// jstring. Ids are never reused: an invalidated one just stops resolving, so
+// an update racing a package change can't pick up another app's name.
+class LabelCache {
+public:
+    static constexpr int32_t kMiss = -1;
+
+    // The id for |package|'s label, or kMiss if Kotlin has to look it up
+    int32_t find(std::string_view package);
+    int32_t put(std::string_view package, std::string_view label);
+    // False if |id| was never handed out or has been invalidated since
+    bool label(int32_t id, std::string* out);
+
+    void invalidate(std::string_view package);
+    // Labels are localized, so a locale change drops them all
+    void clear();
+    LabelCacheStats stats();
+
+private:
+    void forget(const InternedString* package, int32_t id);
+
+    std::mutex mutex_;
+    // Keys view the interned package names held in packages_
+    std::unordered_map<std::string_view, int32_t> byPackage_;
+    std::vector<const InternedString*> labels_;    // by id, null once invalidated
+    std::vector<const InternedString*> packages_;  // by id, null once invalidated
+    uint64_t hits_ = 0;
+    uint64_t misses_ = 0;
+    uint64_t invalidations_ = 0;
+    std::chrono::steady_clock::time_point firstLookup_{};
+};
+
+extern LabelCache g_labelCache;
@@ -0,0 +1,20 @@
+#pragma once
+
+#define LOG_TAG "DiscordRPC"
+
+// Synchronous; per-update paths use the RLOG* macros from log_ring.h instead
+#ifdef __ANDROID__
+#include <android/log.h>
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+#else
+// Host builds (tools under host/) have no logcat, print to stderr instead.
+// Load tools define HOST_QUIET_LOGS so per-update info lines don't dominate.
+#include <cstdio>
+#ifdef HOST_QUIET_LOGS
+#define LOGI(...) ((void)0)
+#else
+#define LOGI(...) (std::fprintf(stderr, "I/" LOG_TAG ": " __VA_ARGS__), std::fputc('\n', stderr))
+#endif
+#define LOGE(...) (std::fprintf(stderr, "E/" LOG_TAG ": " __VA_ARGS__), std::fputc('\n', stderr))
+#endif
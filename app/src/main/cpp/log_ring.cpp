@@ -0,0 +1,335 @@
+#include "log_ring.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+
+#include <pthread.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "log.h"
+#include "metrics.h"
+
+LogRing g_logRing;
+
+namespace {
+
+// ANDROID_PRIORITY_BACKGROUND: rendering never competes with the SDK threads
+constexpr int kRenderNice = 10;
+// After a wakeup the renderer lets a burst of records (one presence update
+// logs several) collect, so a burst costs one wakeup instead of one per record
+constexpr auto kCoalesce = std::chrono::milliseconds(5);
+
+const char kLevelLetters[] = "??VDIWE";
+
+int64_t asInt(LogArgType type, const LogRecord::Value& value) {
+    switch (type) {
+        case LogArgType::UInt: return (int64_t)value.u;
+        case LogArgType::Double: return (int64_t)value.d;
+        case LogArgType::Pointer: return (int64_t)(intptr_t)value.p;
+        default: return value.i;
+    }
+}
+
+double asDouble(LogArgType type, const LogRecord::Value& value) {
+    switch (type) {
+        case LogArgType::Int: return (double)value.i;
+        case LogArgType::UInt: return (double)value.u;
+        case LogArgType::Double: return value.d;
+        default: return 0;
+    }
+}
+
+} // namespace
+
+bool LogSite::admit(int64_t nowMs, uint32_t limit) {
+    if (limit == 0) return true;
+    int64_t start = windowStartMs.load(std::memory_order_relaxed);
+    // Wall clock: a step backwards also starts a new window
+    if (nowMs - start >= 1000 || nowMs < start) {
+        if (windowStartMs.compare_exchange_strong(start, nowMs, std::memory_order_relaxed)) {
+            inWindow.store(0, std::memory_order_relaxed);
+        }
+    }
+    if (inWindow.fetch_add(1, std::memory_order_relaxed) < limit) return true;
+    suppressed.fetch_add(1, std::memory_order_relaxed);
+    g_metrics.add(Counter::LogSuppressed);
+    return false;
+}
+
+void LogRecord::addText(const char* s, size_t length) {
+    if (textUsed >= kTextBytes) {
+        // Full: point at the previous string's terminator
+        args[argCount - 1].text = kTextBytes - 1;
+        return;
+    }
+    size_t n = std::min(length, (size_t)(kTextBytes - 1 - textUsed));
+    std::memcpy(text + textUsed, s, n);
+    text[textUsed + n] = '\0';
+    textUsed += (uint16_t)(n + 1);
+}
+
+LogRing::LogRing() {
+    for (uint32_t i = 0; i < kCapacity; i++) slots_[i].sequence.store(i, std::memory_order_relaxed);
+}
+
+LogRing::~LogRing() {
+    if (thread_.joinable()) {
+        stop_ = true;
+        {
+            std::lock_guard<std::mutex> lock(wakeMutex_);
+            wake_.notify_one();
+        }
+        thread_.join();
+    }
+    delete[] history_;
+}
+
+int64_t LogRing::nowMs() {
+    // Tick resolution (a few ms) is plenty for log lines and skips the precise
+    // clock read
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME_COARSE, &now);
+    return (int64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+uint32_t LogRing::currentTid() {
+    thread_local uint32_t tid = (uint32_t)syscall(SYS_gettid);
+    return tid;
+}
+
+// Bounded MPSC queue after Vyukov: a slot is free for position p when its
+// sequence is p, and holds a record for the reader once it is p + 1
+LogRecord* LogRing::claim(uint64_t* position) {
+    uint64_t pos = tail_.load(std::memory_order_relaxed);
+    while (true) {
+        Slot& slot = slots_[pos & (kCapacity - 1)];
+        uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+        int64_t diff = (int64_t)(sequence - pos);
+        if (diff == 0) {
+            if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                *position = pos;
+                return &slot.record;
+            }
+        } else if (diff < 0) {
+            return nullptr;  // full: the renderer is a whole ring behind
+        } else {
+            pos = tail_.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+void LogRing::publish(uint64_t position) {
+    slots_[position & (kCapacity - 1)].sequence.store(position + 1, std::memory_order_release);
+    // Pairs with the fence in run(): either it sees this record before
+    // sleeping, or we see it asleep and wake it. Only the first producer to
+    // see it asleep pays for the wakeup.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (sleeping_.load(std::memory_order_relaxed) && sleeping_.exchange(false, std::memory_order_relaxed)) {
+        std::lock_guard<std::mutex> lock(wakeMutex_);
+        wake_.notify_one();
+    }
+}
+
+void LogRing::dropped() {
+    g_metrics.add(Counter::LogDropped);
+}
+
+void LogRing::start() {
+    std::call_once(startOnce_, [this]() {
+        history_ = new LogRecord[kHistory];
+        thread_ = std::thread(&LogRing::run, this);
+        started_.store(true, std::memory_order_release);
+    });
+}
+
+bool LogRing::drainOne() {
+    uint64_t pos = head_.load(std::memory_order_relaxed);
+    Slot& slot = slots_[pos & (kCapacity - 1)];
+    if (slot.sequence.load(std::memory_order_acquire) != pos + 1) return false;
+    emit(slot.record);
+    slot.sequence.store(pos + kCapacity, std::memory_order_release);
+    head_.store(pos + 1, std::memory_order_release);
+    return true;
+}
+
+void LogRing::run() {
+    pthread_setname_np(pthread_self(), "log-ring");
+    setpriority(PRIO_PROCESS, (id_t)currentTid(), kRenderNice);
+
+    while (true) {
+        while (drainOne()) {}
+        if (stop_) break;
+
+        {
+            std::unique_lock<std::mutex> lock(wakeMutex_);
+            sleeping_.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            uint64_t pos = head_.load(std::memory_order_relaxed);
+            bool empty = slots_[pos & (kCapacity - 1)].sequence.load(std::memory_order_acquire) != pos + 1;
+            if (empty && !stop_) wake_.wait(lock);
+            sleeping_.store(false, std::memory_order_relaxed);
+        }
+        if (!stop_ && flushWaiters_.load(std::memory_order_relaxed) == 0) std::this_thread::sleep_for(kCoalesce);
+    }
+}
+
+void LogRing::emit(const LogRecord& record) {
+    char message[512];
+    size_t n = render(record, message, sizeof(message));
+    if (record.suppressed > 0) {
+        std::snprintf(message + n, sizeof(message) - n, " [%u similar suppressed]", record.suppressed);
+    }
+#ifdef __ANDROID__
+    __android_log_write((int)record.site->level, LOG_TAG, message);
+#else
+#ifdef HOST_QUIET_LOGS
+    if (record.site->level >= LogLevel::Warn)
+#endif
+    std::fprintf(stderr, "%c/" LOG_TAG ": %s\n", kLevelLetters[(int)record.site->level], message);
+#endif
+
+    std::lock_guard<std::mutex> lock(historyMutex_);
+    history_[historyHead_] = record;
+    historyHead_ = (historyHead_ + 1) % kHistory;
+    historyCount_ = std::min(historyCount_ + 1, kHistory);
+}
+
+void LogRing::flush() {
+    if (!started_.load(std::memory_order_acquire)) return;
+    flushWaiters_.fetch_add(1, std::memory_order_relaxed);
+    uint64_t target = tail_.load(std::memory_order_acquire);
+    while (head_.load(std::memory_order_acquire) < target) {
+        {
+            std::lock_guard<std::mutex> lock(wakeMutex_);
+            wake_.notify_one();
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    flushWaiters_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+bool LogRing::dump(const char* path) {
+    flush();
+    FILE* file = std::fopen(path, "w");
+    if (!file) {
+        LOGE("Log dump: cannot open %s", path);
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(historyMutex_);
+    uint32_t first = (historyHead_ + kHistory - historyCount_) % kHistory;
+    char message[512];
+    for (uint32_t i = 0; i < historyCount_; i++) {
+        const LogRecord& record = history_[(first + i) % kHistory];
+        render(record, message, sizeof(message));
+
+        time_t seconds = (time_t)(record.timeMs / 1000);
+        struct tm local;
+        localtime_r(&seconds, &local);
+        char stamp[32];
+        std::strftime(stamp, sizeof(stamp), "%m-%d %H:%M:%S", &local);
+        std::fprintf(file, "%s.%03d %5d %5u %c %s: %s", stamp, (int)(record.timeMs % 1000), (int)getpid(), record.tid,
+                     kLevelLetters[(int)record.site->level], LOG_TAG, message);
+        if (record.suppressed > 0) std::fprintf(file, " [%u similar suppressed]", record.suppressed);
+        std::fputc('\n', file);
+    }
+    bool ok = std::ferror(file) == 0;
+    ok = std::fclose(file) == 0 && ok;
+    LOGI("Log dump: wrote %u records to %s", historyCount_, path);
+    return ok;
+}
+
+size_t LogRing::render(const LogRecord& record, char* out, size_t capacity) {
+    size_t n = 0;
+    int arg = 0;
+    auto append = [&](int written) {
+        if (written > 0) n = std::min(n + (size_t)written, capacity - 1);
+    };
+
+    const char* f = record.site->format;
+    while (*f && n + 1 < capacity) {
+        if (*f != '%') {
+            out[n++] = *f++;
+            continue;
+        }
+        if (f[1] == '%') {
+            out[n++] = '%';
+            f += 2;
+            continue;
+        }
+
+        // Rebuild the conversion with our own length modifier, since the
+        // argument was widened when it was recorded
+        char spec[32];
+        size_t length = 0;
+        spec[length++] = *f++;
+        while (*f && std::strchr("-+ #0", *f) && length < 16) spec[length++] = *f++;
+        while (*f && (std::isdigit((unsigned char)*f) || *f == '.') && length < 24) spec[length++] = *f++;
+        while (*f && std::strchr("hlLjzt", *f)) f++;
+        char conversion = *f;
+        if (!conversion) break;
+        f++;
+
+        if (arg >= record.argCount) {
+            append(std::snprintf(out + n, capacity - n, "<?>"));
+            continue;
+        }
+        LogArgType type = record.types[arg];
+        const LogRecord::Value& value = record.args[arg++];
+        switch (conversion) {
+            case 'd':
+            case 'i':
+                spec[length++] = 'l';
+                spec[length++] = 'l';
+                spec[length++] = conversion;
+                spec[length] = '\0';
+                append(std::snprintf(out + n, capacity - n, spec, (long long)asInt(type, value)));
+                break;
+            case 'u':
+            case 'x':
+            case 'X':
+            case 'o':
+                spec[length++] = 'l';
+                spec[length++] = 'l';
+                spec[length++] = conversion;
+                spec[length] = '\0';
+                append(std::snprintf(out + n, capacity - n, spec, (unsigned long long)asInt(type, value)));
+                break;
+            case 'c':
+                spec[length++] = 'c';
+                spec[length] = '\0';
+                append(std::snprintf(out + n, capacity - n, spec, (int)asInt(type, value)));
+                break;
+            case 'f':
+            case 'F':
+            case 'e':
+            case 'E':
+            case 'g':
+            case 'G':
+            case 'a':
+            case 'A':
+                spec[length++] = conversion;
+                spec[length] = '\0';
+                append(std::snprintf(out + n, capacity - n, spec, asDouble(type, value)));
+                break;
+            case 's':
+                spec[length++] = 's';
+                spec[length] = '\0';
+                append(std::snprintf(out + n, capacity - n, spec,
+                                     type == LogArgType::Text ? record.text + value.text : "<?>"));
+                break;
+            case 'p':
+                append(std::snprintf(out + n, capacity - n, "%p", type == LogArgType::Pointer ? value.p : nullptr));
+                break;
+            default:
+                append(std::snprintf(out + n, capacity - n, "<%%%c?>", conversion));
+                break;
+        }
+    }
+    out[n] = '\0';
+    return n;
+}
@@ -0,0 +1,206 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+
+// Asynchronous logging for hot paths (presence updates, SDK callbacks), where
+// LOGI's printf formatting and logcat write would run on the caller's thread.
+//
+// RLOGI("App=%s Type=%d", name, type) copies the format pointer and the raw
+// arguments into a fixed-size record in a lock-free ring; a low-priority
+// thread renders records to logcat and keeps the recent ones for dump().
+// Strings are copied into the record (truncated to kTextBytes in total), so
+// temporaries like result.Error().c_str() are safe to pass.
+//
+// Each call site is limited to rateLimit() records per second; what it drops
+// is reported on its next record. Records at a level below minLevel() cost one
+// atomic load. Records from RLOG* and LOGI may interleave out of order.
+enum class LogLevel : uint8_t {
+    // android_LogPriority values, so records go to __android_log_write as is
+    Verbose = 2,
+    Debug = 3,
+    Info = 4,
+    Warn = 5,
+    Error = 6,
+};
+
+enum class LogArgType : uint8_t { Int, UInt, Double, Text, Pointer };
+
+struct LogSite {
+    LogSite(LogLevel level, const char* format) : level(level), format(format) {}
+
+    // False once this site has logged |limit| records in the current second
+    bool admit(int64_t nowMs, uint32_t limit);
+
+    const LogLevel level;
+    const char* const format;
+    std::atomic<int64_t> windowStartMs{0};
+    std::atomic<uint32_t> inWindow{0};
+    std::atomic<uint32_t> suppressed{0};
+};
+
+struct LogRecord {
+    static constexpr int kMaxArgs = 8;
+    static constexpr int kTextBytes = 264;
+
+    union Value {
+        int64_t i;
+        uint64_t u;
+        double d;
+        const void* p;
+        uint16_t text;  // offset into text
+    };
+
+    int64_t timeMs;  // wall clock
+    const LogSite* site;
+    uint32_t tid;
+    uint32_t suppressed;  // records this site dropped since its last one
+    uint8_t argCount;
+    LogArgType types[kMaxArgs];
+    uint16_t textUsed;
+    Value args[kMaxArgs];
+    char text[kTextBytes];
+
+    template <typename T>
+    void add(const T& value);
+    void addText(const char* s, size_t length);
+};
+
+class LogRing {
+public:
+    static constexpr uint32_t kCapacity = 256;  // power of two
+    static constexpr uint32_t kHistory = 512;
+
+    LogRing();
+    ~LogRing();
+
+    LogLevel minLevel() const { return minLevel_.load(std::memory_order_relaxed); }
+    void setMinLevel(LogLevel level) { minLevel_.store(level, std::memory_order_relaxed); }
+    // Records per call site per second, 0 for no limit
+    uint32_t rateLimit() const { return rateLimit_.load(std::memory_order_relaxed); }
+    void setRateLimit(uint32_t perSecond) { rateLimit_.store(perSecond, std::memory_order_relaxed); }
+
+    template <typename... Args>
+    void log(LogSite& site, const Args&... args);
+
+    // Waits until everything logged before the call has been rendered
+    void flush();
+    // Writes the retained history, oldest first, in logcat's threadtime layout
+    bool dump(const char* path);
+
+    // The message alone, as printf would have formatted it
+    static size_t render(const LogRecord& record, char* out, size_t capacity);
+
+private:
+    struct alignas(64) Slot {
+        std::atomic<uint64_t> sequence;
+        LogRecord record;
+    };
+
+    static int64_t nowMs();
+    static uint32_t currentTid();
+
+    LogRecord* claim(uint64_t* position);
+    void publish(uint64_t position);
+    void dropped();
+    void start();
+    void run();
+    bool drainOne();
+    void emit(const LogRecord& record);
+
+    std::atomic<LogLevel> minLevel_{LogLevel::Info};
+    std::atomic<uint32_t> rateLimit_{20};
+
+    Slot slots_[kCapacity];
+    alignas(64) std::atomic<uint64_t> tail_{0};  // next position to claim
+    alignas(64) std::atomic<uint64_t> head_{0};  // next position to render
+
+    std::once_flag startOnce_;
+    std::atomic<bool> started_{false};
+    std::atomic<bool> stop_{false};
+    std::atomic<bool> sleeping_{false};
+    std::atomic<uint32_t> flushWaiters_{0};
+    std::mutex wakeMutex_;
+    std::condition_variable wake_;
+    std::thread thread_;
+
+    std::mutex historyMutex_;
+    LogRecord* history_ = nullptr;
+    uint32_t historyHead_ = 0;
+    uint32_t historyCount_ = 0;
+};
+
+extern LogRing g_logRing;
+
+#define RLOG(level, format, ...)                                  \
+    do {                                                          \
+        static LogSite rlogSite_(level, format);                  \
+        g_logRing.log(rlogSite_, ##__VA_ARGS__);                  \
+    } while (0)
+#define RLOGD(...) RLOG(LogLevel::Debug, __VA_ARGS__)
+#define RLOGI(...) RLOG(LogLevel::Info, __VA_ARGS__)
+#define RLOGW(...) RLOG(LogLevel::Warn, __VA_ARGS__)
+#define RLOGE(...) RLOG(LogLevel::Error, __VA_ARGS__)
+
+template <typename T>
+void LogRecord::add(const T& value) {
+    if (argCount == kMaxArgs) return;
+    Value& slot = args[argCount];
+    LogArgType& type = types[argCount++];
+    using U = std::decay_t<T>;
+    if constexpr (std::is_same_v<U, std::string> || std::is_same_v<U, std::string_view>) {
+        type = LogArgType::Text;
+        slot.text = textUsed;
+        addText(value.data(), value.size());
+    } else if constexpr (std::is_same_v<U, const char*> || std::is_same_v<U, char*>) {
+        type = LogArgType::Text;
+        slot.text = textUsed;
+        const char* s = value;  // may be a string literal, which is never null
+        if (s) addText(s, std::strlen(s));
+        else addText("(null)", 6);
+    } else if constexpr (std::is_floating_point_v<U>) {
+        type = LogArgType::Double;
+        slot.d = (double)value;
+    } else if constexpr (std::is_enum_v<U> || std::is_signed_v<U>) {
+        type = LogArgType::Int;
+        slot.i = (int64_t)value;
+    } else if constexpr (std::is_integral_v<U>) {
+        type = LogArgType::UInt;
+        slot.u = (uint64_t)value;
+    } else if constexpr (std::is_pointer_v<U>) {
+        type = LogArgType::Pointer;
+        slot.p = (const void*)value;
+    } else {
+        static_assert(std::is_pointer_v<U>, "unsupported RLOG argument type");
+    }
+}
+
+template <typename... Args>
+void LogRing::log(LogSite& site, const Args&... args) {
+    if (site.level < minLevel()) return;
+    int64_t now = nowMs();
+    if (!site.admit(now, rateLimit())) return;
+    if (!started_.load(std::memory_order_acquire)) start();
+
+    uint64_t position;
+    LogRecord* record = claim(&position);
+    if (!record) {
+        dropped();
+        return;
+    }
+    record->timeMs = now;
+    record->site = &site;
+    record->tid = currentTid();
+    record->suppressed = site.suppressed.exchange(0, std::memory_order_relaxed);
+    record->argCount = 0;
+    record->textUsed = 0;
+    (record->add(args), ...);
+    publish(position);
+}
@@ -0,0 +1,78 @@
+#include "looper_pump.h"
+
+#include <chrono>
+#include <cstdint>
+
+#include <android/looper.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include "log.h"
+#include "presence_core.h"
+
+LooperPump g_looperPump;
+
+bool LooperPump::attach() {
+    if (looper_) return true;
+    ALooper* looper = ALooper_forThread();
+    if (!looper) {
+        LOGE("LooperPump: calling thread has no Looper");
+        return false;
+    }
+    wakeFd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    timerFd_ = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (wakeFd_ < 0 || timerFd_ < 0) {
+        LOGE("LooperPump: eventfd/timerfd failed");
+        if (wakeFd_ >= 0) close(wakeFd_);
+        if (timerFd_ >= 0) close(timerFd_);
+        wakeFd_ = timerFd_ = -1;
+        return false;
+    }
+    looper_ = looper;
+    ALooper_acquire(looper_);
+    ALooper_addFd(looper_, wakeFd_, 0, ALOOPER_EVENT_INPUT, &LooperPump::onEvent, this);
+    ALooper_addFd(looper_, timerFd_, 0, ALOOPER_EVENT_INPUT, &LooperPump::onEvent, this);
+
+    int wakeFd = wakeFd_;
+    attachPumpDriver({[wakeFd]() {
+        uint64_t one = 1;
+        (void)write(wakeFd, &one, sizeof(one));
+    }});
+    LOGI("Pump attached to the service looper");
+    return true;
+}
+
+void LooperPump::detach() {
+    if (!looper_) return;
+    // First, so nothing writes wakeFd_ once it's closed
+    detachPumpDriver();
+    ALooper_removeFd(looper_, wakeFd_);
+    ALooper_removeFd(looper_, timerFd_);
+    ALooper_release(looper_);
+    close(wakeFd_);
+    close(timerFd_);
+    looper_ = nullptr;
+    wakeFd_ = timerFd_ = -1;
+    LOGI("Pump detached from the service looper");
+}
+
+int LooperPump::onEvent(int fd, int events, void* data) {
+    uint64_t count;
+    (void)read(fd, &count, sizeof(count));
+    static_cast<LooperPump*>(data)->run();
+    return 1;  // keep the fd registered
+}
+
+void LooperPump::run() {
+    auto next = runDrivenPump();
+    // steady_clock is CLOCK_MONOTONIC, which timerFd_ counts in; zero disarms
+    struct itimerspec spec = {};
+    if (next != std::chrono::steady_clock::time_point::max()) {
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(next.time_since_epoch()).count();
+        if (ns <= 0) ns = 1;
+        spec.it_value.tv_sec = ns / 1000000000;
+        spec.it_value.tv_nsec = ns % 1000000000;
+    }
+    timerfd_settime(timerFd_, TFD_TIMER_ABSTIME, &spec, nullptr);
+}
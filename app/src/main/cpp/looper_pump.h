@@ -0,0 +1,24 @@
+#pragma once
+
+// Runs the presence pump on an Android Looper thread (DiscordMediaService's
+// HandlerThread) instead of a thread of its own: posted work writes an
+// eventfd and pump deadlines arm a timerfd, both registered with ALooper_addFd,
+// so the looper runs the pump exactly when there is something to do. Work that
+// calls back into Kotlin then runs on a thread the JVM already knows.
+class LooperPump {
+public:
+    // On the looper thread; false if it has no looper or the fds can't be made
+    bool attach();
+    // On the looper thread, before it quits
+    void detach();
+
+private:
+    static int onEvent(int fd, int events, void* data);
+    void run();
+
+    struct ALooper* looper_ = nullptr;
+    int wakeFd_ = -1;
+    int timerFd_ = -1;
+};
+
+extern LooperPump g_looperPump;
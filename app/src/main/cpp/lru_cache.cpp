@@ -0,0 +1,229 @@
+#include "lru_cache.h"
+
+#include <algorithm>
+
+#include "log.h"
+
+// Art URLs are ~40 bytes and keys ~80, so this holds on the order of 1500 tracks
+LruCache g_artUrlCache("art-url", 256 * 1024);
+
+namespace {
+
+// ComponentCallbacks2.TRIM_MEMORY_* values
+constexpr int kTrimRunningModerate = 5;
+constexpr int kTrimRunningLow = 10;
+constexpr int kTrimRunningCritical = 15;
+constexpr int kTrimBackground = 40;
+constexpr int kTrimModerate = 60;
+constexpr int kTrimComplete = 80;
+
+std::mutex g_registryMutex;
+
+std::vector<LruCache*>& registry() {
+    static std::vector<LruCache*> caches;
+    return caches;
+}
+
+} // namespace
+
+LruCache::LruCache(const char* name, size_t budgetBytes, InternPool& pool)
+    : name_(name), pool_(pool), budget_(budgetBytes) {
+    slots_.resize(16);
+    mask_ = 15;
+    std::lock_guard<std::mutex> lock(g_registryMutex);
+    registry().push_back(this);
+}
+
+LruCache::~LruCache() {
+    {
+        std::lock_guard<std::mutex> lock(g_registryMutex);
+        auto& caches = registry();
+        caches.erase(std::remove(caches.begin(), caches.end(), this), caches.end());
+    }
+    clear();
+}
+
+uint32_t LruCache::find(std::string_view key, uint64_t hash) const {
+    for (uint32_t i = (uint32_t)hash & mask_;; i = (i + 1) & mask_) {
+        const Slot& s = slots_[i];
+        if (!s.key) return kNil;
+        if (s.key->hash == hash && s.key->text == key) return i;
+    }
+}
+
+void LruCache::linkFront(uint32_t index) {
+    Slot& s = slots_[index];
+    s.prev = kNil;
+    s.next = head_;
+    if (head_ != kNil) slots_[head_].prev = index;
+    head_ = index;
+    if (tail_ == kNil) tail_ = index;
+}
+
+void LruCache::unlink(uint32_t index) {
+    Slot& s = slots_[index];
+    if (s.prev != kNil) slots_[s.prev].next = s.next; else head_ = s.next;
+    if (s.next != kNil) slots_[s.next].prev = s.prev; else tail_ = s.prev;
+    s.prev = s.next = kNil;
+}
+
+uint32_t LruCache::insertSlot(const InternedString* key) {
+    uint32_t i = (uint32_t)key->hash & mask_;
+    while (slots_[i].key) i = (i + 1) & mask_;
+    slots_[i].key = key;
+    count_++;
+    return i;
+}
+
+void LruCache::moveSlot(uint32_t from, uint32_t to) {
+    Slot& dst = slots_[to];
+    dst = std::move(slots_[from]);
+    if (dst.prev != kNil) slots_[dst.prev].next = to; else head_ = to;
+    if (dst.next != kNil) slots_[dst.next].prev = to; else tail_ = to;
+    slots_[from] = Slot();
+}
+
+void LruCache::removeAt(uint32_t index) {
+    unlink(index);
+    Slot& s = slots_[index];
+    bytes_ -= s.charge;
+    pool_.release(s.key);
+    s = Slot();
+    count_--;
+
+    // Backward-shift: pull later members of the probe run into the hole so
+    // lookups never need tombstones
+    uint32_t hole = index;
+    for (uint32_t j = (hole + 1) & mask_; slots_[j].key; j = (j + 1) & mask_) {
+        uint32_t ideal = (uint32_t)slots_[j].key->hash & mask_;
+        bool stays = hole <= j ? (ideal > hole && ideal <= j) : (ideal > hole || ideal <= j);
+        if (stays) continue;
+        moveSlot(j, hole);
+        hole = j;
+    }
+}
+
+void LruCache::grow() {
+    std::vector<Slot> old = std::move(slots_);
+    uint32_t oldTail = tail_;
+    slots_ = std::vector<Slot>(old.size() * 2);
+    mask_ = (uint32_t)slots_.size() - 1;
+    count_ = 0;
+    head_ = tail_ = kNil;
+
+    // Re-insert oldest first so pushing each to the front keeps LRU order
+    for (uint32_t i = oldTail; i != kNil;) {
+        Slot& s = old[i];
+        uint32_t prev = s.prev;
+        uint32_t at = insertSlot(s.key);
+        slots_[at].charge = s.charge;
+        slots_[at].value = std::move(s.value);
+        linkFront(at);
+        i = prev;
+    }
+}
+
+void LruCache::evictTo(size_t target) {
+    while (bytes_ > target && tail_ != kNil) {
+        removeAt(tail_);
+        evictions_++;
+    }
+}
+
+bool LruCache::get(std::string_view key, std::string* value) {
+    uint64_t hash = InternPool::hashOf(key);
+    std::lock_guard<std::mutex> lock(mutex_);
+    uint32_t i = find(key, hash);
+    if (i == kNil) {
+        misses_++;
+        return false;
+    }
+    hits_++;
+    if (head_ != i) {
+        unlink(i);
+        linkFront(i);
+    }
+    if (value) *value = slots_[i].value;
+    return true;
+}
+
+bool LruCache::contains(std::string_view key) {
+    uint64_t hash = InternPool::hashOf(key);
+    std::lock_guard<std::mutex> lock(mutex_);
+    return find(key, hash) != kNil;
+}
+
+void LruCache::put(std::string_view key, std::string_view value) {
+    uint64_t hash = InternPool::hashOf(key);
+    uint32_t charge = (uint32_t)(key.size() + value.size() + sizeof(Slot));
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (charge > budget_) return;
+
+    uint32_t i = find(key, hash);
+    if (i != kNil) {
+        bytes_ -= slots_[i].charge;
+        unlink(i);
+    } else {
+        if ((count_ + 1) * 4 > (mask_ + 1) * 3) grow();
+        i = insertSlot(pool_.acquire(key));
+    }
+    slots_[i].value.assign(value.data(), value.size());
+    slots_[i].charge = charge;
+    bytes_ += charge;
+    linkFront(i);
+    evictTo(budget_);
+}
+
+bool LruCache::erase(std::string_view key) {
+    uint64_t hash = InternPool::hashOf(key);
+    std::lock_guard<std::mutex> lock(mutex_);
+    uint32_t i = find(key, hash);
+    if (i == kNil) return false;
+    removeAt(i);
+    return true;
+}
+
+void LruCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& s : slots_) {
+        if (s.key) pool_.release(s.key);
+        s = Slot();
+    }
+    count_ = 0;
+    bytes_ = 0;
+    head_ = tail_ = kNil;
+}
+
+void LruCache::setBudget(size_t budgetBytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    budget_ = budgetBytes;
+    evictTo(budget_);
+}
+
+void LruCache::trim(int level) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t target;
+    if (level >= kTrimComplete || level == kTrimRunningCritical) {
+        target = 0;
+    } else if (level >= kTrimModerate || level == kTrimRunningLow) {
+        target = budget_ / 4;
+    } else if (level >= kTrimBackground || level == kTrimRunningModerate) {
+        target = budget_ / 2;
+    } else {
+        return;  // UI_HIDDEN: nothing visible depends on us shrinking
+    }
+    uint64_t before = evictions_;
+    evictTo(target);
+    LOGI("Cache %s trimmed for level %d: %llu evicted, %zu bytes left", name_, level,
+         (unsigned long long)(evictions_ - before), bytes_);
+}
+
+LruCacheStats LruCache::stats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return {hits_, misses_, evictions_, count_, bytes_, budget_};
+}
+
+void LruCache::trimAll(int level) {
+    std::lock_guard<std::mutex> lock(g_registryMutex);
+    for (auto* cache : registry()) cache->trim(level);
+}
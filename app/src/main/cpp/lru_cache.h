@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "string_intern.h"
+
+struct LruCacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+    uint64_t entries = 0;
+    uint64_t bytes = 0;
+    uint64_t budget = 0;
+};
+
+// String -> string cache bounded by bytes rather than entry count.
+//
+// Entries live in a flat open-addressing table (linear probing, backward-shift
+// deletion, no tombstones). Each slot also carries prev/next slot indices, so
+// the LRU order is an intrusive list threaded through the table itself and
+// nothing is allocated per entry beyond the value string. Keys are interned.
+class LruCache {
+public:
+    LruCache(const char* name, size_t budgetBytes, InternPool& pool = g_internPool);
+    ~LruCache();
+
+    bool get(std::string_view key, std::string* value);
+    bool contains(std::string_view key);
+    void put(std::string_view key, std::string_view value);
+    bool erase(std::string_view key);
+    void clear();
+
+    void setBudget(size_t budgetBytes);
+    // Shrinks in response to ComponentCallbacks2.onTrimMemory(level)
+    void trim(int level);
+    LruCacheStats stats();
+
+    // Applies trim(level) to every live cache
+    static void trimAll(int level);
+
+private:
+    static constexpr uint32_t kNil = UINT32_MAX;
+
+    struct Slot {
+        const InternedString* key = nullptr;  // null = empty
+        uint32_t prev = kNil;
+        uint32_t next = kNil;
+        uint32_t charge = 0;
+        std::string value;
+    };
+
+    uint32_t find(std::string_view key, uint64_t hash) const;
+    uint32_t insertSlot(const InternedString* key);
+    void removeAt(uint32_t index);
+    void moveSlot(uint32_t from, uint32_t to);
+    void grow();
+    void evictTo(size_t target);
+
+    void linkFront(uint32_t index);
+    void unlink(uint32_t index);
+
+    const char* name_;
+    InternPool& pool_;
+    std::mutex mutex_;
+    std::vector<Slot> slots_;
+    uint32_t mask_ = 0;
+    uint32_t count_ = 0;
+    uint32_t head_ = kNil;  // most recently used
+    uint32_t tail_ = kNil;  // eviction end
+    size_t bytes_ = 0;
+    size_t budget_;
+    uint64_t hits_ = 0;
+    uint64_t misses_ = 0;
+    uint64_t evictions_ = 0;
+};
+
+// trackKey -> uploaded cover-art URL
+extern LruCache g_artUrlCache;
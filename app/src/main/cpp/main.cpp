@@ -1,5 +1,4 @@
 #include <jni.h>
-#include <android/log.h>
 #include <iostream>
 #include <thread>
 #include <atomic>
@@ -12,121 +11,245 @@
 #include <chrono> // Added for std::chrono::milliseconds
 #include <mutex>
 
-#define DISCORDPP_IMPLEMENTATION
-#include "discordpp.h"
-
-#define LOG_TAG "DiscordRPC"
-#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
-#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
-
-static std::atomic<uint64_t> g_applicationId{1435558259892293662};
-
-static std::shared_ptr<discordpp::Client> g_client;
-static std::thread g_callbackThread;
-static std::atomic<bool> g_running{false};
-static std::atomic<bool> g_connected{false};
-static std::optional<discordpp::AuthorizationCodeVerifier> g_codeVerifier;
-static std::mutex g_sdkMutex;
-
-struct PendingActivity {
-    std::string details;
-    std::string state;
-    std::string imageKey;
-    std::string appName;
-    long long start = 0;
-    long long end = 0;
-    int type = 2; // Default to Listening
-    int statusDisplayType = 0;
-    bool hasTimestamps = false;
-};
-static std::optional<PendingActivity> g_pendingActivity;
-
-void applyPendingActivity() {
-    std::lock_guard<std::mutex> lock(g_sdkMutex);
-    if (!g_client || !g_connected || !g_pendingActivity) return;
-    
-    LOGI("Applying pending Rich Presence...");
-    discordpp::Activity activity;
-    
-    activity.SetType(static_cast<discordpp::ActivityTypes>(g_pendingActivity->type));
-    activity.SetStatusDisplayType(static_cast<discordpp::StatusDisplayTypes>(g_pendingActivity->statusDisplayType));
-
-    activity.SetDetails(g_pendingActivity->details.c_str());
-    activity.SetState(g_pendingActivity->state.c_str());
-    activity.SetName(g_pendingActivity->appName.c_str());
-     
-    if (g_pendingActivity->hasTimestamps) {
-        discordpp::ActivityTimestamps timestamps;
-        if (g_pendingActivity->start > 0) timestamps.SetStart(g_pendingActivity->start / 1000);
-        if (g_pendingActivity->end > 0) timestamps.SetEnd(g_pendingActivity->end / 1000);
-        activity.SetTimestamps(timestamps);
-    }
-    
-    discordpp::ActivityAssets assets;
-    if (!g_pendingActivity->imageKey.empty()) {
-        assets.SetLargeImage(g_pendingActivity->imageKey.c_str());
-        assets.SetLargeText(g_pendingActivity->state.c_str()); 
-    }
-    activity.SetAssets(assets);
-    
-    g_client->UpdateRichPresence(activity, [](discordpp::ClientResult result) {
-        if (!result.Successful()) {
-            LOGE("Rich Presence update failed: %s", result.Error().c_str());
-        } else {
-            LOGI("Rich Presence updated successfully");
-        }
-    });
+#include "client_pool.h"
+#include "config_store.h"
+#include "friend_search.h"
+#include "label_cache.h"
+#include "log.h"
+#include "log_ring.h"
+#include "looper_pump.h"
+#include "lru_cache.h"
+#include "metadata_rules.h"
+#include "metrics.h"
+#include "presence_core.h"
+#include "presence_journal.h"
+#include "relationship_store.h"
+#include "session_store.h"
+#include "startup_timeline.h"
+#include "status_block.h"
+#include "status_surface.h"
+#include "title_normalizer.h"
+#include "upload_scheduler.h"
+
+static std::string toStdString(JNIEnv* env, jstring jstr) {
+    const char* chars = env->GetStringUTFChars(jstr, nullptr);
+    std::string result(chars);
+    env->ReleaseStringUTFChars(jstr, chars);
+    return result;
+}
+
+// |jlabelId| is from appLabelId/putAppLabel; one invalidated since resolves
+// to the placeholder the service used to show when PackageManager failed
+static std::string appLabel(jint jlabelId) {
+    std::string label;
+    if (!g_labelCache.label(jlabelId, &label)) label = "Unknown App";
+    return label;
 }
 
 extern "C" JNIEXPORT void JNICALL
-Java_com_thepotato_discordrpc_DiscordGateway_updateRichPresence(JNIEnv* env, jobject thiz, jstring jAppName, jstring jdetails, jstring jstate, jstring jimageKey, jint jtype, jint jStatusDisplayType) {
-    const char* appName = env->GetStringUTFChars(jAppName, nullptr);
+Java_com_thepotato_discordrpc_DiscordGateway_updateRichPresence(JNIEnv* env, jobject thiz, jint jlabelId, jstring jdetails, jstring jstate, jstring jimageKey, jint jtype, jint jStatusDisplayType, jlong japplicationId) {
+    std::string appName = appLabel(jlabelId);
     const char* details = env->GetStringUTFChars(jdetails, nullptr);
     const char* state = env->GetStringUTFChars(jstate, nullptr);
     const char* imageKey = env->GetStringUTFChars(jimageKey, nullptr);
     
-    g_pendingActivity = {details, state, imageKey, appName, 0, 0, (int)jtype, (int)jStatusDisplayType, false};
+    RLOGI("Pending Rich Presence: App=%s, Type=%d, Display=%d", appName.c_str(), (int)jtype, (int)jStatusDisplayType);
     
-    LOGI("Pending Rich Presence: App=%s, Type=%d, Display=%d", appName, (int)jtype, (int)jStatusDisplayType);
+    setPendingActivity({details, state, imageKey, std::move(appName), 0, 0, (int)jtype, (int)jStatusDisplayType, false, (uint64_t)japplicationId});
     
-    applyPendingActivity();
-    
-    env->ReleaseStringUTFChars(jAppName, appName);
     env->ReleaseStringUTFChars(jdetails, details);
     env->ReleaseStringUTFChars(jstate, state);
     env->ReleaseStringUTFChars(jimageKey, imageKey);
 }
 
 extern "C" JNIEXPORT void JNICALL
-Java_com_thepotato_discordrpc_DiscordGateway_updateRichPresenceWithTimestamps(JNIEnv* env, jobject thiz, jstring jAppName, jstring jdetails, jstring jstate, jstring jimageKey, jlong jstart, jlong jend, jint jtype, jint jStatusDisplayType) {
-    const char* appName = env->GetStringUTFChars(jAppName, nullptr);
+Java_com_thepotato_discordrpc_DiscordGateway_updateRichPresenceWithTimestamps(JNIEnv* env, jobject thiz, jint jlabelId, jstring jdetails, jstring jstate, jstring jimageKey, jlong jstart, jlong jend, jint jtype, jint jStatusDisplayType, jlong japplicationId) {
+    std::string appName = appLabel(jlabelId);
     const char* details = env->GetStringUTFChars(jdetails, nullptr);
     const char* state = env->GetStringUTFChars(jstate, nullptr);
     const char* imageKey = env->GetStringUTFChars(jimageKey, nullptr);
     
-    g_pendingActivity = {details, state, imageKey, appName, (long long)jstart, (long long)jend, (int)jtype, (int)jStatusDisplayType, true};
-    
-    LOGI("Pending Rich Presence w/ Timestamps: App=%s", appName);
+    RLOGI("Pending Rich Presence w/ Timestamps: App=%s", appName.c_str());
     
-    applyPendingActivity();
+    setPendingActivity({details, state, imageKey, std::move(appName), (long long)jstart, (long long)jend, (int)jtype, (int)jStatusDisplayType, true, (uint64_t)japplicationId});
     
-    env->ReleaseStringUTFChars(jAppName, appName);
     env->ReleaseStringUTFChars(jdetails, details);
     env->ReleaseStringUTFChars(jstate, state);
     env->ReleaseStringUTFChars(jimageKey, imageKey);
 }
 
-void runCallbackLoop() {
-    LOGI("Callback loop started");
-    while (g_running) {
-        discordpp::RunCallbacks();
-        std::this_thread::sleep_for(std::chrono::milliseconds(16));
+static JavaVM* g_jvm = nullptr;
+static jobject g_gateway = nullptr;
+
+// Warm start: the session restore DiscordGateway.warmStart kicks off from
+// Application.onCreate. initDiscord/restoreSession run after it has created
+// the client (not after the network), then adopt that client instead of
+// replacing it.
+static std::mutex g_warmStartMutex;
+static bool g_warmStartPending = false;
+// shutdownDiscord came while the warm start was still reading the session
+static bool g_warmStartCancelled = false;
+static StoredSession g_warmStarted;  // applicationId 0 once the client isn't the warm-started one
+// What JNI calls left to do while the warm start was pending, in call order
+static std::vector<std::function<void()>> g_afterWarmStart;
+
+// Runs |fn| now, or queues it for the warm start's thread to run once the
+// session is read: the caller is the main thread, which never waits on that I/O
+static void afterWarmStart(std::function<void()> fn) {
+    {
+        std::lock_guard<std::mutex> lock(g_warmStartMutex);
+        if (g_warmStartPending) {
+            g_afterWarmStart.push_back(std::move(fn));
+            return;
+        }
+    }
+    fn();
+}
+
+static void forgetWarmStartedClient() {
+    std::lock_guard<std::mutex> lock(g_warmStartMutex);
+    g_warmStarted = StoredSession();
+}
+
+// How long shutdownDiscord lets in-flight updates and the disconnect take
+// before the client is dropped regardless
+constexpr std::chrono::milliseconds kShutdownBudget{1500};
+
+// Runs on the pump thread once shutdownDiscord's client is released
+static void onShutdownComplete(bool clean) {
+    LOGI("Shutdown finished (%s)", clean ? "clean" : "deadline");
+    if (!g_jvm || !g_gateway) return;
+    JNIEnv* env;
+    bool attached = false;
+    if (g_jvm->GetEnv((void**)&env, JNI_VERSION_1_6) != JNI_OK) {
+        g_jvm->AttachCurrentThread(&env, nullptr);
+        attached = true;
+    }
+    jclass gatewayClass = env->GetObjectClass(g_gateway);
+    jmethodID onComplete = env->GetMethodID(gatewayClass, "onShutdownComplete", "(Z)V");
+    if (onComplete) {
+        env->CallVoidMethod(g_gateway, onComplete, clean ? JNI_TRUE : JNI_FALSE);
+    }
+    env->DeleteLocalRef(gatewayClass);
+    if (attached) {
+        g_jvm->DetachCurrentThread();
     }
-    LOGI("Callback loop stopped");
 }
 
-static JavaVM* g_jvm = nullptr;
-static jobject g_gateway = nullptr;
+extern "C" JNIEXPORT jint JNICALL JNI_OnLoad(JavaVM* vm, void* reserved) {
+    g_startupTimeline.mark(StartupPhase::LibraryLoaded);
+    g_jvm = vm;
+    return JNI_VERSION_1_6;
+}
+
+// Runs on the pump thread, which owns g_client: when the client becomes
+// Ready, and whenever the UI asks for the user again
+static void onClientReady() {
+    if (!g_client || !g_connected) {
+        LOGI("No connected client to report a user from");
+        return;
+    }
+    // Fetch User Info
+    auto userOpt = g_client->GetCurrentUserV2();
+    if (userOpt.has_value() && g_jvm && g_gateway) {
+         auto user = *userOpt;
+         LOGI("Got User: %s", user.Username().c_str());
+         
+         JNIEnv* env;
+         bool attached = false;
+         if (g_jvm->GetEnv((void**)&env, JNI_VERSION_1_6) != JNI_OK) {
+             g_jvm->AttachCurrentThread(&env, nullptr);
+             attached = true;
+         }
+         
+         jclass gatewayClass = env->GetObjectClass(g_gateway);
+         jmethodID onUserUpdate = env->GetMethodID(gatewayClass, "onCurrentUserUpdate", "(Ljava/lang/String;Ljava/lang/String;JLjava/lang/String;)V");
+         
+         if (onUserUpdate) {
+             jstring jName = env->NewStringUTF(user.Username().c_str());
+             jstring jDisc = env->NewStringUTF("0");
+             
+             std::string avatarStr = "";
+             auto avatarOpt = user.Avatar();
+             if (avatarOpt.has_value()) {
+                 avatarStr = *avatarOpt;
+             }
+             jstring jAvatar = env->NewStringUTF(avatarStr.c_str());
+             
+             env->CallVoidMethod(g_gateway, onUserUpdate, jName, jDisc, (jlong)user.Id(), jAvatar);
+             
+             env->DeleteLocalRef(jName);
+             env->DeleteLocalRef(jDisc);
+             env->DeleteLocalRef(jAvatar);
+         }
+         
+         if (attached) {
+             g_jvm->DetachCurrentThread();
+         }
+    } else {
+         LOGI("GetCurrentUserV2 returned no user.");
+    }
+}
+
+// Reads the native session copy and, if the user is signed in with RPC on,
+// creates the client and restores the token on a background thread, so the
+// handshake runs while the UI is still inflating
+extern "C" JNIEXPORT void JNICALL
+Java_com_thepotato_discordrpc_DiscordGateway_warmStart(JNIEnv* env, jobject thiz, jstring jfilesDir) {
+    g_startupTimeline.mark(StartupPhase::WarmStart);
+    std::string filesDir = toStdString(env, jfilesDir);
+    g_sessionStore.setDirectory(filesDir);
+    {
+        std::lock_guard<std::mutex> lock(g_warmStartMutex);
+        if (g_warmStartPending || g_running) return;
+        g_warmStartPending = true;
+        g_warmStartCancelled = false;
+    }
+
+    std::thread([filesDir]() {
+        std::string error;
+        if (!g_presenceJournal.open(filesDir + "/presence.journal", &error)) {
+            LOGE("Presence journal unavailable: %s", error.c_str());
+        }
+        StoredSession session;
+        bool restore = g_sessionStore.load(&session) && session.enabled;
+        g_startupTimeline.mark(StartupPhase::SessionLoaded);
+        {
+            // Both only post to the pump, so they're fine under the lock
+            std::lock_guard<std::mutex> lock(g_warmStartMutex);
+            if (restore && !g_warmStartCancelled) {
+                LOGI("Warm start: restoring session for client %llu", (unsigned long long)session.applicationId);
+                startClient(session.applicationId, onClientReady);
+                restoreToken(session.accessToken);
+                g_warmStarted = session;
+            }
+        }
+        // Still pending while the queue drains, so a call arriving meanwhile
+        // lines up behind the ones before it
+        for (;;) {
+            std::vector<std::function<void()>> queued;
+            {
+                std::lock_guard<std::mutex> lock(g_warmStartMutex);
+                if (g_afterWarmStart.empty()) {
+                    g_warmStartPending = false;
+                    break;
+                }
+                queued.swap(g_afterWarmStart);
+            }
+            for (auto& fn : queued) fn();
+        }
+    }).detach();
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_thepotato_discordrpc_DiscordGateway_openPresenceJournal(JNIEnv* env, jobject thiz, jstring jpath) {
+    std::string error;
+    if (!g_presenceJournal.open(toStdString(env, jpath), &error)) {
+        LOGE("Presence journal unavailable: %s", error.c_str());
+        return JNI_FALSE;
+    }
+    return JNI_TRUE;
+}
 
 extern "C" JNIEXPORT void JNICALL
 Java_com_thepotato_discordrpc_DiscordGateway_initDiscord(JNIEnv* env, jobject thiz, jlong jclientId) {
@@ -137,140 +260,62 @@ Java_com_thepotato_discordrpc_DiscordGateway_initDiscord(JNIEnv* env, jobject th
         env->DeleteGlobalRef(g_gateway);
     }
     g_gateway = env->NewGlobalRef(thiz);
-    
-    if (g_running && g_connected && g_client) {
-        auto userOpt = g_client->GetCurrentUserV2();
-        if (userOpt.has_value()) {
-            auto user = *userOpt;
-            
-            jclass gatewayClass = env->GetObjectClass(g_gateway);
-            jmethodID onUserUpdate = env->GetMethodID(gatewayClass, "onCurrentUserUpdate", "(Ljava/lang/String;Ljava/lang/String;JLjava/lang/String;)V");
-            
-            if (onUserUpdate) {
-                jstring jName = env->NewStringUTF(user.Username().c_str());
-                jstring jDisc = env->NewStringUTF("0");
-                
-                std::string avatarStr = "";
-                auto avatarOpt = user.Avatar();
-                if (avatarOpt.has_value()) {
-                    avatarStr = *avatarOpt;
-                }
-                jstring jAvatar = env->NewStringUTF(avatarStr.c_str());
-                
-                env->CallVoidMethod(g_gateway, onUserUpdate, jName, jDisc, (jlong)user.Id(), jAvatar);
-                
-                env->DeleteLocalRef(jName);
-                env->DeleteLocalRef(jDisc);
-                env->DeleteLocalRef(jAvatar);
-            }
+
+    uint64_t clientId = static_cast<uint64_t>(jclientId);
+    afterWarmStart([clientId]() {
+        bool warmStarted;
+        {
+            std::lock_guard<std::mutex> lock(g_warmStartMutex);
+            warmStarted = g_warmStarted.applicationId == clientId;
         }
-        return;
-    }
-    
-    g_applicationId = static_cast<uint64_t>(jclientId);
-    LOGI("Initializing Discord SDK with Client ID: %lld", (long long)jclientId);
-    
-    if (g_running) {
-        g_running = false;
-        g_connected = false;
-        if (g_callbackThread.joinable()) {
-            g_callbackThread.join();
+        // A warm-started client may still be connecting; Ready reports the user
+        // through g_gateway, set above
+        if (g_running && warmStarted && !g_connected) {
+            LOGI("Adopting warm-started client");
+            return;
         }
-    }
-    
-    g_client = std::make_shared<discordpp::Client>();
-    
-    g_client->AddLogCallback([](auto message, auto severity) {
-        LOGI("[Discord SDK] %s", message.c_str());
-    }, discordpp::LoggingSeverity::Info);
-    
-    g_client->SetStatusChangedCallback([](discordpp::Client::Status status, discordpp::Client::Error error, int32_t errorDetail) {
-        LOGI("Status changed: %s", discordpp::Client::StatusToString(status).c_str());
-        if (status == discordpp::Client::Status::Ready) {
-            LOGI("Client is ready");
-            g_connected = true;
-            // Apply any pending activity that was set before connection
-            applyPendingActivity();
-            // Fetch User Info
-            auto userOpt = g_client->GetCurrentUserV2();
-            if (userOpt.has_value() && g_jvm && g_gateway) {
-                 auto user = *userOpt;
-                 LOGI("Got User: %s", user.Username().c_str());
-                 
-                 JNIEnv* env;
-                 bool attached = false;
-                 if (g_jvm->GetEnv((void**)&env, JNI_VERSION_1_6) != JNI_OK) {
-                     g_jvm->AttachCurrentThread(&env, nullptr);
-                     attached = true;
-                 }
-                 
-                 jclass gatewayClass = env->GetObjectClass(g_gateway);
-                 jmethodID onUserUpdate = env->GetMethodID(gatewayClass, "onCurrentUserUpdate", "(Ljava/lang/String;Ljava/lang/String;JLjava/lang/String;)V");
-                 
-                 if (onUserUpdate) {
-                     jstring jName = env->NewStringUTF(user.Username().c_str());
-                     jstring jDisc = env->NewStringUTF("0");
-                     
-                     std::string avatarStr = "";
-                     auto avatarOpt = user.Avatar();
-                     if (avatarOpt.has_value()) {
-                         avatarStr = *avatarOpt;
-                     }
-                     jstring jAvatar = env->NewStringUTF(avatarStr.c_str());
-                     
-                     env->CallVoidMethod(g_gateway, onUserUpdate, jName, jDisc, (jlong)user.Id(), jAvatar);
-                     
-                     env->DeleteLocalRef(jName);
-                     env->DeleteLocalRef(jDisc);
-                     env->DeleteLocalRef(jAvatar);
-                 }
-                 
-                 if (attached) {
-                     g_jvm->DetachCurrentThread();
-                 }
-            } else {
-                 LOGI("GetCurrentUserV2 returned no user.");
-            }
-        } else if (error != discordpp::Client::Error::None) {
-            LOGE("Connection Error: %s Detail: %d", discordpp::Client::ErrorToString(error).c_str(), errorDetail);
-            g_connected = false;
+
+        if (g_running && g_connected) {
+            runOnPump(onClientReady);
+            return;
         }
+
+        LOGI("Initializing Discord SDK with Client ID: %llu", (unsigned long long)clientId);
+        forgetWarmStartedClient();
+        startClient(clientId, onClientReady);
     });
-    
-    g_codeVerifier = g_client->CreateAuthorizationCodeVerifier();
-    
-    g_running = true;
-    g_callbackThread = std::thread(runCallbackLoop);
 }
 
-extern "C" JNIEXPORT void JNICALL
-Java_com_thepotato_discordrpc_DiscordGateway_startAuthorization(JNIEnv* env, jobject thiz) {
+// Pump thread
+static void authorizeOnPump() {
     if (!g_client || !g_codeVerifier) {
         LOGE("Client not initialized");
         return;
     }
-    
+
     LOGI("Starting OAuth authorization");
-    
+
     discordpp::AuthorizationArgs args{};
     args.SetClientId(g_applicationId);
     args.SetScopes(discordpp::Client::GetDefaultPresenceScopes());
     args.SetCodeChallenge(g_codeVerifier->Challenge());
     args.SetCustomSchemeParam("discordrpc");
-    
+
     g_client->Authorize(args, [](discordpp::ClientResult result, std::string code, std::string redirectUri) {
         LOGI("Authorize callback triggered");
     });
 }
 
+extern "C" JNIEXPORT void JNICALL
+Java_com_thepotato_discordrpc_DiscordGateway_startAuthorization(JNIEnv* env, jobject thiz) {
+    // On the pump, behind a client swap initDiscord may have just posted (or
+    // queued behind the warm start)
+    afterWarmStart([] { runOnPump(authorizeOnPump); });
+}
+
 extern "C" JNIEXPORT void JNICALL
 Java_com_thepotato_discordrpc_DiscordGateway_connect(JNIEnv* env, jobject thiz) {
-    if (!g_client) {
-        LOGE("Client not initialized! Cannot connect");
-        return;
-    }
-    LOGI("Connecting to Discord Gateway");
-    g_client->Connect();
+    connectClient();
 }
 
 extern "C" JNIEXPORT void JNICALL
@@ -280,7 +325,7 @@ Java_com_thepotato_discordrpc_DiscordGateway_handleOAuthCallback(JNIEnv* env, jo
     
     LOGI("handleOAuthCallback called");
     
-    if (!g_client || !g_codeVerifier) {
+    if (!g_running) {
         LOGE("Client not initialized");
         env->ReleaseStringUTFChars(jcode, code);
         env->ReleaseStringUTFChars(jredirectUri, redirectUri);
@@ -300,35 +345,27 @@ Java_com_thepotato_discordrpc_DiscordGateway_handleOAuthCallback(JNIEnv* env, jo
     env->GetJavaVM(&jvm);
     jobject globalGateway = env->NewGlobalRef(thiz);
 
-    g_client->GetToken(g_applicationId, std::string(code), g_codeVerifier->Verifier(), redirectUriStr,
-        [jvm, globalGateway, onTokenReceivedMethod](discordpp::ClientResult result, std::string accessToken, std::string refreshToken, discordpp::AuthorizationTokenType tokenType, int32_t expiresIn, std::string scope) {
-            LOGI("GetToken callback triggered");
-            if (!result.Successful()) {
-                LOGE("GetToken Error: %s", result.Error().c_str());
-                return;
-            }
-            LOGI("Access token received!");
-            
+    exchangeAuthorizationCode(std::string(code), redirectUriStr,
+        [jvm, globalGateway, onTokenReceivedMethod](const std::string& accessToken, const std::string& refreshToken) {
+            // On the pump, which in Looper mode is a Java thread: detaching
+            // one the VM attached aborts the process
             JNIEnv* env;
-            if (jvm->AttachCurrentThread(&env, nullptr) == JNI_OK) {
-                 jstring jAccess = env->NewStringUTF(accessToken.c_str());
-                 jstring jRefresh = env->NewStringUTF(refreshToken.c_str());
-                 
-                 env->CallVoidMethod(globalGateway, onTokenReceivedMethod, jAccess, jRefresh);
-                 
-                 env->DeleteLocalRef(jAccess);
-                 env->DeleteLocalRef(jRefresh);
-                 jvm->DetachCurrentThread();
+            bool attached = false;
+            if (jvm->GetEnv((void**)&env, JNI_VERSION_1_6) == JNI_EDETACHED) {
+                if (jvm->AttachCurrentThread(&env, nullptr) != JNI_OK) return;
+                attached = true;
             }
+            jstring jAccess = env->NewStringUTF(accessToken.c_str());
+            jstring jRefresh = env->NewStringUTF(refreshToken.c_str());
 
-            g_client->UpdateToken(discordpp::AuthorizationTokenType::Bearer, accessToken, [](discordpp::ClientResult result) {
-                if (result.Successful()) {
-                    LOGI("Token updated, connecting...");
-                    g_client->Connect();
-                } else {
-                    LOGE("UpdateToken Error: %s", result.Error().c_str());
-                }
-            });
+            env->CallVoidMethod(globalGateway, onTokenReceivedMethod, jAccess, jRefresh);
+            g_sessionStore.save({g_applicationId, true, accessToken, refreshToken});
+
+            env->DeleteLocalRef(jAccess);
+            env->DeleteLocalRef(jRefresh);
+            if (attached) {
+                jvm->DetachCurrentThread();
+            }
         });
     
     env->ReleaseStringUTFChars(jcode, code);
@@ -337,97 +374,483 @@ Java_com_thepotato_discordrpc_DiscordGateway_handleOAuthCallback(JNIEnv* env, jo
 
 extern "C" JNIEXPORT void JNICALL
 Java_com_thepotato_discordrpc_DiscordGateway_restoreSession(JNIEnv* env, jobject thiz, jstring jAccessToken, jstring jRefreshToken) {
-    const char* accessToken = env->GetStringUTFChars(jAccessToken, nullptr);
-    const char* refreshToken = env->GetStringUTFChars(jRefreshToken, nullptr);
-    
-    if (!g_client) {
-        LOGE("Client not initialized! Cannot restore session");
-         env->ReleaseStringUTFChars(jAccessToken, accessToken);
-         env->ReleaseStringUTFChars(jRefreshToken, refreshToken);
-        return;
-    }
-    
-    LOGI("Restoring session with saved token");
-    g_client->UpdateToken(discordpp::AuthorizationTokenType::Bearer, std::string(accessToken), [](discordpp::ClientResult result) {
-         if (result.Successful()) {
-             LOGI("Token restored");
-             // Connect after successfully updating token
-             LOGI("Connecting after token restore");
-             g_client->Connect();
-         } else {
-             LOGE("Failed to restore token: %s", result.Error().c_str());
-         }
+    std::string accessToken = toStdString(env, jAccessToken);
+    std::string refreshToken = toStdString(env, jRefreshToken);
+
+    // Keep the native copy current for the next cold start; the toggle is
+    // whatever setWarmStartEnabled last stored
+    StoredSession stored;
+    g_sessionStore.load(&stored);
+    stored.applicationId = g_applicationId;
+    stored.accessToken = accessToken;
+    stored.refreshToken = refreshToken;
+    g_sessionStore.save(stored);
+
+    afterWarmStart([accessToken]() {
+        {
+            std::lock_guard<std::mutex> lock(g_warmStartMutex);
+            if (g_running && g_warmStarted.applicationId == g_applicationId && g_warmStarted.accessToken == accessToken) {
+                LOGI("Session already restored by warm start");
+                return;
+            }
+        }
+        restoreToken(accessToken);
     });
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_thepotato_discordrpc_DiscordGateway_setWarmStartEnabled(JNIEnv* env, jobject thiz, jboolean enabled) {
+    g_sessionStore.setEnabled(enabled == JNI_TRUE);
+}
 
-    env->ReleaseStringUTFChars(jAccessToken, accessToken);
-    env->ReleaseStringUTFChars(jRefreshToken, refreshToken);
+extern "C" JNIEXPORT void JNICALL
+Java_com_thepotato_discordrpc_DiscordGateway_forgetSession(JNIEnv* env, jobject thiz) {
+    g_sessionStore.forget();
+    forgetWarmStartedClient();
 }
 
 extern "C" JNIEXPORT void JNICALL
 Java_com_thepotato_discordrpc_DiscordGateway_clearActivity(JNIEnv* env, jobject thiz) {
-    std::lock_guard<std::mutex> lock(g_sdkMutex);
-    if (!g_client || !g_connected) {
-        LOGE("clearActivity: Client not ready or not connected");
-        return;
-    }
-    LOGI("Clearing Rich Presence activity");
-    g_client->ClearRichPresence();
+    clearPresence();
 }
 
 extern "C" JNIEXPORT void JNICALL
 Java_com_thepotato_discordrpc_DiscordGateway_shutdownDiscord(JNIEnv* env, jobject thiz) {
-    std::lock_guard<std::mutex> lock(g_sdkMutex);
-    LOGI("Shutting down Discord SDK");
-    g_running = false;
-    g_connected = false;
-    if (g_callbackThread.joinable()) {
-        g_callbackThread.join();
+    {
+        std::lock_guard<std::mutex> lock(g_warmStartMutex);
+        if (g_warmStartPending) g_warmStartCancelled = true;
+        g_warmStarted = StoredSession();
     }
-    g_client.reset();
+    // Returns at once; the pump clears, drains and disconnects, then reports
+    // to DiscordGateway.onShutdownComplete. Behind any initDiscord still
+    // queued, so that client doesn't outlive the shutdown.
+    afterWarmStart([] { shutdownClient(kShutdownBudget, onShutdownComplete); });
 }
 
 extern "C" JNIEXPORT void JNICALL
 Java_com_thepotato_discordrpc_DiscordGateway_requestUserUpdate(JNIEnv* env, jobject thiz) {
-    if (!g_client || !g_connected) {
+    if (!g_connected) {
         LOGE("requestUserUpdate: Client not ready or not connected");
         return;
     }
-    
-    // Fetch User Info
-    auto userOpt = g_client->GetCurrentUserV2();
-    if (userOpt.has_value()) {
-         auto user = *userOpt;
-         LOGI("requestUserUpdate: Got User from cache: %s", user.Username().c_str());
-         
-         jclass gatewayClass = env->GetObjectClass(thiz);
-         jmethodID onUserUpdate = env->GetMethodID(gatewayClass, "onCurrentUserUpdate", "(Ljava/lang/String;Ljava/lang/String;JLjava/lang/String;)V");
-         
-         if (onUserUpdate) {
-             LOGI("requestUserUpdate: Found Java callback method");
-             jstring jName = env->NewStringUTF(user.Username().c_str());
-             jstring jDisc = env->NewStringUTF("0");
-             
-             std::string avatarStr = "";
-             auto avatarOpt = user.Avatar();
-             if (avatarOpt.has_value()) {
-                 avatarStr = *avatarOpt;
-             }
-             jstring jAvatar = env->NewStringUTF(avatarStr.c_str());
-             
-             env->CallVoidMethod(thiz, onUserUpdate, jName, jDisc, (jlong)user.Id(), jAvatar);
-             
-             env->DeleteLocalRef(jName);
-             env->DeleteLocalRef(jDisc);
-             env->DeleteLocalRef(jAvatar);
-         } else {
-             LOGE("requestUserUpdate: Could NOT find onCurrentUserUpdate method! Check signature.");
-         }
+    // Read on the pump rather than here: a swap or stop there can release
+    // g_client while this thread is still inside it. The reply comes through
+    // g_gateway, the same object as |thiz|
+    runOnPump(onClientReady);
+}
+
+static int64_t monotonicMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_thepotato_discordrpc_DiscordGateway_configureUploadHosts(JNIEnv* env, jobject thiz, jobjectArray jnames) {
+    std::vector<std::string> names;
+    jsize count = env->GetArrayLength(jnames);
+    for (jsize i = 0; i < count; i++) {
+        auto jname = (jstring)env->GetObjectArrayElement(jnames, i);
+        const char* name = env->GetStringUTFChars(jname, nullptr);
+        names.emplace_back(name);
+        env->ReleaseStringUTFChars(jname, name);
+        env->DeleteLocalRef(jname);
+    }
+    g_uploadScheduler.configure(names);
+}
+
+extern "C" JNIEXPORT jintArray JNICALL
+Java_com_thepotato_discordrpc_DiscordGateway_uploadPlan(JNIEnv* env, jobject thiz) {
+    std::vector<int> order = g_uploadScheduler.plan(monotonicMs());
+    jintArray result = env->NewIntArray((jsize)order.size());
+    env->SetIntArrayRegion(result, 0, (jsize)order.size(), reinterpret_cast<const jint*>(order.data()));
+    return result;
+}
+
+extern "C" JNIEXPORT jlong JNICALL
+Java_com_thepotato_discordrpc_DiscordGateway_uploadHedgeDelayMs(JNIEnv* env, jobject thiz, jint host) {
+    return (jlong)g_uploadScheduler.hedgeDelayMs(host);
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_thepotato_discordrpc_DiscordGateway_reportUploadResult(JNIEnv* env, jobject thiz, jint host, jboolean success, jlong latencyMs, jlong bytes) {
+    g_metrics.add(Counter::UploadAttempts);
+    g_metrics.add(Counter::UploadBytes, (uint64_t)bytes);
+    if (success == JNI_TRUE) {
+        g_metrics.record(Histogram::UploadLatencyMs, (uint64_t)latencyMs);
     } else {
-         LOGI("requestUserUpdate: No user logic available in client cache (yet)");
-         // Attempt to force a fetch if possible, or just wait?
-         // For now, logging this is crucial to know if we are waiting on Discord or on JNI.
-         
-         // Fallback: If no user, maybe we aren't fully ready?
-         // But g_connected is true.
+        g_metrics.add(Counter::UploadFailures);
     }
+    g_uploadScheduler.report(host, success == JNI_TRUE, (int64_t)latencyMs, monotonicMs());
+}
+
+extern "C" JNIEXPORT jstring JNICALL
+Java_com_thepotato_discordrpc_DiscordGateway_artCacheGet(JNIEnv* env, jobject thiz, jstring jkey) {
+    std::string url;
+    if (!g_artUrlCache.get(toStdString(env, jkey), &url)) {
+        g_metrics.add(Counter::ArtCacheMisses);
+        return nullptr;
+    }
+    g_metrics.add(Counter::ArtCacheHits);
+    return env->NewStringUTF(url.c_str());
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_thepotato_discordrpc_DiscordGateway_artCacheContains(JNIEnv* env, jobject thiz, jstring jkey) {
+    return g_artUrlCache.contains(toStdString(env, jkey)) ? JNI_TRUE : JNI_FALSE;
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_thepotato_discordrpc_DiscordGateway_artCachePut(JNIEnv* env, jobject thiz, jstring jkey, jstring jurl) {
+    g_artUrlCache.put(toStdString(env, jkey), toStdString(env, jurl));
+}
+
+// [hits, misses, evictions, entries, bytes, budget]
+extern "C" JNIEXPORT jlongArray JNICALL
+Java_com_thepotato_discordrpc_DiscordGateway_artCacheStats(JNIEnv* env, jobject thiz) {
+    LruCacheStats stats = g_artUrlCache.stats();
+    jlong values[] = {(jlong)stats.hits, (jlong)stats.misses, (jlong)stats.evictions,
+                      (jlong)stats.entries, (jlong)stats.bytes, (jlong)stats.budget};
+    jlongArray result = env->NewLongArray(6);
+    env->SetLongArrayRegion(result, 0, 6, values);
+    return result;
+}
+
+// [clients, created, evicted, exchangeFailures, threadsPerClient, rssKbPerClient]
+extern "C" JNIEXPORT jlongArray JNICALL
+Java_com_thepotato_discordrpc_DiscordGateway_clientPoolStats(JNIEnv* env, jobject thiz) {
+    ClientPoolStats stats = g_clientPool.stats();
+    jlong values[] = {(jlong)stats.clients, (jlong)stats.created, (jlong)stats.evicted,
+                      (jlong)stats.exchangeFailures, (jlong)stats.threadsPerClient, (jlong)stats.rssKbPerClient};
+    jlongArray result = env->NewLongArray(6);
+    env->SetLongArrayRegion(result, 0, 6, values);
+    return result;
+}
+
+// LogLevel / android_LogPriority value; RLOG* records below it are skipped
+extern "C" JNIEXPORT void JNICALL
+Java_com_thepotato_discordrpc_DiscordGateway_setNativeLogLevel(JNIEnv* env, jobject thiz, jint level) {
+    g_logRing.setMinLevel(static_cast<LogLevel>(level));
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_thepotato_discordrpc_DiscordGateway_enableFreeThreadedSdk(JNIEnv* env, jobject thiz) {
+    return enableFreeThreaded() ? JNI_TRUE : JNI_FALSE;
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_thepotato_discordrpc_DiscordGateway_attachPumpToLooper(JNIEnv* env, jobject thiz) {
+    return g_looperPump.attach() ? JNI_TRUE : JNI_FALSE;
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_thepotato_discordrpc_DiscordGateway_detachPumpFromLooper(JNIEnv* env, jobject thiz) {
+    g_looperPump.detach();
+}
+
+// SchedProfile value; the pump and SDK threads pick it up on the next pump tick
+extern "C" JNIEXPORT void JNICALL
+Java_com_thepotato_discordrpc_DiscordGateway_setSchedProfile(JNIEnv* env, jobject thiz, jint profile) {
+    setSchedProfile(static_cast<SchedProfile>(profile));
+}
+
+// ExpiryAction value: what a presence left running past its end timestamp becomes
+extern "C" JNIEXPORT void JNICALL
+Java_com_thepotato_discordrpc_DiscordGateway_setPresenceExpiryAction(JNIEnv* env, jobject thiz, jint action) {
+    setExpiryAction(static_cast<ExpiryAction>(action));
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_thepotato_discordrpc_DiscordGateway_dumpNativeLog(JNIEnv* env, jobject thiz, jstring jpath) {
+    return g_logRing.dump(toStdString(env, jpath).c_str()) ? JNI_TRUE : JNI_FALSE;
+}
+
+// Packed MetricsRegistry::snapshot(), decoded by NativeMetrics.kt
+extern "C" JNIEXPORT jlongArray JNICALL
+Java_com_thepotato_discordrpc_DiscordGateway_metricsSnapshot(JNIEnv* env, jobject thiz) {
+    std::vector<int64_t> values = g_metrics.snapshot();
+    jlongArray result = env->NewLongArray((jsize)values.size());
+    env->SetLongArrayRegion(result, 0, (jsize)values.size(), reinterpret_cast<const jlong*>(values.data()));
+    return result;
+}
+
+// ArtPrefetcher's accounting; |jevent| is DiscordGateway.PREFETCH_*, in
+// Counter order from PrefetchIssued
+extern "C" JNIEXPORT void JNICALL
+Java_com_thepotato_discordrpc_DiscordGateway_recordPrefetch(JNIEnv* env, jobject thiz, jint jevent) {
+    uint32_t counter = (uint32_t)Counter::PrefetchIssued + (uint32_t)jevent;
+    if (jevent < 0 || counter > (uint32_t)Counter::PrefetchNoArt) return;
+    g_metrics.add((Counter)counter);
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_thepotato_discordrpc_DiscordGateway_trimNativeMemory(JNIEnv* env, jobject thiz, jint level) {
+    LruCache::trimAll(level);
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_thepotato_discordrpc_DiscordGateway_loadMetadataRules(JNIEnv* env, jobject thiz, jstring jtext) {
+    std::string error;
+    if (!g_metadataRules.load(toStdString(env, jtext), &error)) {
+        LOGE("Metadata rules rejected: %s", error.c_str());
+        return JNI_FALSE;
+    }
+    return JNI_TRUE;
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_thepotato_discordrpc_DiscordGateway_loadTitleNoise(JNIEnv* env, jobject thiz, jstring jtext) {
+    std::string error;
+    if (!g_titleNormalizer.load(toStdString(env, jtext), &error)) {
+        LOGE("Title noise dictionary rejected: %s", error.c_str());
+        return JNI_FALSE;
+    }
+    return JNI_TRUE;
+}
+
+// [details, state, StatusDisplayTypes name], or null when no rule matches and
+// the noise dictionary (if enabled for the app) leaves the title untouched
+extern "C" JNIEXPORT jobjectArray JNICALL
+Java_com_thepotato_discordrpc_DiscordGateway_parseMetadata(JNIEnv* env, jobject thiz, jstring jpackage, jstring jtitle, jstring jartist) {
+    std::string package = toStdString(env, jpackage);
+    std::string title = toStdString(env, jtitle);
+    std::string artist = toStdString(env, jartist);
+    ParsedTitle parsed;
+    if (!g_metadataRules.parse(package, title, artist, &parsed)) {
+        NormalizedTitle normalized;
+        if (!g_titleNormalizer.enabledFor(package) || !g_titleNormalizer.normalize(title, artist, &normalized)) {
+            return nullptr;
+        }
+        parsed.details = std::move(normalized.title);
+        parsed.state = std::move(normalized.artist);
+    }
+    static const char* kDisplayNames[] = {"NAME", "STATE", "DETAILS"};
+    jobjectArray result = env->NewObjectArray(3, env->FindClass("java/lang/String"), nullptr);
+    jstring jdetails = env->NewStringUTF(parsed.details.c_str());
+    jstring jstate = env->NewStringUTF(parsed.state.c_str());
+    jstring jdisplay = env->NewStringUTF(kDisplayNames[parsed.displayType]);
+    env->SetObjectArrayElement(result, 0, jdetails);
+    env->SetObjectArrayElement(result, 1, jstate);
+    env->SetObjectArrayElement(result, 2, jdisplay);
+    env->DeleteLocalRef(jdetails);
+    env->DeleteLocalRef(jstate);
+    env->DeleteLocalRef(jdisplay);
+    return result;
+}
+
+// The service's whole configuration, pushed again on every preference change.
+// The arrays are parallel, one element per package that has any setting.
+extern "C" JNIEXPORT void JNICALL
+Java_com_thepotato_discordrpc_DiscordGateway_pushConfig(JNIEnv* env, jobject thiz, jboolean jrpcEnabled, jobjectArray jpackages,
+                                                        jbooleanArray jallowed, jintArray jtypes, jlongArray japplicationIds) {
+    jsize count = env->GetArrayLength(jpackages);
+    std::vector<jboolean> allowed(count);
+    std::vector<jint> types(count);
+    std::vector<jlong> applicationIds(count);
+    env->GetBooleanArrayRegion(jallowed, 0, count, allowed.data());
+    env->GetIntArrayRegion(jtypes, 0, count, types.data());
+    env->GetLongArrayRegion(japplicationIds, 0, count, applicationIds.data());
+
+    auto snapshot = std::make_shared<ConfigSnapshot>();
+    snapshot->rpcEnabled = jrpcEnabled;
+    for (jsize i = 0; i < count; i++) {
+        auto jpackage = (jstring)env->GetObjectArrayElement(jpackages, i);
+        AppSettings settings;
+        settings.allowed = allowed[i];
+        settings.activityType = types[i];
+        settings.applicationId = (uint64_t)applicationIds[i];
+        snapshot->apps.add(toStdString(env, jpackage), settings);
+        if (settings.allowed) snapshot->allowedCount++;
+        env->DeleteLocalRef(jpackage);
+    }
+    snapshot->apps.build();
+    g_configStore.publish(std::move(snapshot));
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_thepotato_discordrpc_DiscordGateway_configRpcEnabled(JNIEnv* env, jobject thiz) {
+    auto config = g_configStore.snapshot();
+    return !config || config->rpcEnabled ? JNI_TRUE : JNI_FALSE;
+}
+
+// Per media callback: fills |jout| with [CONFIG_* flags, activity type,
+// application id] for the package from the current snapshot
+extern "C" JNIEXPORT void JNICALL
+Java_com_thepotato_discordrpc_DiscordGateway_appConfig(JNIEnv* env, jobject thiz, jstring jpackage, jlongArray jout) {
+    constexpr jlong kRpcEnabled = 1;
+    constexpr jlong kAllowed = 2;
+    constexpr jlong kNativeParser = 4;
+
+    const char* chars = env->GetStringUTFChars(jpackage, nullptr);
+    std::string_view package(chars);
+    jlong values[] = {0, 2, 0};
+    auto config = g_configStore.snapshot();
+    if (!config || config->rpcEnabled) values[0] |= kRpcEnabled;
+    if (const AppSettings* app = config ? config->apps.find(package) : nullptr) {
+        if (app->allowed) values[0] |= kAllowed;
+        values[1] = app->activityType;
+        values[2] = (jlong)app->applicationId;
+    }
+    // Packages no rule or noise dictionary covers skip the parseMetadata round trip
+    if (g_metadataRules.hasRulesFor(package) || g_titleNormalizer.enabledFor(package)) values[0] |= kNativeParser;
+    env->ReleaseStringUTFChars(jpackage, chars);
+    env->SetLongArrayRegion(jout, 0, 3, values);
+}
+
+// Label id for |jpackage|, or -1 if the service has to ask PackageManager
+// and hand the answer to putAppLabel
+extern "C" JNIEXPORT jint JNICALL
+Java_com_thepotato_discordrpc_DiscordGateway_appLabelId(JNIEnv* env, jobject thiz, jstring jpackage) {
+    const char* chars = env->GetStringUTFChars(jpackage, nullptr);
+    jint id = g_labelCache.find(chars);
+    env->ReleaseStringUTFChars(jpackage, chars);
+    return id;
+}
+
+extern "C" JNIEXPORT jint JNICALL
+Java_com_thepotato_discordrpc_DiscordGateway_putAppLabel(JNIEnv* env, jobject thiz, jstring jpackage, jstring jlabel) {
+    return g_labelCache.put(toStdString(env, jpackage), toStdString(env, jlabel));
+}
+
+// What the service is about to show in its notification and status broadcast.
+// Returns 0 to post it now, -1 to leave things as they are, or the ms after
+// which to call flushStatus; see status_surface.h.
+extern "C" JNIEXPORT jlong JNICALL
+Java_com_thepotato_discordrpc_DiscordGateway_offerStatus(JNIEnv* env, jobject thiz, jint jstatus, jstring jdetails, jstring jstate,
+                                                         jstring jimageKey, jint jlabelId, jlong jstart, jlong jend, jint jtype) {
+    PendingActivity activity;
+    activity.details = toStdString(env, jdetails);
+    activity.state = toStdString(env, jstate);
+    activity.imageKey = toStdString(env, jimageKey);
+    g_labelCache.label(jlabelId, &activity.appName);
+    activity.start = jstart;
+    activity.end = jend;
+    activity.hasTimestamps = jend > 0;
+    activity.type = jtype;
+    return g_statusSurface.offer((SurfaceStatus)jstatus, std::move(activity), monotonicMs());
+}
+
+extern "C" JNIEXPORT jlong JNICALL
+Java_com_thepotato_discordrpc_DiscordGateway_flushStatus(JNIEnv* env, jobject thiz) {
+    return g_statusSurface.flush(monotonicMs());
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_thepotato_discordrpc_DiscordGateway_resetStatus(JNIEnv* env, jobject thiz) {
+    g_statusSurface.reset();
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_thepotato_discordrpc_DiscordGateway_setStatusInterval(JNIEnv* env, jobject thiz, jlong jintervalMs) {
+    g_statusSurface.setIntervalMs(jintervalMs);
+}
+
+// The status block's eventfd, for MainActivity to watch from its Looper; -1
+// if it couldn't be created
+extern "C" JNIEXPORT jint JNICALL
+Java_com_thepotato_discordrpc_DiscordGateway_statusEventFd(JNIEnv* env, jobject thiz) {
+    return g_statusBlock.eventFd();
+}
+
+// Re-arms the eventfd, then null if the block is still at |jafterVersion|;
+// otherwise [details, state, appName, imageKey] with |jout| filled with
+// [version, status, activity type, start, end, connection status, has presence]
+extern "C" JNIEXPORT jobjectArray JNICALL
+Java_com_thepotato_discordrpc_DiscordGateway_readStatus(JNIEnv* env, jobject thiz, jlong jafterVersion, jlongArray jout) {
+    g_statusBlock.drainEvents();
+    StatusView view;
+    if (!g_statusBlock.read((uint64_t)jafterVersion, &view)) return nullptr;
+    jlong values[] = {(jlong)view.version, view.status, view.activityType, view.start, view.end, view.connection, view.hasPresence};
+    env->SetLongArrayRegion(jout, 0, 7, values);
+    jobjectArray result = env->NewObjectArray(4, env->FindClass("java/lang/String"), nullptr);
+    const std::string* texts[] = {&view.details, &view.state, &view.appName, &view.imageKey};
+    for (jsize i = 0; i < 4; i++) {
+        jstring text = env->NewStringUTF(texts[i]->c_str());
+        env->SetObjectArrayElement(result, i, text);
+        env->DeleteLocalRef(text);
+    }
+    return result;
+}
+
+// Null if the friends list hasn't moved past |jafterVersion|; otherwise
+// [meta, texts] with meta a long[] of [version, full refresh, changed count,
+// removed count, userId/status/activity type per changed row, removed ids...]
+// and texts a String[] of displayName, username, activity name, details and
+// state per changed row. A full refresh replaces everything the caller has.
+extern "C" JNIEXPORT jobjectArray JNICALL
+Java_com_thepotato_discordrpc_DiscordGateway_friendChanges(JNIEnv* env, jobject thiz, jlong jafterVersion) {
+    auto snapshot = g_relationshipStore.snapshot();
+    if (!snapshot || snapshot->version == (uint64_t)jafterVersion) return nullptr;
+    std::vector<const FriendRow*> changed;
+    std::vector<uint64_t> removed;
+    bool full = snapshot->changesSince((uint64_t)jafterVersion, &changed, &removed);
+
+    std::vector<jlong> meta = {(jlong)snapshot->version, full, (jlong)changed.size(), (jlong)removed.size()};
+    meta.reserve(meta.size() + changed.size() * 3 + removed.size());
+    for (const FriendRow* row : changed) {
+        meta.insert(meta.end(), {(jlong)row->userId, row->status, row->activityType});
+    }
+    for (uint64_t userId : removed) meta.push_back((jlong)userId);
+    jlongArray jmeta = env->NewLongArray((jsize)meta.size());
+    env->SetLongArrayRegion(jmeta, 0, (jsize)meta.size(), meta.data());
+
+    jobjectArray jtexts = env->NewObjectArray((jsize)changed.size() * 5, env->FindClass("java/lang/String"), nullptr);
+    jsize index = 0;
+    for (const FriendRow* row : changed) {
+        for (TextRef ref : {row->displayName, row->username, row->activityName, row->details, row->state}) {
+            jstring text = env->NewStringUTF(std::string(snapshot->textOf(ref)).c_str());
+            env->SetObjectArrayElement(jtexts, index++, text);
+            env->DeleteLocalRef(text);
+        }
+    }
+
+    jobjectArray result = env->NewObjectArray(2, env->FindClass("java/lang/Object"), nullptr);
+    env->SetObjectArrayElement(result, 0, jmeta);
+    env->SetObjectArrayElement(result, 1, jtexts);
+    return result;
+}
+
+// User ids of up to |jlimit| friends with a word of their display name or
+// username starting with |jquery|, best first; NativeFriends has their rows
+extern "C" JNIEXPORT jlongArray JNICALL
+Java_com_thepotato_discordrpc_DiscordGateway_searchFriends(JNIEnv* env, jobject thiz, jstring jquery, jint jlimit) {
+    std::vector<uint64_t> userIds;
+    g_friendSearch.search(toStdString(env, jquery), (size_t)(jlimit > 0 ? jlimit : 0), &userIds);
+    jlongArray result = env->NewLongArray((jsize)userIds.size());
+    env->SetLongArrayRegion(result, 0, (jsize)userIds.size(), reinterpret_cast<const jlong*>(userIds.data()));
+    return result;
+}
+
+// Null |jpackage| drops every label
+extern "C" JNIEXPORT void JNICALL
+Java_com_thepotato_discordrpc_DiscordGateway_invalidateAppLabel(JNIEnv* env, jobject thiz, jstring jpackage) {
+    if (!jpackage) {
+        g_labelCache.clear();
+        return;
+    }
+    g_labelCache.invalidate(toStdString(env, jpackage));
+}
+
+// [entries, hits, misses, invalidations, hitsPerHour]; a hit is a binder call
+// to system_server the media callback didn't make
+extern "C" JNIEXPORT jlongArray JNICALL
+Java_com_thepotato_discordrpc_DiscordGateway_labelCacheStats(JNIEnv* env, jobject thiz) {
+    LabelCacheStats stats = g_labelCache.stats();
+    jlong values[] = {(jlong)stats.entries, (jlong)stats.hits, (jlong)stats.misses,
+                      (jlong)stats.invalidations, (jlong)stats.hitsPerHour};
+    jlongArray result = env->NewLongArray(5);
+    env->SetLongArrayRegion(result, 0, 5, values);
+    return result;
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_thepotato_discordrpc_DiscordGateway_markStartupUiReady(JNIEnv* env, jobject thiz) {
+    g_startupTimeline.mark(StartupPhase::UiReady);
+}
+
+// Milliseconds from process start per StartupPhase, -1 for phases not reached
+extern "C" JNIEXPORT jlongArray JNICALL
+Java_com_thepotato_discordrpc_DiscordGateway_startupTimeline(JNIEnv* env, jobject thiz) {
+    std::vector<int64_t> values = g_startupTimeline.snapshot();
+    jlongArray result = env->NewLongArray((jsize)values.size());
+    env->SetLongArrayRegion(result, 0, (jsize)values.size(), reinterpret_cast<const jlong*>(values.data()));
+    return result;
 }
@@ -0,0 +1,359 @@
+#include "metadata_rules.h"
+
+#include <algorithm>
+#include <bitset>
+#include <map>
+
+#include "log.h"
+
+MetadataRules g_metadataRules;
+
+namespace {
+
+constexpr int kMaxCaptures = 16;
+constexpr size_t kMaxSpecNodes = 63;
+
+struct NfaNode {
+    std::bitset<256> set;
+    bool star;  // consumes |set| and stays; otherwise consumes one and advances
+};
+
+uint64_t closure(const std::vector<NfaNode>& nodes, uint64_t states) {
+    // Star nodes may be skipped; walk forward since edges only go right
+    for (size_t k = 0; k < nodes.size(); k++) {
+        if ((states >> k & 1) && nodes[k].star) states |= 1ull << (k + 1);
+    }
+    return states;
+}
+
+std::string_view trim(std::string_view s) {
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t' || s.front() == '\r')) s.remove_prefix(1);
+    while (!s.empty() && (s.back() == ' ' || s.back() == '\t' || s.back() == '\r')) s.remove_suffix(1);
+    return s;
+}
+
+int displayTypeFromName(std::string_view name) {
+    if (name == "NAME") return 0;
+    if (name == "STATE") return 1;
+    if (name == "DETAILS") return 2;
+    return -1;
+}
+
+struct MatchState {
+    const Rule& rule;
+    std::string_view text;
+    std::string_view captures[kMaxCaptures] = {};
+};
+
+bool matchFrom(MatchState& m, size_t segment, size_t pos) {
+    const auto& segments = m.rule.segments;
+    if (segment == segments.size()) return pos == m.text.size();
+    const RuleSegment& seg = segments[segment];
+
+    if (seg.kind == RuleSegment::Literal) {
+        if (m.text.compare(pos, seg.literal.size(), seg.literal) != 0) return false;
+        return matchFrom(m, segment + 1, pos + seg.literal.size());
+    }
+
+    if (seg.dfa >= 0) {
+        return m.rule.dfas[seg.dfa].matchEnds(m.text, pos, [&](size_t end) {
+            m.captures[seg.capture] = m.text.substr(pos, end - pos);
+            return matchFrom(m, segment + 1, end);
+        });
+    }
+
+    // Untyped capture: shortest first
+    if (segment + 1 == segments.size()) {
+        m.captures[seg.capture] = m.text.substr(pos);
+        return true;
+    }
+    const RuleSegment& next = segments[segment + 1];
+    if (next.kind == RuleSegment::Literal) {
+        // Only offsets where the following literal occurs can work
+        for (size_t at = m.text.find(next.literal, pos); at != std::string_view::npos; at = m.text.find(next.literal, at + 1)) {
+            m.captures[seg.capture] = m.text.substr(pos, at - pos);
+            if (matchFrom(m, segment + 1, at)) return true;
+        }
+        return false;
+    }
+    for (size_t end = pos; end <= m.text.size(); end++) {
+        m.captures[seg.capture] = m.text.substr(pos, end - pos);
+        if (matchFrom(m, segment + 1, end)) return true;
+    }
+    return false;
+}
+
+void expand(const std::vector<TemplatePart>& parts, const MatchState& m, std::string_view title, std::string_view artist, std::string* out) {
+    out->clear();
+    for (const auto& part : parts) {
+        out->append(part.literal);
+        if (part.capture >= 0) out->append(m.captures[part.capture]);
+        else if (part.capture == TemplatePart::kRawTitle) out->append(title);
+        else if (part.capture == TemplatePart::kRawArtist) out->append(artist);
+    }
+}
+
+} // namespace
+
+bool SpecDfa::compile(std::string_view spec, std::string* error) {
+    spec_ = std::string(spec);
+    std::vector<NfaNode> nodes;
+    for (size_t i = 0; i < spec.size(); i++) {
+        std::bitset<256> set;
+        bool repeat = false;
+        char c = spec[i];
+        if (c == '#') {
+            for (int d = '0'; d <= '9'; d++) set.set(d);
+            repeat = true;
+        } else if (c == '@') {
+            for (int l = 'a'; l <= 'z'; l++) set.set(l);
+            for (int l = 'A'; l <= 'Z'; l++) set.set(l);
+            for (int b = 0x80; b < 0x100; b++) set.set(b);  // UTF-8 letters, loosely
+            repeat = true;
+        } else {
+            if (c == '\\' && i + 1 < spec.size()) c = spec[++i];
+            set.set((unsigned char)c);
+        }
+        nodes.push_back({set, false});
+        if (repeat) nodes.push_back({set, true});
+    }
+    if (nodes.size() > kMaxSpecNodes) {
+        *error = "capture spec too long: " + spec_;
+        return false;
+    }
+
+    // Subset construction; NFA states fit in a 64-bit mask
+    const uint64_t acceptBit = 1ull << nodes.size();
+    std::map<uint64_t, int> ids;
+    std::vector<uint64_t> pending;
+    auto idOf = [&](uint64_t states) {
+        auto it = ids.find(states);
+        if (it != ids.end()) return it->second;
+        int id = (int)ids.size();
+        ids.emplace(states, id);
+        pending.push_back(states);
+        transitions_.resize((size_t)(id + 1) * 256, kDead);
+        accepting_.push_back((states & acceptBit) != 0);
+        return id;
+    };
+    transitions_.clear();
+    accepting_.clear();
+    idOf(closure(nodes, 1));
+    for (size_t done = 0; done < pending.size(); done++) {
+        uint64_t states = pending[done];
+        int from = ids[states];
+        for (int b = 0; b < 256; b++) {
+            uint64_t next = 0;
+            for (size_t k = 0; k < nodes.size(); k++) {
+                if (!(states >> k & 1) || !nodes[k].set.test(b)) continue;
+                next |= nodes[k].star ? (1ull << k) : (1ull << (k + 1));
+            }
+            if (next) transitions_[(size_t)from * 256 + b] = idOf(closure(nodes, next));
+        }
+    }
+    return true;
+}
+
+bool MetadataRules::compile(const std::string& pattern, Rule* rule, std::string* error) {
+    rule->pattern = pattern;
+    rule->segments.clear();
+    rule->captureNames.clear();
+    rule->dfas.clear();
+
+    std::string literal;
+    auto flushLiteral = [&]() {
+        if (literal.empty()) return;
+        RuleSegment seg;
+        seg.literal = literal;
+        rule->segments.push_back(std::move(seg));
+        literal.clear();
+    };
+
+    for (size_t i = 0; i < pattern.size(); i++) {
+        char c = pattern[i];
+        if (c == '\\' && i + 1 < pattern.size()) {
+            literal += pattern[++i];
+            continue;
+        }
+        if (c != '{') {
+            literal += c;
+            continue;
+        }
+        size_t close = pattern.find('}', i);
+        if (close == std::string::npos) {
+            *error = "unterminated capture in: " + pattern;
+            return false;
+        }
+        std::string body = pattern.substr(i + 1, close - i - 1);
+        i = close;
+        std::string name = body;
+        std::string spec;
+        size_t colon = body.find(':');
+        if (colon != std::string::npos) {
+            name = body.substr(0, colon);
+            spec = body.substr(colon + 1);
+        }
+        if (name.empty() || name[0] == '$') {
+            *error = "bad capture name '" + name + "' in: " + pattern;
+            return false;
+        }
+        if (rule->captureNames.size() == kMaxCaptures) {
+            *error = "too many captures in: " + pattern;
+            return false;
+        }
+
+        flushLiteral();
+        RuleSegment seg;
+        seg.kind = RuleSegment::Capture;
+        seg.capture = (int)rule->captureNames.size();
+        rule->captureNames.push_back(name);
+        if (!spec.empty()) {
+            SpecDfa dfa;
+            if (!dfa.compile(spec, error)) return false;
+            seg.dfa = (int)rule->dfas.size();
+            rule->dfas.push_back(std::move(dfa));
+        }
+        rule->segments.push_back(seg);
+    }
+    flushLiteral();
+    return true;
+}
+
+bool MetadataRules::compileTemplate(const std::string& text, const Rule& rule, std::vector<TemplatePart>* out, std::string* error) {
+    out->clear();
+    TemplatePart part;
+    for (size_t i = 0; i < text.size(); i++) {
+        if (text[i] != '{') {
+            part.literal += text[i];
+            continue;
+        }
+        size_t close = text.find('}', i);
+        if (close == std::string::npos) {
+            *error = "unterminated reference in: " + text;
+            return false;
+        }
+        std::string name = text.substr(i + 1, close - i - 1);
+        i = close;
+        if (name == "$title") {
+            part.capture = TemplatePart::kRawTitle;
+        } else if (name == "$artist") {
+            part.capture = TemplatePart::kRawArtist;
+        } else {
+            auto it = std::find(rule.captureNames.begin(), rule.captureNames.end(), name);
+            if (it == rule.captureNames.end()) {
+                *error = "unknown capture {" + name + "} in: " + text;
+                return false;
+            }
+            part.capture = (int)(it - rule.captureNames.begin());
+        }
+        out->push_back(std::move(part));
+        part = TemplatePart();
+    }
+    if (!part.literal.empty()) out->push_back(std::move(part));
+    return true;
+}
+
+bool MetadataRules::matchRule(const Rule& rule, std::string_view title, std::string_view artist, ParsedTitle* out) {
+    MatchState m{rule, rule.matchArtist ? artist : title};
+    if (!matchFrom(m, 0, 0)) return false;
+    expand(rule.details, m, title, artist, &out->details);
+    expand(rule.state, m, title, artist, &out->state);
+    out->displayType = rule.displayType;
+    return true;
+}
+
+bool MetadataRules::load(std::string_view text, std::string* error) {
+    auto set = std::make_shared<RuleSet>();
+    std::vector<Rule>* section = nullptr;
+    Rule* rule = nullptr;
+    std::string detailsText, stateText;
+    int lineNo = 0;
+
+    auto finishRule = [&]() {
+        if (!rule) return true;
+        if (!compileTemplate(detailsText, *rule, &rule->details, error) ||
+            !compileTemplate(stateText, *rule, &rule->state, error)) {
+            return false;
+        }
+        rule = nullptr;
+        return true;
+    };
+    auto fail = [&](const std::string& message) {
+        *error = "line " + std::to_string(lineNo) + ": " + message;
+        return false;
+    };
+
+    size_t pos = 0;
+    while (pos <= text.size()) {
+        size_t eol = text.find('\n', pos);
+        if (eol == std::string_view::npos) eol = text.size();
+        std::string_view line = trim(text.substr(pos, eol - pos));
+        pos = eol + 1;
+        lineNo++;
+        if (line.empty() || line[0] == '#') continue;
+
+        if (line.front() == '[' && line.back() == ']') {
+            if (!finishRule()) return fail(*error);
+            std::string package(trim(line.substr(1, line.size() - 2)));
+            section = package == "*" ? &set->wildcard : &set->byPackage[package];
+            continue;
+        }
+
+        size_t eq = line.find('=');
+        if (eq == std::string_view::npos) return fail("expected key = value");
+        std::string_view key = trim(line.substr(0, eq));
+        std::string value(trim(line.substr(eq + 1)));
+
+        if (key == "match") {
+            if (!section) return fail("match outside a [package] section");
+            if (!finishRule()) return fail(*error);
+            section->emplace_back();
+            rule = &section->back();
+            if (!compile(value, rule, error)) return fail(*error);
+            detailsText = "{$title}";
+            stateText = "{$artist}";
+            set->ruleCount++;
+            continue;
+        }
+        if (!rule) return fail("'" + std::string(key) + "' before any match");
+        if (key == "details") {
+            detailsText = value;
+        } else if (key == "state") {
+            stateText = value;
+        } else if (key == "display") {
+            rule->displayType = displayTypeFromName(value);
+            if (rule->displayType < 0) return fail("unknown display type " + value);
+        } else if (key == "source") {
+            if (value != "title" && value != "artist") return fail("source must be title or artist");
+            rule->matchArtist = value == "artist";
+        } else {
+            return fail("unknown key " + std::string(key));
+        }
+    }
+    if (!finishRule()) return fail(*error);
+
+    LOGI("Loaded %zu metadata rules for %zu packages", set->ruleCount, set->byPackage.size());
+    std::atomic_store(&rules_, std::shared_ptr<const RuleSet>(std::move(set)));
+    return true;
+}
+
+bool MetadataRules::parse(std::string_view package, std::string_view title, std::string_view artist, ParsedTitle* out) const {
+    auto set = snapshot();
+    if (!set) return false;
+    auto it = set->byPackage.find(std::string(package));
+    if (it != set->byPackage.end()) {
+        for (const auto& rule : it->second) {
+            if (matchRule(rule, title, artist, out)) return true;
+        }
+    }
+    for (const auto& rule : set->wildcard) {
+        if (matchRule(rule, title, artist, out)) return true;
+    }
+    return false;
+}
+
+bool MetadataRules::hasRulesFor(std::string_view package) const {
+    auto set = snapshot();
+    if (!set) return false;
+    return !set->wildcard.empty() || set->byPackage.count(std::string(package));
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Per-app title parsing driven by rules from assets/metadata_rules.conf:
+//
+//   [com.stremio.one]
+//   match   = {show} - {episode:S#E#} - {episode_title}
+//   details = {show}
+//   state   = {episode} - {episode_title}
+//   display = DETAILS
+//
+// A pattern is compiled once into an anchored matcher: literal runs, untyped
+// captures (shortest match, like .*?) and typed captures whose spec is
+// compiled to a DFA ('#' = digits, '@' = letters, anything else literal).
+// Templates may also use {$title} and {$artist} for the raw fields.
+
+struct ParsedTitle {
+    std::string details;
+    std::string state;
+    int displayType = 1;  // StatusDisplayTypes.STATE
+};
+
+// DFA over bytes for a typed capture spec
+class SpecDfa {
+public:
+    bool compile(std::string_view spec, std::string* error);
+    // Calls |accept| with every end offset at which text[start, end) matches,
+    // longest first; stops early if |accept| returns true
+    template <typename F>
+    bool matchEnds(std::string_view text, size_t start, F&& accept) const;
+
+    const std::string& spec() const { return spec_; }
+
+private:
+    static constexpr int kDead = -1;
+    std::string spec_;
+    std::vector<int> transitions_;  // state * 256 + byte
+    std::vector<bool> accepting_;
+};
+
+struct RuleSegment {
+    enum Kind { Literal, Capture };
+    Kind kind = Literal;
+    std::string literal;     // Literal
+    int capture = -1;        // Capture: index into Rule::captureNames
+    int dfa = -1;            // Capture: index into Rule::dfas, -1 = any text
+};
+
+struct TemplatePart {
+    static constexpr int kRawTitle = -2;
+    static constexpr int kRawArtist = -3;
+    std::string literal;
+    int capture = -1;  // capture index, kRawTitle, kRawArtist, or -1 for literal only
+};
+
+struct Rule {
+    std::string pattern;
+    bool matchArtist = false;  // source = artist
+    std::vector<RuleSegment> segments;
+    std::vector<std::string> captureNames;
+    std::vector<SpecDfa> dfas;
+    std::vector<TemplatePart> details;
+    std::vector<TemplatePart> state;
+    int displayType = 1;
+};
+
+struct RuleSet {
+    std::unordered_map<std::string, std::vector<Rule>> byPackage;
+    std::vector<Rule> wildcard;  // [*], tried after package rules
+    size_t ruleCount = 0;
+};
+
+class MetadataRules {
+public:
+    // Parses and compiles |text|; the live rule set is replaced only on success
+    bool load(std::string_view text, std::string* error);
+
+    // False when no rule for |package| matches (caller falls back to defaults)
+    bool parse(std::string_view package, std::string_view title, std::string_view artist, ParsedTitle* out) const;
+    // Whether any rule could apply to |package|: its own section or [*]
+    bool hasRulesFor(std::string_view package) const;
+
+    std::shared_ptr<const RuleSet> snapshot() const { return std::atomic_load(&rules_); }
+
+    static bool compile(const std::string& pattern, Rule* rule, std::string* error);
+    static bool compileTemplate(const std::string& text, const Rule& rule, std::vector<TemplatePart>* out, std::string* error);
+    static bool matchRule(const Rule& rule, std::string_view title, std::string_view artist, ParsedTitle* out);
+
+private:
+    std::shared_ptr<const RuleSet> rules_;
+};
+
+extern MetadataRules g_metadataRules;
+
+template <typename F>
+bool SpecDfa::matchEnds(std::string_view text, size_t start, F&& accept) const {
+    // Record accepting offsets, then replay longest first
+    size_t ends[64];
+    int count = 0;
+    int state = 0;
+    if (accepting_[0]) ends[count++] = start;
+    for (size_t i = start; i < text.size(); i++) {
+        state = transitions_[state * 256 + (unsigned char)text[i]];
+        if (state == kDead) break;
+        if (accepting_[state]) {
+            if (count == 64) { ends[63] = i + 1; continue; }
+            ends[count++] = i + 1;
+        }
+    }
+    for (int k = count - 1; k >= 0; k--) {
+        if (accept(ends[k])) return true;
+    }
+    return false;
+}
@@ -0,0 +1,76 @@
+#include "metrics.h"
+
+MetricsRegistry g_metrics;
+
+namespace {
+
+// Threads take shard slots round robin on first use. With more live threads
+// than shards two of them share a slot, which the atomic adds keep correct.
+std::atomic<uint32_t> g_nextShard{0};
+
+} // namespace
+
+MetricsRegistry::Shard& MetricsRegistry::shard() {
+    thread_local uint32_t slot = g_nextShard.fetch_add(1, std::memory_order_relaxed) % kShards;
+    return shards_[slot];
+}
+
+uint32_t MetricsRegistry::bucketOf(uint64_t value) {
+    if (value == 0) return 0;
+    uint32_t bucket = 64 - (uint32_t)__builtin_clzll(value);
+    return bucket < kBuckets ? bucket : kBuckets - 1;
+}
+
+void MetricsRegistry::add(Counter counter, uint64_t n) {
+    shard().counters[(uint32_t)counter].fetch_add(n, std::memory_order_relaxed);
+}
+
+void MetricsRegistry::record(Histogram histogram, uint64_t value) {
+    Shard& s = shard();
+    s.sums[(uint32_t)histogram].fetch_add(value, std::memory_order_relaxed);
+    s.buckets[(uint32_t)histogram][bucketOf(value)].fetch_add(1, std::memory_order_relaxed);
+}
+
+void MetricsRegistry::setGauge(Gauge gauge, int64_t value) {
+    gauges_[(uint32_t)gauge].value.store(value, std::memory_order_relaxed);
+}
+
+void MetricsRegistry::addGauge(Gauge gauge, int64_t delta) {
+    gauges_[(uint32_t)gauge].value.fetch_add(delta, std::memory_order_relaxed);
+}
+
+uint64_t MetricsRegistry::counter(Counter counter) const {
+    uint64_t total = 0;
+    for (const Shard& s : shards_) total += s.counters[(uint32_t)counter].load(std::memory_order_relaxed);
+    return total;
+}
+
+int64_t MetricsRegistry::gauge(Gauge gauge) const {
+    return gauges_[(uint32_t)gauge].value.load(std::memory_order_relaxed);
+}
+
+std::vector<int64_t> MetricsRegistry::snapshot() const {
+    std::vector<int64_t> out;
+    out.reserve(5 + kCounters + kGauges + kHistograms * (2 + kBuckets));
+    out.insert(out.end(), {kLayoutVersion, kCounters, kGauges, kHistograms, kBuckets});
+
+    for (uint32_t c = 0; c < kCounters; c++) out.push_back((int64_t)counter((Counter)c));
+    for (uint32_t g = 0; g < kGauges; g++) out.push_back(gauge((Gauge)g));
+
+    // Not a consistent cut across shards, but every value is monotonic so a
+    // reader only ever sees slightly stale totals
+    for (uint32_t h = 0; h < kHistograms; h++) {
+        uint64_t sum = 0;
+        uint64_t buckets[kBuckets] = {};
+        for (const Shard& s : shards_) {
+            sum += s.sums[h].load(std::memory_order_relaxed);
+            for (uint32_t b = 0; b < kBuckets; b++) buckets[b] += s.buckets[h][b].load(std::memory_order_relaxed);
+        }
+        uint64_t count = 0;
+        for (uint64_t n : buckets) count += n;
+        out.push_back((int64_t)count);
+        out.push_back((int64_t)sum);
+        for (uint64_t n : buckets) out.push_back((int64_t)n);
+    }
+    return out;
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+// Process-wide health metrics, cheap enough to bump on every presence update
+// and callback wakeup. Counters and histograms are written to a per-thread
+// shard (one cache line aligned block each, so two threads never share a line)
+// and summed on read; gauges are single last-value-wins atomics.
+//
+// Appending to an enum is compatible with NativeMetrics.kt, which reads the
+// section sizes from the snapshot header. Don't reorder.
+enum class Counter : uint32_t {
+    PresenceSubmits,
+    PresenceAcks,
+    PresenceFailures,
+    Reconnects,
+    CallbackWakeups,
+    UploadAttempts,
+    UploadFailures,
+    UploadBytes,
+    ArtCacheHits,
+    ArtCacheMisses,
+    LogDropped,        // log ring full
+    LogSuppressed,     // per-call-site rate limit
+    PresenceExpiries,  // timestamped presences that ran past their end
+    LabelCacheHits,    // app labels served without asking PackageManager
+    LabelCacheMisses,
+    PresenceDeduped,   // updates identical to the acknowledged presence
+    StatusPosts,       // notification + status broadcast pairs sent
+    StatusSkips,       // ... and the ones status_surface.cpp held back
+    PrefetchIssued,    // queue items ArtPrefetcher.kt queued an upload for
+    PrefetchHits,      // ... that played while tracked
+    PrefetchWasted,    // ... that aged out unplayed
+    PrefetchNoArt,     // ... that turned out to have no art to upload
+    Count
+};
+
+enum class Gauge : uint32_t {
+    ClientStatus,      // discordpp::Client::Status
+    PresenceInFlight,  // UpdateRichPresence calls awaiting their callback
+    SchedProfile,      // SchedProfile in effect on the pump
+    PumpCpuUs,         // CPU time the pump thread has used
+    ProcessCpuUs,      // all threads, the SDK's included
+    Count
+};
+
+// Log2 buckets: bucket 0 counts zeros, bucket i values in [2^(i-1), 2^i),
+// the last one everything above
+enum class Histogram : uint32_t {
+    PresenceAckMs,
+    UploadLatencyMs,
+    Count
+};
+
+class MetricsRegistry {
+public:
+    static constexpr uint32_t kShards = 16;
+    static constexpr uint32_t kBuckets = 16;
+    static constexpr int64_t kLayoutVersion = 1;
+
+    void add(Counter counter, uint64_t n = 1);
+    void record(Histogram histogram, uint64_t value);
+    void setGauge(Gauge gauge, int64_t value);
+    void addGauge(Gauge gauge, int64_t delta);
+
+    uint64_t counter(Counter counter) const;
+    int64_t gauge(Gauge gauge) const;
+
+    // [version, counters, gauges, histograms, buckets,
+    //  counter values..., gauge values...,
+    //  per histogram: count, sum, bucket counts...]
+    std::vector<int64_t> snapshot() const;
+
+    static uint32_t bucketOf(uint64_t value);
+
+private:
+    static constexpr uint32_t kCounters = (uint32_t)Counter::Count;
+    static constexpr uint32_t kGauges = (uint32_t)Gauge::Count;
+    static constexpr uint32_t kHistograms = (uint32_t)Histogram::Count;
+
+    struct alignas(64) Shard {
+        std::atomic<uint64_t> counters[kCounters] = {};
+        std::atomic<uint64_t> sums[kHistograms] = {};
+        std::atomic<uint64_t> buckets[kHistograms][kBuckets] = {};
+    };
+
+    struct alignas(64) PaddedGauge {
+        std::atomic<int64_t> value{0};
+    };
+
+    Shard& shard();
+
+    Shard shards_[kShards];
+    PaddedGauge gauges_[kGauges];
+};
+
+extern MetricsRegistry g_metrics;
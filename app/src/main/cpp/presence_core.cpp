@@ -0,0 +1,823 @@
+#define DISCORDPP_IMPLEMENTATION
+#include "presence_core.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <thread>
+#include <vector>
+
+#include "client_pool.h"
+#include "friend_search.h"
+#include "log.h"
+#include "log_ring.h"
+#include "metrics.h"
+#include "presence_journal.h"
+#include "relationship_store.h"
+#include "startup_timeline.h"
+#include "status_block.h"
+#include "status_surface.h"
+
+std::atomic<uint64_t> g_applicationId{1435558259892293662};
+
+std::shared_ptr<discordpp::Client> g_client;
+std::atomic<bool> g_running{false};
+std::atomic<bool> g_connected{false};
+std::atomic<bool> g_freeThreaded{false};
+std::optional<discordpp::AuthorizationCodeVerifier> g_codeVerifier;
+std::mutex g_sdkMutex;
+
+static std::thread g_callbackThread;
+static std::optional<PendingActivity> g_pendingActivity;
+static std::function<void()> g_onReady;  // pump thread only
+// Set on the first Ready of a client; any later Ready is a reconnect
+static std::atomic<bool> g_wasReady{false};
+// The primary client has a presence up (guarded by g_sdkMutex)
+static bool g_primaryShowing = false;
+// End timestamp the expiry timer is armed for, 0 if none (guarded by
+// g_sdkMutex). Only an earlier end re-arms it: one armed too early finds the
+// presence hasn't ended and re-arms itself, so a run of updates costs one post.
+static int64_t g_expiryArmedEnd = 0;
+static TimerId g_expiryTimer = 0;  // pump thread only
+static std::atomic<ExpiryAction> g_expiryAction{ExpiryAction::Clear};
+// Primary client submits, and the latest one acknowledged; equal when what
+// g_pendingActivity holds is known to be up
+static std::atomic<uint64_t> g_submitSeq{0};
+static std::atomic<uint64_t> g_ackedSeq{0};
+
+// Work posted to the pump (callback) thread, run in order between RunCallbacks
+static std::mutex g_pumpMutex;
+static std::condition_variable g_pumpWake;
+static std::deque<std::function<void()>> g_pumpTasks;
+// The pump outlives any one client and sleeps while there is none; only
+// stopClient (host tools, process exit) ends it
+static std::atomic<bool> g_pumpRunning{false};
+// Set while another thread's event loop runs the pump (attachPumpDriver)
+// instead of g_callbackThread; guarded by g_pumpMutex
+static bool g_driven = false;
+static PumpDriver g_pumpDriver;
+static SchedProfile g_appliedProfile = SchedProfile::Count;  // pump thread only
+
+// UpdateRichPresence calls of the primary client awaiting their result
+static std::atomic<int> g_presenceInFlight{0};
+// Bumped, under g_sdkMutex, whenever the primary client goes away: its acks
+// never come, and a late one (already posted to the pump) counts for nothing
+static uint64_t g_inFlightEpoch = 0;
+
+// shutdownClient's progress, pump thread only: clear, let in-flight updates
+// land, Disconnect, wait for Disconnected, release. Each wait ends at the deadline.
+enum class ShutdownStage { None, Draining, Disconnecting };
+static ShutdownStage g_shutdownStage = ShutdownStage::None;
+static TimerId g_shutdownTimer = 0;
+static bool g_shutdownExpired = false;
+static std::vector<std::function<void(bool)>> g_shutdownWaiters;
+
+// Bumped by every startClient; status callbacks from older clients are ignored
+static std::atomic<uint64_t> g_clientGeneration{0};
+
+// Clients replaced by a swap, disconnecting. Released on the pump thread once
+// Disconnected, or after kRetireGrace, so SDK teardown never runs on a caller.
+struct RetiredClient {
+    std::shared_ptr<discordpp::Client> client;
+    TimerId graceTimer;
+};
+static std::vector<RetiredClient> g_retiredClients;  // pump thread only
+constexpr auto kRetireGrace = std::chrono::seconds(2);
+
+// Relationship callbacks come in bursts (a friend starting a track is a few
+// user updates), so the store publishes once they settle
+constexpr auto kFriendsPublishDelay = std::chrono::milliseconds(250);
+static TimerId g_friendsTimer = 0;  // pump thread only
+constexpr auto kPumpInterval = std::chrono::milliseconds(16);
+// Pool idle eviction, while the pool has clients
+constexpr auto kHousekeepingInterval = std::chrono::seconds(30);
+// Past a presence's end timestamp before it counts as expired: the player's
+// next track normally replaces it well within this
+constexpr int64_t kExpiryGraceMs = 5000;
+// Discord's timestamps are in seconds
+constexpr long long kTimestampSlopMs = 1000;
+
+// Every deadline the pump keeps, pump thread only. It sleeps until the
+// earliest (or, polling, the next RunCallbacks tick if that comes first).
+static TimerWheel g_timers;
+static TimerId g_housekeepingTimer = 0;
+
+static int64_t wallClockMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+static int64_t steadyMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+discordpp::Activity buildActivity(const PendingActivity& pending) {
+    discordpp::Activity activity;
+
+    activity.SetType(static_cast<discordpp::ActivityTypes>(pending.type));
+    activity.SetStatusDisplayType(static_cast<discordpp::StatusDisplayTypes>(pending.statusDisplayType));
+
+    activity.SetDetails(pending.details.c_str());
+    activity.SetState(pending.state.c_str());
+    activity.SetName(pending.appName.c_str());
+
+    if (pending.hasTimestamps) {
+        discordpp::ActivityTimestamps timestamps;
+        if (pending.start > 0) timestamps.SetStart(pending.start / 1000);
+        if (pending.end > 0) timestamps.SetEnd(pending.end / 1000);
+        activity.SetTimestamps(timestamps);
+    }
+
+    discordpp::ActivityAssets assets;
+    if (!pending.imageKey.empty()) {
+        assets.SetLargeImage(pending.imageKey.c_str());
+        assets.SetLargeText(pending.state.c_str());
+    }
+    activity.SetAssets(assets);
+    return activity;
+}
+
+int64_t expiryDelayMs(const PendingActivity& activity) {
+    if (!activity.hasTimestamps || activity.end <= 0) return -1;
+    return std::max<int64_t>(activity.end + kExpiryGraceMs - wallClockMs(), 0);
+}
+
+void setExpiryAction(ExpiryAction action) {
+    g_expiryAction = action;
+}
+
+ExpiryAction expiryAction() {
+    return g_expiryAction;
+}
+
+static void expirePresence();
+
+// Under g_sdkMutex
+static void armExpiry(int64_t end, int64_t expiresIn) {
+    g_expiryArmedEnd = end;
+    runOnPump([expiresIn] {
+        cancelPumpTimer(g_expiryTimer);
+        g_expiryTimer = schedulePumpTimer(std::chrono::milliseconds(expiresIn), [] {
+            g_expiryTimer = 0;
+            expirePresence();
+        });
+    });
+}
+
+// Whatever the primary client shows now, if it outlived its end timestamp. A
+// timer armed for an earlier presence finds one without an end, or one that
+// hasn't ended (and re-arms for it).
+static void expirePresence() {
+    bool clear = g_expiryAction == ExpiryAction::Clear;
+    {
+        std::lock_guard<std::mutex> lock(g_sdkMutex);
+        g_expiryArmedEnd = 0;
+        if (!g_pendingActivity) return;
+        int64_t expiresIn = expiryDelayMs(*g_pendingActivity);
+        if (expiresIn < 0) return;
+        if (expiresIn > 0) {
+            armExpiry(g_pendingActivity->end, expiresIn);
+            return;
+        }
+        g_metrics.add(Counter::PresenceExpiries);
+        if (clear) {
+            LOGI("Presence ended without an update; clearing it");
+            g_pendingActivity.reset();
+            if (g_primaryShowing && g_client && g_connected) g_client->ClearRichPresence();
+            g_primaryShowing = false;
+            g_presenceJournal.recordCleared(g_applicationId, wallClockMs());
+        } else {
+            LOGI("Presence ended without an update; dropping its timestamps");
+            g_pendingActivity->hasTimestamps = false;
+            g_pendingActivity->start = 0;
+            g_pendingActivity->end = 0;
+        }
+    }
+    // The service only offers the surface a change from Kotlin, which has none
+    g_statusSurface.expire(clear);
+    if (!clear) applyPendingActivity();
+}
+
+void applyPendingActivity() {
+    std::lock_guard<std::mutex> lock(g_sdkMutex);
+    if (!g_client || !g_connected || !g_pendingActivity) return;
+
+    RLOGI("Applying pending Rich Presence...");
+    discordpp::Activity activity = buildActivity(*g_pendingActivity);
+    // Journaled on submit rather than on success: after a restart this is
+    // what the app wanted shown, even if this particular call gets rejected
+    g_presenceJournal.recordActivity(g_applicationId, *g_pendingActivity, wallClockMs());
+
+    g_metrics.add(Counter::PresenceSubmits);
+    g_primaryShowing = true;
+    g_startupTimeline.mark(StartupPhase::FirstPresenceSubmitted);
+    g_metrics.addGauge(Gauge::PresenceInFlight, 1);
+    g_presenceInFlight++;
+    uint64_t seq = ++g_submitSeq;
+    uint64_t epoch = g_inFlightEpoch;
+    auto submitted = std::chrono::steady_clock::now();
+    g_client->UpdateRichPresence(activity, onPump([submitted, seq, epoch](discordpp::ClientResult result) {
+        if (epoch == g_inFlightEpoch) {
+            g_metrics.addGauge(Gauge::PresenceInFlight, -1);
+            g_presenceInFlight--;
+        }
+        g_metrics.record(Histogram::PresenceAckMs, std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - submitted).count());
+        g_metrics.add(result.Successful() ? Counter::PresenceAcks : Counter::PresenceFailures);
+        if (!result.Successful()) {
+            RLOGE("Rich Presence update failed: %s", result.Error());
+        } else {
+            RLOGI("Rich Presence updated successfully");
+            // An older ack arriving after a newer submit vouches for nothing
+            if (seq == g_submitSeq) g_ackedSeq = seq;
+            g_startupTimeline.mark(StartupPhase::FirstPresenceAcked);
+        }
+    }));
+
+    int64_t expiresIn = expiryDelayMs(*g_pendingActivity);
+    if (expiresIn >= 0 && (g_expiryArmedEnd == 0 || g_pendingActivity->end < g_expiryArmedEnd)) {
+        armExpiry(g_pendingActivity->end, expiresIn);
+    }
+}
+
+void setPendingActivity(PendingActivity activity) {
+    uint64_t applicationId = activity.applicationId;
+    if (applicationId != 0 && applicationId != g_applicationId && g_clientPool.routable(applicationId)) {
+        {
+            std::lock_guard<std::mutex> lock(g_sdkMutex);
+            // Nor should Ready bring the primary client's presence back
+            g_pendingActivity.reset();
+            if (g_primaryShowing && g_client && g_connected) g_client->ClearRichPresence();
+            g_primaryShowing = false;
+        }
+        // Under its own application id, so the primary client won't restore it
+        g_presenceJournal.recordActivity(applicationId, activity, wallClockMs());
+        g_clientPool.submit(std::move(activity));
+        return;
+    }
+    g_clientPool.clearAll();
+    {
+        std::lock_guard<std::mutex> lock(g_sdkMutex);
+        // Media callbacks repeat themselves (metadata, then playback state,
+        // then a queue change for one track); each resend spends rate limit
+        if (g_primaryShowing && g_connected && g_pendingActivity && g_ackedSeq == g_submitSeq &&
+            samePresence(*g_pendingActivity, activity)) {
+            g_metrics.add(Counter::PresenceDeduped);
+            return;
+        }
+        g_pendingActivity = std::move(activity);
+    }
+    applyPendingActivity();
+}
+
+bool samePresence(const PendingActivity& a, const PendingActivity& b) {
+    auto near = [](long long x, long long y) { return x - y < kTimestampSlopMs && y - x < kTimestampSlopMs; };
+    return a.details == b.details && a.state == b.state && a.imageKey == b.imageKey && a.appName == b.appName &&
+           a.type == b.type && a.statusDisplayType == b.statusDisplayType && a.applicationId == b.applicationId &&
+           a.hasTimestamps == b.hasTimestamps && near(a.start, b.start) && near(a.end, b.end);
+}
+
+// After process death Kotlin has nothing to send until the next media
+// callback; until then, show what was last sent if it's still current
+static void restoreJournaledActivity() {
+    int64_t now = wallClockMs();
+    {
+        std::lock_guard<std::mutex> lock(g_sdkMutex);
+        PendingActivity restored;
+        if (!g_pendingActivity && g_presenceJournal.restorable(g_applicationId, now, &restored)) {
+            LOGI("Restoring journaled presence: %s", restored.details.c_str());
+            g_pendingActivity = std::move(restored);
+        }
+    }
+    g_presenceJournal.recordReady(g_applicationId, now);
+}
+
+void runOnPump(std::function<void()> task) {
+    if (!g_pumpRunning) {
+        task();
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(g_pumpMutex);
+        g_pumpTasks.push_back(std::move(task));
+        if (g_driven) {
+            g_pumpDriver.wake();
+            return;
+        }
+    }
+    g_pumpWake.notify_one();
+}
+
+static void runPumpTasks() {
+    std::deque<std::function<void()>> tasks;
+    {
+        std::lock_guard<std::mutex> lock(g_pumpMutex);
+        tasks.swap(g_pumpTasks);
+    }
+    for (auto& task : tasks) task();
+}
+
+TimerId schedulePumpTimer(std::chrono::milliseconds delay, std::function<void()> fn) {
+    return g_timers.schedule(steadyMs(), delay.count(), std::move(fn));
+}
+
+bool cancelPumpTimer(TimerId id) {
+    return g_timers.cancel(id);
+}
+
+void retireClient(std::shared_ptr<discordpp::Client> client) {
+    discordpp::Client* retired = client.get();
+    TimerId graceTimer = schedulePumpTimer(kRetireGrace, [retired] {
+        auto it = std::find_if(g_retiredClients.begin(), g_retiredClients.end(),
+                               [retired](const RetiredClient& r) { return r.client.get() == retired; });
+        if (it != g_retiredClients.end()) g_retiredClients.erase(it);
+    });
+    g_retiredClients.push_back({std::move(client), graceTimer});
+}
+
+static void releaseRetiredClients(bool all) {
+    for (auto it = g_retiredClients.begin(); it != g_retiredClients.end();) {
+        if (all || it->client->GetStatus() == discordpp::Client::Status::Disconnected) {
+            cancelPumpTimer(it->graceTimer);
+            it = g_retiredClients.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+// Under g_sdkMutex, as the primary client is dropped or replaced
+static void forgetPresenceInFlight() {
+    g_inFlightEpoch++;
+    int dropped = g_presenceInFlight.exchange(0);
+    if (dropped) g_metrics.addGauge(Gauge::PresenceInFlight, -dropped);
+}
+
+static void finishShutdown(bool clean) {
+    g_shutdownStage = ShutdownStage::None;
+    cancelPumpTimer(g_shutdownTimer);
+    g_shutdownTimer = 0;
+    auto waiters = std::move(g_shutdownWaiters);
+    g_shutdownWaiters.clear();
+    for (auto& waiter : waiters) waiter(clean);
+}
+
+static void advanceShutdown() {
+    bool expired = g_shutdownExpired;
+    if (g_shutdownStage == ShutdownStage::Draining) {
+        if (g_presenceInFlight > 0 && !expired) return;
+        LOGI("Shutdown: disconnecting (%d updates still in flight)", g_presenceInFlight.load());
+        g_client->Disconnect();
+        g_shutdownStage = ShutdownStage::Disconnecting;
+        // Out of time: drop it now rather than wait for Disconnected
+        if (!expired) return;
+    }
+    if (g_client->GetStatus() != discordpp::Client::Status::Disconnected && !expired) return;
+    if (expired) LOGE("Shutdown: deadline passed, dropping the client anyway");
+    std::shared_ptr<discordpp::Client> client;
+    {
+        std::lock_guard<std::mutex> lock(g_sdkMutex);
+        client = std::move(g_client);
+        g_codeVerifier.reset();
+        forgetPresenceInFlight();
+    }
+    client.reset();  // SDK teardown, here on the pump
+    g_relationshipStore.clear();
+    g_relationshipStore.publish();
+    g_friendSearch.clear();
+    g_metrics.setGauge(Gauge::ClientStatus, (int64_t)discordpp::Client::Status::Disconnected);
+    g_statusBlock.setConnection((int)discordpp::Client::Status::Disconnected);
+    LOGI("Shutdown complete");
+    finishShutdown(!expired);
+}
+
+static int64_t cpuTimeUs(clockid_t clock) {
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+// Pump thread: the pump itself and every live client follow the profile
+static void applySchedProfile() {
+    g_schedPolicy.applyToCurrentThread();
+    {
+        std::lock_guard<std::mutex> lock(g_sdkMutex);
+        if (g_client) g_schedPolicy.applyToClient(*g_client);
+    }
+    g_clientPool.applySchedPolicy();
+    g_metrics.setGauge(Gauge::SchedProfile, (int64_t)g_schedPolicy.profile());
+}
+
+void setSchedProfile(SchedProfile profile) {
+    g_schedPolicy.setProfile(profile);
+    // Wakes the pump, which notices the change before its next wait
+    if (g_pumpRunning) runOnPump([] {});
+}
+
+static bool hasClients() {
+    return g_client || !g_clientPool.empty() || !g_retiredClients.empty();
+}
+
+static bool pumpIdle() {
+    return !hasClients() && g_timers.empty();
+}
+
+static void updateHousekeeping() {
+    if (g_clientPool.empty()) {
+        cancelPumpTimer(g_housekeepingTimer);
+        g_housekeepingTimer = 0;
+    } else if (!g_housekeepingTimer) {
+        g_housekeepingTimer = schedulePumpTimer(kHousekeepingInterval, [] {
+            g_housekeepingTimer = 0;
+            g_clientPool.tick(steadyMs());
+        });
+    }
+}
+
+// Free-threaded, the pump only wakes for posted work (SDK callbacks included)
+// and timers; polling, also for the next RunCallbacks tick
+static std::chrono::steady_clock::time_point nextPumpDeadline() {
+    int64_t timer = g_timers.nextDeadlineMs();
+    auto next = timer == INT64_MAX ? std::chrono::steady_clock::time_point::max()
+                                   : std::chrono::steady_clock::time_point(std::chrono::milliseconds(timer));
+    if (!g_freeThreaded && hasClients()) next = std::min(next, std::chrono::steady_clock::now() + kPumpInterval);
+    return next;
+}
+
+bool enableFreeThreaded() {
+    if (g_clientGeneration > 0) {
+        LOGE("Free-threaded SDK mode must be chosen before the first client");
+        return g_freeThreaded;
+    }
+    if (!g_freeThreaded.exchange(true)) {
+        Discord_SetFreeThreaded();
+        LOGI("Discord SDK callbacks are free-threaded");
+    }
+    return true;
+}
+
+// One pass of the pump, on whichever thread runs it. Returns when it next
+// needs to run without being posted to; max() for never (no clients or timers).
+static std::chrono::steady_clock::time_point pumpOnce() {
+    runPumpTasks();
+    if (g_schedPolicy.profile() != g_appliedProfile) {
+        g_appliedProfile = g_schedPolicy.profile();
+        applySchedProfile();
+    }
+    if (pumpIdle()) return std::chrono::steady_clock::time_point::max();
+
+    if (!g_freeThreaded) discordpp::RunCallbacks();
+    g_metrics.add(Counter::CallbackWakeups);
+    g_metrics.setGauge(Gauge::PumpCpuUs, cpuTimeUs(CLOCK_THREAD_CPUTIME_ID));
+    g_metrics.setGauge(Gauge::ProcessCpuUs, cpuTimeUs(CLOCK_PROCESS_CPUTIME_ID));
+    g_timers.advance(steadyMs());
+    if (!g_retiredClients.empty()) releaseRetiredClients(false);
+    if (g_shutdownStage != ShutdownStage::None) advanceShutdown();
+    updateHousekeeping();
+    return nextPumpDeadline();
+}
+
+static void runCallbackLoop() {
+    LOGI("Callback loop started");
+    while (true) {
+        auto deadline = pumpOnce();
+        // Posted work cuts the wait short
+        std::unique_lock<std::mutex> lock(g_pumpMutex);
+        auto woken = [] { return !g_pumpTasks.empty() || !g_pumpRunning || g_driven; };
+        if (deadline == std::chrono::steady_clock::time_point::max()) {
+            g_pumpWake.wait(lock, woken);
+        } else {
+            g_pumpWake.wait_until(lock, deadline, woken);
+        }
+        if (g_driven) {
+            LOGI("Callback loop handed over to an event loop");
+            return;
+        }
+        if (!g_pumpRunning) break;
+    }
+    g_clientPool.reset();
+    releaseRetiredClients(true);
+    g_timers.clear();
+    g_housekeepingTimer = 0;
+    g_expiryTimer = 0;
+    g_shutdownTimer = 0;
+    {
+        std::lock_guard<std::mutex> lock(g_pumpMutex);
+        g_pumpTasks.clear();
+    }
+    LOGI("Callback loop stopped");
+}
+
+void attachPumpDriver(PumpDriver driver) {
+    {
+        std::lock_guard<std::mutex> lock(g_pumpMutex);
+        if (g_driven) return;
+        g_pumpDriver = std::move(driver);
+        g_driven = true;
+        g_pumpRunning = true;
+    }
+    g_pumpWake.notify_one();
+    // Whatever the thread was doing finishes first; from here on pump state
+    // belongs to the caller's thread
+    if (g_callbackThread.joinable()) g_callbackThread.join();
+    // The new thread gets the profile too
+    g_appliedProfile = SchedProfile::Count;
+    g_pumpDriver.wake();
+}
+
+std::chrono::steady_clock::time_point runDrivenPump() {
+    {
+        std::lock_guard<std::mutex> lock(g_pumpMutex);
+        if (!g_driven) return std::chrono::steady_clock::time_point::max();
+    }
+    return pumpOnce();
+}
+
+void detachPumpDriver() {
+    {
+        std::lock_guard<std::mutex> lock(g_pumpMutex);
+        if (!g_driven) return;
+        g_driven = false;
+        g_pumpDriver = PumpDriver();
+    }
+    // Back on a thread of our own, which picks up anything still queued (a
+    // shutdown in progress, say)
+    g_appliedProfile = SchedProfile::Count;
+    g_callbackThread = std::thread(runCallbackLoop);
+}
+
+// Null unless |relationship| is a Discord friend. GameActivity is what they
+// are doing in this application, which is what the friends panel shows.
+static std::optional<FriendInfo> readFriend(const discordpp::RelationshipHandle& relationship) {
+    if (relationship.DiscordRelationshipType() != discordpp::RelationshipType::Friend) return {};
+    auto user = relationship.User();
+    if (!user) return {};
+    FriendInfo info;
+    info.userId = relationship.Id();
+    info.displayName = user->DisplayName();
+    info.username = user->Username();
+    info.status = (int)user->Status();
+    if (auto activity = user->GameActivity()) {
+        info.activityType = (int)activity->Type();
+        info.activityName = activity->Name();
+        info.details = activity->Details().value_or("");
+        info.state = activity->State().value_or("");
+    }
+    return info;
+}
+
+static void scheduleFriendsPublish() {
+    if (g_friendsTimer) return;
+    g_friendsTimer = schedulePumpTimer(kFriendsPublishDelay, [] {
+        g_friendsTimer = 0;
+        g_relationshipStore.publish();
+    });
+}
+
+// Pump thread: one relationship created, deleted or updated
+static void refreshFriend(uint64_t userId) {
+    if (!g_client) return;
+    auto info = readFriend(g_client->GetRelationshipHandle(userId));
+    bool changed;
+    if (info) {
+        g_friendSearch.update(*info);
+        changed = g_relationshipStore.upsert(*info);
+    } else {
+        g_friendSearch.remove(userId);
+        changed = g_relationshipStore.remove(userId);
+    }
+    if (changed) scheduleFriendsPublish();
+}
+
+// Pump thread, on Ready: the whole list once, diffed against what the store
+// has, so a reconnect only republishes friends that changed while away
+static void loadFriends() {
+    std::vector<FriendInfo> friends;
+    for (const auto& relationship : g_client->GetRelationships()) {
+        if (auto info = readFriend(relationship)) friends.push_back(std::move(*info));
+    }
+    g_relationshipStore.replaceAll(friends);
+    g_friendSearch.replaceAll(friends);
+    LOGI("Loaded %zu friends", g_relationshipStore.size());
+    scheduleFriendsPublish();
+}
+
+// Runs on the pump thread: builds the new client and swaps it in under
+// g_sdkMutex, so presence calls see either the old client or the new one
+static void swapClient(uint64_t generation, std::function<void()> onReady) {
+    // Affinity can only be given at creation; priorities are set right after
+    auto client = std::make_shared<discordpp::Client>(g_schedPolicy.createOptions());
+    g_schedPolicy.applyToClient(*client);
+
+    // Runs on SDK threads, so the message is only copied into the log ring here
+    client->AddLogCallback([](auto message, auto severity) {
+        switch (severity) {
+            case discordpp::LoggingSeverity::Error: RLOGE("[Discord SDK] %s", message); break;
+            case discordpp::LoggingSeverity::Warning: RLOGW("[Discord SDK] %s", message); break;
+            default: RLOGI("[Discord SDK] %s", message); break;
+        }
+    }, discordpp::LoggingSeverity::Info);
+
+    client->SetStatusChangedCallback(onPump([generation](discordpp::Client::Status status, discordpp::Client::Error error, int32_t errorDetail) {
+        if (generation != g_clientGeneration) return;  // a retired client disconnecting
+        RLOGI("Status changed: %s", discordpp::Client::StatusToString(status));
+        g_metrics.setGauge(Gauge::ClientStatus, (int64_t)status);
+        g_statusBlock.setConnection((int)status);
+        if (status == discordpp::Client::Status::Ready) {
+            LOGI("Client is ready");
+            g_startupTimeline.mark(StartupPhase::Ready);
+            if (g_wasReady.exchange(true)) g_metrics.add(Counter::Reconnects);
+            g_connected = true;
+            loadFriends();
+            restoreJournaledActivity();
+            // Apply any pending activity that was set before connection
+            applyPendingActivity();
+            if (g_onReady) g_onReady();
+        } else if (error != discordpp::Client::Error::None) {
+            LOGE("Connection Error: %s Detail: %d", discordpp::Client::ErrorToString(error).c_str(), errorDetail);
+            g_connected = false;
+        }
+    }));
+
+    // Relationship changes arrive as created/deleted, everything about the
+    // user (name, status, activity) as user updates, for friends or not
+    client->SetRelationshipCreatedCallback(onPump([generation](uint64_t userId, bool) {
+        if (generation == g_clientGeneration) refreshFriend(userId);
+    }));
+    client->SetRelationshipDeletedCallback(onPump([generation](uint64_t userId, bool) {
+        if (generation == g_clientGeneration) refreshFriend(userId);
+    }));
+    client->SetUserUpdatedCallback(onPump([generation](uint64_t userId) {
+        if (generation == g_clientGeneration && g_relationshipStore.contains(userId)) refreshFriend(userId);
+    }));
+
+    auto verifier = client->CreateAuthorizationCodeVerifier();
+
+    std::shared_ptr<discordpp::Client> old;
+    {
+        std::lock_guard<std::mutex> lock(g_sdkMutex);
+        if (generation != g_clientGeneration) return;  // another swap was posted after this one
+        old = std::move(g_client);
+        g_client = std::move(client);
+        g_codeVerifier = std::move(verifier);
+        g_onReady = std::move(onReady);
+        g_wasReady = false;
+        if (old) forgetPresenceInFlight();
+    }
+    g_startupTimeline.mark(StartupPhase::ClientStarted);
+    if (g_shutdownStage != ShutdownStage::None) {
+        // Started again mid-shutdown: the old client is retired below instead
+        LOGI("Shutdown superseded by a new client");
+        finishShutdown(true);
+    }
+    if (old) {
+        LOGI("Client swapped for application %llu; retiring the old one", (unsigned long long)g_applicationId.load());
+        old->Disconnect();
+        retireClient(std::move(old));
+    }
+}
+
+void startClient(uint64_t applicationId, std::function<void()> onReady) {
+    // Synchronously, so presence set from here on is journaled under the new
+    // application and held (not sent to the old client) until the new one is Ready
+    g_applicationId = applicationId;
+    g_connected = false;
+    g_running = true;
+    uint64_t generation = ++g_clientGeneration;
+
+    {
+        std::lock_guard<std::mutex> lock(g_pumpMutex);
+        if (!g_pumpRunning.exchange(true) && !g_driven) g_callbackThread = std::thread(runCallbackLoop);
+    }
+    runOnPump([generation, onReady = std::move(onReady)]() mutable { swapClient(generation, std::move(onReady)); });
+}
+
+void shutdownClient(std::chrono::milliseconds budget, std::function<void(bool clean)> onDone) {
+    g_running = false;
+    runOnPump([budget, onDone = std::move(onDone)]() mutable {
+        g_shutdownWaiters.push_back(std::move(onDone));
+        if (g_shutdownStage != ShutdownStage::None) return;  // already on its way
+        if (!g_client) {
+            finishShutdown(true);
+            return;
+        }
+        LOGI("Shutting down Discord SDK");
+        {
+            std::lock_guard<std::mutex> lock(g_sdkMutex);
+            g_pendingActivity.reset();
+            if (g_primaryShowing && g_connected) g_client->ClearRichPresence();
+            g_primaryShowing = false;
+            g_connected = false;
+        }
+        g_clientPool.retireAll();
+        g_shutdownExpired = false;
+        g_shutdownTimer = schedulePumpTimer(budget, [] {
+            g_shutdownTimer = 0;
+            g_shutdownExpired = true;
+        });
+        g_shutdownStage = ShutdownStage::Draining;
+    });
+}
+
+void stopClient() {
+    LOGI("Stopping the callback pump");
+    detachPumpDriver();
+    g_running = false;
+    g_connected = false;
+    {
+        // Under the mutex, or the store can land between the loop's predicate
+        // check and its wait, and the notify with it
+        std::lock_guard<std::mutex> lock(g_pumpMutex);
+        g_pumpRunning = false;
+    }
+    g_pumpWake.notify_one();
+    // Joined outside g_sdkMutex: the pump takes it for swaps and presence callbacks
+    if (g_callbackThread.joinable()) {
+        g_callbackThread.join();
+    }
+    std::lock_guard<std::mutex> lock(g_sdkMutex);
+    g_client.reset();
+    forgetPresenceInFlight();
+    g_expiryArmedEnd = 0;  // the pump dropped its timers
+}
+
+void connectClient() {
+    runOnPump([]() {
+        if (!g_client) {
+            LOGE("Client not initialized! Cannot connect");
+            return;
+        }
+        LOGI("Connecting to Discord Gateway");
+        g_client->Connect();
+    });
+}
+
+void clearPresence() {
+    std::lock_guard<std::mutex> lock(g_sdkMutex);
+    // Even when offline, so neither Ready nor a restart brings it back
+    g_pendingActivity.reset();
+    g_primaryShowing = false;
+    g_clientPool.clearAll();
+    g_presenceJournal.recordCleared(g_applicationId, wallClockMs());
+    if (!g_client || !g_connected) {
+        LOGE("clearActivity: Client not ready or not connected");
+        return;
+    }
+    LOGI("Clearing Rich Presence activity");
+    g_client->ClearRichPresence();
+}
+
+void exchangeAuthorizationCode(const std::string& code, const std::string& redirectUri,
+                               std::function<void(const std::string& accessToken, const std::string& refreshToken)> onTokens) {
+    runOnPump([code, redirectUri, onTokens]() {
+        if (!g_client || !g_codeVerifier) {
+            LOGE("Client not initialized! Cannot exchange authorization code");
+            return;
+        }
+        g_client->GetToken(g_applicationId, code, g_codeVerifier->Verifier(), redirectUri,
+            onPump([onTokens](discordpp::ClientResult result, std::string accessToken, std::string refreshToken, discordpp::AuthorizationTokenType tokenType, int32_t expiresIn, std::string scope) {
+                LOGI("GetToken callback triggered");
+                if (!result.Successful()) {
+                    LOGE("GetToken Error: %s", result.Error().c_str());
+                    return;
+                }
+                LOGI("Access token received!");
+                onTokens(accessToken, refreshToken);
+                g_clientPool.setParentToken(accessToken);
+                if (!g_client) return;  // shut down meanwhile
+
+                g_client->UpdateToken(discordpp::AuthorizationTokenType::Bearer, accessToken, onPump([](discordpp::ClientResult result) {
+                    if (result.Successful()) {
+                        LOGI("Token updated, connecting...");
+                        g_startupTimeline.mark(StartupPhase::TokenRestored);
+                        if (g_client) g_client->Connect();
+                    } else {
+                        LOGE("UpdateToken Error: %s", result.Error().c_str());
+                    }
+                }));
+            }));
+    });
+}
+
+void restoreToken(const std::string& accessToken) {
+    runOnPump([accessToken]() {
+        if (!g_client) {
+            LOGE("Client not initialized! Cannot restore session");
+            return;
+        }
+
+        LOGI("Restoring session with saved token");
+        g_client->UpdateToken(discordpp::AuthorizationTokenType::Bearer, accessToken, onPump([accessToken](discordpp::ClientResult result) {
+             if (result.Successful()) {
+                 LOGI("Token restored");
+                 g_clientPool.setParentToken(accessToken);
+                 g_startupTimeline.mark(StartupPhase::TokenRestored);
+                 // Connect after successfully updating token
+                 LOGI("Connecting after token restore");
+                 if (g_client) g_client->Connect();
+             } else {
+                 LOGE("Failed to restore token: %s", result.Error().c_str());
+             }
+        }));
+    });
+}
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+
+#include "discordpp.h"
+#include "sched_policy.h"
+#include "timer_wheel.h"
+
+// Everything between the JNI entry points and the Discord SDK: the client,
+// the thread pumping its callbacks and the presence last requested by the
+// app. Nothing here touches JNI, so host tools can drive it against
+// host/fake_discord_sdk instead of the partner SDK.
+
+struct PendingActivity {
+    std::string details;
+    std::string state;
+    std::string imageKey;
+    std::string appName;
+    long long start = 0;
+    long long end = 0;
+    int type = 2; // Default to Listening
+    int statusDisplayType = 0;
+    bool hasTimestamps = false;
+    // Discord application to show it under; 0 = the primary client's
+    uint64_t applicationId = 0;
+};
+
+extern std::atomic<uint64_t> g_applicationId;
+extern std::shared_ptr<discordpp::Client> g_client;
+extern std::atomic<bool> g_running;
+extern std::atomic<bool> g_connected;
+extern std::optional<discordpp::AuthorizationCodeVerifier> g_codeVerifier;
+extern std::mutex g_sdkMutex;
+// The SDK delivers callbacks on its own threads instead of from RunCallbacks
+extern std::atomic<bool> g_freeThreaded;
+
+// Creates the client, or replaces it: the new client is built on the pump
+// (callback) thread and swapped in there, and the old one disconnects and is
+// released there too, so this never blocks on SDK teardown or a join. Pending
+// presence carries over and goes out once the new client is Ready. |onReady|
+// runs on the pump thread each time the client reaches Ready.
+void startClient(uint64_t applicationId, std::function<void()> onReady);
+// Returns at once. On the pump: clears the presence, lets in-flight updates
+// land, disconnects and releases the client, giving each step until |budget|
+// from now is spent; then calls |onDone| there, with false if it had to cut a
+// step short. A startClient in the meantime supersedes it (onDone(true)).
+void shutdownClient(std::chrono::milliseconds budget, std::function<void(bool clean)> onDone);
+// Blocking: also ends and joins the pump thread. For host tools and exit.
+void stopClient();
+// Applies to the pump thread and all clients from their next pump iteration
+void setSchedProfile(SchedProfile profile);
+void connectClient();
+// Runs |task| on the pump thread after everything posted before it, client
+// swaps included; inline when the pump isn't running
+void runOnPump(std::function<void()> task);
+// Switches the SDK to free-threaded callbacks and the pump from polling
+// RunCallbacks to sleeping until work is posted. The SDK only allows this
+// before the first client is created; false (and no change) after that.
+bool enableFreeThreaded();
+
+// Lets another thread's event loop (a Looper, looper_pump.cpp) run the pump
+// instead of g_callbackThread. The driver's wake() is called, under a lock,
+// whenever work is posted; the loop then calls runDrivenPump on its thread,
+// and again by the time it returns (max() = only when woken).
+struct PumpDriver {
+    std::function<void()> wake;
+};
+// From the loop's thread. Joins g_callbackThread if it was running.
+void attachPumpDriver(PumpDriver driver);
+std::chrono::steady_clock::time_point runDrivenPump();
+// From the loop's thread, before it quits; the pump gets its own thread back
+void detachPumpDriver();
+
+// Wraps an SDK callback so its body runs on the pump in either mode: polling,
+// RunCallbacks already calls it there; free-threaded, it arrives on an SDK
+// thread and is posted, so client state still has one owner
+template <typename F>
+auto onPump(F fn) {
+    return [fn = std::move(fn)](auto... args) mutable {
+        if (!g_freeThreaded) {
+            fn(std::move(args)...);
+            return;
+        }
+        runOnPump([fn, args...]() mutable { fn(std::move(args)...); });
+    };
+}
+// Pump thread only: runs |fn| on the pump once |delay| has passed. The pump
+// sleeps until the earliest of these is due, whichever thread drives it.
+TimerId schedulePumpTimer(std::chrono::milliseconds delay, std::function<void()> fn);
+// Pump thread only; false if it already ran or was cancelled
+bool cancelPumpTimer(TimerId id);
+// Pump thread only: disconnects happen elsewhere; this keeps |client| alive
+// until it reports Disconnected (or a grace period passes), then releases it
+void retireClient(std::shared_ptr<discordpp::Client> client);
+
+// Stores |activity| and sends it now if connected, otherwise once Ready.
+// Activity for another application goes to that application's pool client
+// (client_pool.h) instead, and what the primary client showed is cleared.
+// An update identical to the acknowledged one is dropped rather than resent.
+void setPendingActivity(PendingActivity activity);
+// Same text, image, type and application, with timestamps within a second of
+// each other: Discord shows them to the second, and Kotlin's start (now minus
+// playback position) drifts by a few ms between callbacks for one track
+bool samePresence(const PendingActivity& a, const PendingActivity& b);
+discordpp::Activity buildActivity(const PendingActivity& pending);
+
+// What becomes of a presence whose end timestamp has passed (plus a grace
+// period) with no newer update: the player stopped without telling us. The
+// pump handles it on a timer armed at submit, without a round trip to Kotlin.
+enum class ExpiryAction { Clear, Untimed };
+void setExpiryAction(ExpiryAction action);
+ExpiryAction expiryAction();
+// Until |activity| expires, 0 if it already has; -1 if it has no end timestamp
+int64_t expiryDelayMs(const PendingActivity& activity);
+void applyPendingActivity();
+void clearPresence();
+
+// Exchanges an OAuth code, hands the tokens to |onTokens| and connects
+void exchangeAuthorizationCode(const std::string& code, const std::string& redirectUri,
+                               std::function<void(const std::string& accessToken, const std::string& refreshToken)> onTokens);
+// Connects with a saved access token
+void restoreToken(const std::string& accessToken);
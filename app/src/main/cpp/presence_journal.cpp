@@ -0,0 +1,284 @@
+#include "presence_journal.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "log.h"
+
+PresenceJournal g_presenceJournal;
+
+namespace {
+
+constexpr uint32_t kMagic = 0x314A5044;  // "DPJ1"
+constexpr uint32_t kVersion = 1;
+constexpr size_t kHeaderBytes = 64;
+constexpr size_t kSlotBytes = (PresenceJournal::kFileBytes - kHeaderBytes) / 2;
+// Discord caps details/state at 128 characters; image URLs are the longest
+constexpr size_t kMaxString = 448;
+
+struct FileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t slotBytes;
+    uint32_t reserved;
+};
+
+struct SlotHeader {
+    uint64_t generation;  // 0 = never written
+    uint32_t checksum;
+    uint32_t length;
+};
+
+constexpr size_t kPayloadBytes = kSlotBytes - sizeof(SlotHeader);
+
+enum Flags : uint8_t {
+    kHasTimestamps = 1,
+    kCleared = 2,
+};
+
+uint32_t checksumOf(uint64_t generation, uint32_t length, const uint8_t* payload) {
+    // FNV-1a over the slot header fields and the payload
+    uint64_t h = 1469598103934665603ull;
+    auto mix = [&h](const uint8_t* p, size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            h ^= p[i];
+            h *= 1099511628211ull;
+        }
+    };
+    mix(reinterpret_cast<const uint8_t*>(&generation), sizeof(generation));
+    mix(reinterpret_cast<const uint8_t*>(&length), sizeof(length));
+    mix(payload, length);
+    return (uint32_t)(h ^ (h >> 32));
+}
+
+class PayloadWriter {
+public:
+    explicit PayloadWriter(uint8_t* out) : out_(out) {}
+
+    template <typename T>
+    void put(T value) {
+        std::memcpy(out_ + size_, &value, sizeof(T));
+        size_ += sizeof(T);
+    }
+
+    void putString(const std::string& s) {
+        uint16_t length = (uint16_t)std::min(s.size(), kMaxString);
+        put(length);
+        std::memcpy(out_ + size_, s.data(), length);
+        size_ += length;
+    }
+
+    uint32_t size() const { return (uint32_t)size_; }
+
+private:
+    uint8_t* out_;
+    size_t size_ = 0;
+};
+
+class PayloadReader {
+public:
+    PayloadReader(const uint8_t* in, size_t size) : in_(in), size_(size) {}
+
+    template <typename T>
+    bool get(T* value) {
+        if (size_ - offset_ < sizeof(T)) return false;
+        std::memcpy(value, in_ + offset_, sizeof(T));
+        offset_ += sizeof(T);
+        return true;
+    }
+
+    bool getString(std::string* s) {
+        uint16_t length;
+        if (!get(&length) || size_ - offset_ < length) return false;
+        s->assign(reinterpret_cast<const char*>(in_ + offset_), length);
+        offset_ += length;
+        return true;
+    }
+
+private:
+    const uint8_t* in_;
+    size_t size_;
+    size_t offset_ = 0;
+};
+
+} // namespace
+
+PresenceJournal::~PresenceJournal() {
+    close();
+}
+
+bool PresenceJournal::open(const std::string& path, std::string* error) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (map_ && path == path_) return true;
+    if (map_) {
+        munmap(map_, kFileBytes);
+        map_ = nullptr;
+    }
+
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        *error = "open: " + std::string(std::strerror(errno));
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (st.st_size != (off_t)kFileBytes && ftruncate(fd, kFileBytes) != 0)) {
+        *error = "resize: " + std::string(std::strerror(errno));
+        ::close(fd);
+        return false;
+    }
+    void* map = mmap(nullptr, kFileBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED) {
+        *error = "mmap: " + std::string(std::strerror(errno));
+        return false;
+    }
+    map_ = static_cast<uint8_t*>(map);
+    path_ = path;
+
+    FileHeader header;
+    std::memcpy(&header, map_, sizeof(header));
+    if (header.magic != kMagic || header.version != kVersion || header.slotBytes != kSlotBytes) {
+        // New file, or one from an incompatible build: start empty
+        std::memset(map_, 0, kFileBytes);
+        header = {kMagic, kVersion, (uint32_t)kSlotBytes, 0};
+        std::memcpy(map_, &header, sizeof(header));
+        msync(map_, kFileBytes, MS_ASYNC);
+    }
+    return true;
+}
+
+void PresenceJournal::close() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!map_) return;
+    msync(map_, kFileBytes, MS_SYNC);
+    munmap(map_, kFileBytes);
+    map_ = nullptr;
+    path_.clear();
+}
+
+bool PresenceJournal::readSlot(int slot, JournalEntry* entry) const {
+    const uint8_t* base = map_ + kHeaderBytes + slot * kSlotBytes;
+    SlotHeader header;
+    std::memcpy(&header, base, sizeof(header));
+    if (header.generation == 0 || header.length > kPayloadBytes) return false;
+    const uint8_t* payload = base + sizeof(SlotHeader);
+    if (checksumOf(header.generation, header.length, payload) != header.checksum) return false;
+
+    PayloadReader reader(payload, header.length);
+    PendingActivity& a = entry->activity;
+    uint8_t flags;
+    int32_t type, displayType;
+    bool ok = reader.get(&entry->applicationId) && reader.get(&entry->writtenAtMs) &&
+              reader.get(&entry->lastReadyMs) && reader.get(&a.start) && reader.get(&a.end) &&
+              reader.get(&type) && reader.get(&displayType) && reader.get(&flags) &&
+              reader.getString(&a.details) && reader.getString(&a.state) &&
+              reader.getString(&a.imageKey) && reader.getString(&a.appName);
+    if (!ok) return false;
+    a.type = type;
+    a.statusDisplayType = displayType;
+    a.hasTimestamps = flags & kHasTimestamps;
+    entry->cleared = flags & kCleared;
+    entry->generation = header.generation;
+    return true;
+}
+
+int PresenceJournal::newestSlot(JournalEntry* entry) const {
+    JournalEntry slots[2];
+    bool valid[2] = {readSlot(0, &slots[0]), readSlot(1, &slots[1])};
+    int newest = -1;
+    if (valid[0]) newest = 0;
+    if (valid[1] && (newest < 0 || slots[1].generation > slots[0].generation)) newest = 1;
+    if (newest >= 0 && entry) *entry = std::move(slots[newest]);
+    return newest;
+}
+
+void PresenceJournal::write(const JournalEntry& entry) {
+    JournalEntry current;
+    int newest = newestSlot(&current);
+    int target = newest < 0 ? 0 : newest ^ 1;
+    uint64_t generation = (newest < 0 ? 0 : current.generation) + 1;
+
+    uint8_t payload[kPayloadBytes];
+    PayloadWriter writer(payload);
+    const PendingActivity& a = entry.activity;
+    writer.put(entry.applicationId);
+    writer.put(entry.writtenAtMs);
+    writer.put(entry.lastReadyMs);
+    writer.put(a.start);
+    writer.put(a.end);
+    writer.put((int32_t)a.type);
+    writer.put((int32_t)a.statusDisplayType);
+    writer.put((uint8_t)((a.hasTimestamps ? kHasTimestamps : 0) | (entry.cleared ? kCleared : 0)));
+    writer.putString(a.details);
+    writer.putString(a.state);
+    writer.putString(a.imageKey);
+    writer.putString(a.appName);
+
+    uint8_t* base = map_ + kHeaderBytes + target * kSlotBytes;
+    SlotHeader header{generation, checksumOf(generation, writer.size(), payload), writer.size()};
+    std::memcpy(base + sizeof(SlotHeader), payload, writer.size());
+    std::memcpy(base, &header, sizeof(header));
+    msync(map_, kFileBytes, MS_ASYNC);
+}
+
+void PresenceJournal::recordActivity(uint64_t applicationId, const PendingActivity& activity, int64_t nowMs) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!map_) return;
+    JournalEntry entry;
+    newestSlot(&entry);
+    entry.applicationId = applicationId;
+    entry.writtenAtMs = nowMs;
+    entry.cleared = false;
+    entry.activity = activity;
+    write(entry);
+}
+
+void PresenceJournal::recordCleared(uint64_t applicationId, int64_t nowMs) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!map_) return;
+    JournalEntry entry;
+    newestSlot(&entry);
+    if (entry.cleared) return;
+    entry.applicationId = applicationId;
+    entry.writtenAtMs = nowMs;
+    entry.cleared = true;
+    entry.activity = PendingActivity();
+    write(entry);
+}
+
+void PresenceJournal::recordReady(uint64_t applicationId, int64_t nowMs) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!map_) return;
+    JournalEntry entry;
+    if (newestSlot(&entry) < 0) {
+        entry.applicationId = applicationId;
+        entry.cleared = true;
+    }
+    entry.lastReadyMs = nowMs;
+    write(entry);
+}
+
+bool PresenceJournal::latest(JournalEntry* entry) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return map_ && newestSlot(entry) >= 0;
+}
+
+bool PresenceJournal::restorable(uint64_t applicationId, int64_t nowMs, PendingActivity* activity) {
+    JournalEntry entry;
+    if (!latest(&entry) || entry.cleared || entry.applicationId != applicationId) return false;
+    const PendingActivity& a = entry.activity;
+    if (a.details.empty() && a.state.empty()) return false;
+    if (a.hasTimestamps && a.end > 0) {
+        if (nowMs >= a.end) return false;
+    } else if (nowMs - entry.writtenAtMs > kMaxUntimedAgeMs || nowMs < entry.writtenAtMs) {
+        return false;
+    }
+    *activity = a;
+    return true;
+}
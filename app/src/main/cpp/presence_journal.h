@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+#include "presence_core.h"
+
+// The last presence sent to Discord, kept in a small memory-mapped file so a
+// service restarted after process death can show it again as soon as the new
+// client is Ready, before any media callback reaches Kotlin.
+//
+// The file holds two slots written alternately. Each write goes to the older
+// slot and carries a generation one above the newer one plus a checksum over
+// the whole slot, so a write cut short by the process dying leaves a slot that
+// fails its checksum and the previous generation is used instead. Stores go
+// straight to the page cache through the mapping; msync only hurries them
+// to disk for the power-loss case.
+struct JournalEntry {
+    uint64_t generation = 0;
+    uint64_t applicationId = 0;
+    int64_t writtenAtMs = 0;
+    int64_t lastReadyMs = 0;  // last time a client reached Ready
+    bool cleared = false;     // presence was cleared after it was set
+    PendingActivity activity;
+};
+
+class PresenceJournal {
+public:
+    static constexpr size_t kFileBytes = 4096;
+    // A presence without an end time is only restored this soon after it was sent
+    static constexpr int64_t kMaxUntimedAgeMs = 15 * 60 * 1000;
+
+    ~PresenceJournal();
+
+    // Maps |path|, creating it if needed. Reopening the same path is a no-op.
+    bool open(const std::string& path, std::string* error);
+    void close();
+
+    void recordActivity(uint64_t applicationId, const PendingActivity& activity, int64_t nowMs);
+    void recordCleared(uint64_t applicationId, int64_t nowMs);
+    void recordReady(uint64_t applicationId, int64_t nowMs);
+
+    // Newest slot that passes its checksum
+    bool latest(JournalEntry* entry);
+    // The journaled activity if it belongs to |applicationId|, wasn't cleared
+    // and is still current at |nowMs| judging by its timestamps
+    bool restorable(uint64_t applicationId, int64_t nowMs, PendingActivity* activity);
+
+private:
+    bool readSlot(int slot, JournalEntry* entry) const;
+    int newestSlot(JournalEntry* entry) const;
+    void write(const JournalEntry& entry);
+
+    std::mutex mutex_;
+    std::string path_;
+    uint8_t* map_ = nullptr;
+};
+
+extern PresenceJournal g_presenceJournal;
@@ -0,0 +1,167 @@
+#include "relationship_store.h"
+
+#include <algorithm>
+
+RelationshipStore g_relationshipStore;
+
+static_assert(sizeof(FriendRow) == 64, "FriendRow should fill one cache line");
+
+static bool byUserId(const FriendRow& row, uint64_t userId) { return row.userId < userId; }
+
+const FriendRow* RelationshipSnapshot::find(uint64_t userId) const {
+    auto it = std::lower_bound(rows.begin(), rows.end(), userId, byUserId);
+    return it != rows.end() && it->userId == userId ? &*it : nullptr;
+}
+
+bool RelationshipSnapshot::changesSince(uint64_t afterVersion, std::vector<const FriendRow*>* changed,
+                                        std::vector<uint64_t>* removed) const {
+    bool full = afterVersion == 0 || afterVersion < removalsSince;
+    for (const FriendRow& row : rows) {
+        if (full || row.version > afterVersion) changed->push_back(&row);
+    }
+    if (full) return true;
+    for (const Removal& removal : removals) {
+        if (removal.version > afterVersion) removed->push_back(removal.userId);
+    }
+    return false;
+}
+
+TextRef RelationshipStore::append(std::string_view text) {
+    if (text.empty()) return {};
+    TextRef ref{(uint32_t)text_.size(), (uint32_t)text.size()};
+    text_.append(text);
+    return ref;
+}
+
+bool RelationshipStore::assign(TextRef* ref, std::string_view text) {
+    if (std::string_view(text_).substr(ref->offset, ref->length) == text) return false;
+    garbage_ += ref->length;
+    *ref = append(text);
+    return true;
+}
+
+static FriendRow emptyRow(uint64_t userId) {
+    FriendRow row{};
+    row.userId = userId;
+    return row;
+}
+
+// Whether anything moved is worked out field by field, so a user-updated
+// callback that only touched what we don't keep (an avatar, say) costs no row
+bool RelationshipStore::fill(FriendRow* row, const FriendInfo& info, bool fresh) {
+    bool changed = fresh;
+    changed |= assign(&row->displayName, info.displayName);
+    changed |= assign(&row->username, info.username);
+    changed |= assign(&row->activityName, info.activityName);
+    changed |= assign(&row->details, info.details);
+    changed |= assign(&row->state, info.state);
+    if (row->status != (uint8_t)info.status || row->activityType != (int8_t)info.activityType) {
+        row->status = (uint8_t)info.status;
+        row->activityType = (int8_t)info.activityType;
+        changed = true;
+    }
+    if (!changed) return false;
+    row->version = version_ + 1;
+    dirty_ = true;
+    return true;
+}
+
+bool RelationshipStore::upsert(const FriendInfo& info) {
+    auto it = std::lower_bound(rows_.begin(), rows_.end(), info.userId, byUserId);
+    bool fresh = it == rows_.end() || it->userId != info.userId;
+    if (fresh) it = rows_.insert(it, emptyRow(info.userId));
+    return fill(&*it, info, fresh);
+}
+
+void RelationshipStore::logRemoval(const FriendRow& row) {
+    garbage_ += row.displayName.length + row.username.length + row.activityName.length + row.details.length +
+                row.state.length;
+    removals_.push_back({version_ + 1, row.userId});
+    if (removals_.size() > kMaxRemovals) {
+        removalsSince_ = removals_.front().version;
+        removals_.pop_front();
+    }
+    dirty_ = true;
+}
+
+bool RelationshipStore::contains(uint64_t userId) const {
+    auto it = std::lower_bound(rows_.begin(), rows_.end(), userId, byUserId);
+    return it != rows_.end() && it->userId == userId;
+}
+
+bool RelationshipStore::remove(uint64_t userId) {
+    auto it = std::lower_bound(rows_.begin(), rows_.end(), userId, byUserId);
+    if (it == rows_.end() || it->userId != userId) return false;
+    logRemoval(*it);
+    rows_.erase(it);
+    return true;
+}
+
+// A merge of the sorted rows with the sorted load, rather than an upsert per
+// friend: inserting thousands one at a time shifts the table each time
+void RelationshipStore::replaceAll(const std::vector<FriendInfo>& friends) {
+    std::vector<const FriendInfo*> sorted;
+    sorted.reserve(friends.size());
+    for (const FriendInfo& info : friends) sorted.push_back(&info);
+    std::stable_sort(sorted.begin(), sorted.end(),
+                     [](const FriendInfo* a, const FriendInfo* b) { return a->userId < b->userId; });
+
+    std::vector<FriendRow> merged;
+    merged.reserve(sorted.size());
+    auto row = rows_.begin();
+    for (size_t i = 0; i < sorted.size(); i++) {
+        const FriendInfo& info = *sorted[i];
+        // The SDK lists a user once; should it not, the last listing wins
+        if (i + 1 < sorted.size() && sorted[i + 1]->userId == info.userId) continue;
+        for (; row != rows_.end() && row->userId < info.userId; ++row) logRemoval(*row);
+        bool fresh = row == rows_.end() || row->userId != info.userId;
+        merged.push_back(fresh ? emptyRow(info.userId) : *row++);
+        fill(&merged.back(), info, fresh);
+    }
+    for (; row != rows_.end(); ++row) logRemoval(*row);
+    rows_ = std::move(merged);
+}
+
+void RelationshipStore::clear() {
+    rows_.clear();
+    text_.clear();
+    garbage_ = 0;
+    removals_.clear();
+    removalsSince_ = version_ + 1;
+    dirty_ = true;
+}
+
+void RelationshipStore::compact() {
+    std::string text;
+    text.reserve(text_.size() - garbage_);
+    auto move = [&](TextRef* ref) {
+        uint32_t offset = (uint32_t)text.size();
+        text.append(text_, ref->offset, ref->length);
+        if (ref->length) ref->offset = offset;
+    };
+    for (FriendRow& row : rows_) {
+        move(&row.displayName);
+        move(&row.username);
+        move(&row.activityName);
+        move(&row.details);
+        move(&row.state);
+    }
+    text_ = std::move(text);
+    garbage_ = 0;
+}
+
+bool RelationshipStore::publish() {
+    if (!dirty_) return false;
+    // Every changed field appends; once most of the arena is dead, rewrite it
+    if (garbage_ > text_.size() - garbage_) compact();
+
+    auto snapshot = std::make_shared<RelationshipSnapshot>();
+    snapshot->version = ++version_;
+    snapshot->rows = rows_;
+    snapshot->text = text_;
+    snapshot->removals.assign(removals_.begin(), removals_.end());
+    snapshot->removalsSince = removalsSince_;
+    dirty_ = false;
+    std::atomic_store(&current_, std::shared_ptr<const RelationshipSnapshot>(std::move(snapshot)));
+    return true;
+}
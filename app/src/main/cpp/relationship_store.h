@@ -0,0 +1,110 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// The user's friends, kept natively so the UI never walks
+// Client::GetRelationships(): that returns a fresh vector of handles, and
+// every field read through one is another C API call and string copy.
+// presence_core.cpp fills it from the relationship and user-updated callbacks
+// and publishes a snapshot when something changed; each row carries the
+// version that last changed it, so a reader asks for what moved since the
+// version it has and re-renders only those rows.
+
+// What the SDK reports for one friend
+struct FriendInfo {
+    uint64_t userId = 0;
+    std::string displayName;
+    std::string username;
+    int status = 1;         // discordpp::StatusType, Offline by default
+    int activityType = -1;  // discordpp::ActivityTypes, -1 = no activity
+    std::string activityName;
+    std::string details;
+    std::string state;
+};
+
+// Into RelationshipSnapshot::text
+struct TextRef {
+    uint32_t offset = 0;
+    uint32_t length = 0;
+};
+
+// One cache line per friend; the text lives in the snapshot's arena
+struct FriendRow {
+    uint64_t userId;
+    uint64_t version;  // the snapshot that last changed it
+    TextRef displayName;
+    TextRef username;
+    TextRef activityName;
+    TextRef details;
+    TextRef state;
+    uint8_t status;
+    int8_t activityType;
+};
+
+struct RelationshipSnapshot {
+    uint64_t version = 0;
+    std::vector<FriendRow> rows;  // sorted by userId
+    std::string text;
+    // Friends removed after |removalsSince|, in order. A reader at an older
+    // version than that may have missed some, and has to start over.
+    struct Removal {
+        uint64_t version;
+        uint64_t userId;
+    };
+    std::vector<Removal> removals;
+    uint64_t removalsSince = 0;
+
+    std::string_view textOf(TextRef ref) const { return std::string_view(text).substr(ref.offset, ref.length); }
+    const FriendRow* find(uint64_t userId) const;
+    // What a reader at |afterVersion| has to apply, removals first: true if
+    // that is everything (it should drop what it has), false if only changes
+    bool changesSince(uint64_t afterVersion, std::vector<const FriendRow*>* changed,
+                      std::vector<uint64_t>* removed) const;
+};
+
+// Written from one thread (the pump); snapshots are read from any
+class RelationshipStore {
+public:
+    static constexpr size_t kMaxRemovals = 512;
+
+    // False if |info| matches what the row already holds
+    bool upsert(const FriendInfo& info);
+    bool remove(uint64_t userId);
+    bool contains(uint64_t userId) const;
+    // A full load: upserts |friends| and removes everyone else
+    void replaceAll(const std::vector<FriendInfo>& friends);
+    // The client went away; readers start over from the next snapshot
+    void clear();
+
+    // Publishes what changed since the last publish, if anything did
+    bool publish();
+    // Null until the first publish
+    std::shared_ptr<const RelationshipSnapshot> snapshot() const { return std::atomic_load(&current_); }
+    size_t size() const { return rows_.size(); }
+
+private:
+    TextRef append(std::string_view text);
+    // Points |ref| at |text|, reusing what it points at if equal; true if it moved
+    bool assign(TextRef* ref, std::string_view text);
+    // Brings |row| up to |info|; true (and the row versioned) if anything moved
+    bool fill(FriendRow* row, const FriendInfo& info, bool fresh);
+    void logRemoval(const FriendRow& row);
+    void compact();
+
+    std::vector<FriendRow> rows_;  // sorted by userId
+    std::string text_;
+    size_t garbage_ = 0;  // bytes of text_ no row points at
+    std::deque<RelationshipSnapshot::Removal> removals_;
+    uint64_t removalsSince_ = 0;
+    uint64_t version_ = 0;  // of the last publish
+    bool dirty_ = false;
+    std::shared_ptr<const RelationshipSnapshot> current_;
+};
+
+extern RelationshipStore g_relationshipStore;
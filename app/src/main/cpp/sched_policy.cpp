@@ -0,0 +1,113 @@
+#include "sched_policy.h"
+
+#include <cstdio>
+#include <vector>
+
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "log.h"
+
+SchedPolicy g_schedPolicy;
+
+namespace {
+
+const char* kProfileNames[] = {"battery_saver", "balanced", "low_latency"};
+static_assert(sizeof(kProfileNames) / sizeof(kProfileNames[0]) == (size_t)SchedProfile::Count, "profile names");
+
+// android.os.Process THREAD_PRIORITY_BACKGROUND / DEFAULT / FOREGROUND
+const int kProfileNice[] = {10, 0, -2};
+
+// The highest frequency each core can reach, 0 if cpufreq doesn't say. On
+// big.LITTLE parts the clusters differ here even when the core types don't
+// show up anywhere else.
+long readMaxFreqKhz(int cpu) {
+    char path[96];
+    std::snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cpufreq/cpuinfo_max_freq", cpu);
+    FILE* file = std::fopen(path, "r");
+    if (!file) return 0;
+    long khz = 0;
+    if (std::fscanf(file, "%ld", &khz) != 1) khz = 0;
+    std::fclose(file);
+    return khz;
+}
+
+} // namespace
+
+SchedPolicy::SchedPolicy() {
+    long cpus = sysconf(_SC_NPROCESSORS_CONF);
+    if (cpus <= 0) cpus = 1;
+    if (cpus > 64) cpus = 64;
+    std::vector<long> freqs((size_t)cpus);
+    long slowest = 0, fastest = 0;
+    for (int cpu = 0; cpu < cpus; cpu++) {
+        allMask_ |= 1ull << cpu;
+        freqs[cpu] = readMaxFreqKhz(cpu);
+        if (freqs[cpu] > 0 && (slowest == 0 || freqs[cpu] < slowest)) slowest = freqs[cpu];
+        if (freqs[cpu] > fastest) fastest = freqs[cpu];
+    }
+    for (int cpu = 0; cpu < cpus; cpu++) {
+        if (freqs[cpu] == slowest) littleMask_ |= 1ull << cpu;
+        if (freqs[cpu] < fastest) allButTopMask_ |= 1ull << cpu;
+    }
+    // Symmetric or unreadable: nothing to steer towards
+    if (slowest == fastest) {
+        littleMask_ = allMask_;
+        allButTopMask_ = allMask_;
+    }
+}
+
+const char* SchedPolicy::name(SchedProfile profile) {
+    return kProfileNames[(int32_t)profile];
+}
+
+void SchedPolicy::setProfile(SchedProfile profile) {
+    if ((int32_t)profile < 0 || profile >= SchedProfile::Count) return;
+    profile_.store((int32_t)profile, std::memory_order_relaxed);
+    LOGI("Scheduling profile %s: cpus 0x%llx, nice %d", name(profile), (unsigned long long)settings().cpuMask,
+         settings().nice);
+}
+
+SchedSettings SchedPolicy::settings() const {
+    SchedProfile current = profile();
+    uint64_t mask = 0;
+    switch (current) {
+        case SchedProfile::BatterySaver: mask = littleMask_; break;
+        case SchedProfile::Balanced: mask = allButTopMask_; break;
+        default: break;
+    }
+    if (mask == allMask_) mask = 0;
+    return {mask, kProfileNice[(int32_t)current]};
+}
+
+void SchedPolicy::applyToCurrentThread() const {
+    SchedSettings s = settings();
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu = 0; cpu < 64; cpu++) {
+        if (((s.cpuMask ? s.cpuMask : allMask_) >> cpu) & 1) CPU_SET(cpu, &set);
+    }
+    if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+        LOGE("sched_setaffinity failed for 0x%llx", (unsigned long long)s.cpuMask);
+    }
+    if (setpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid), s.nice) != 0) {
+        LOGE("setpriority(%d) failed", s.nice);
+    }
+}
+
+void SchedPolicy::applyToClient(discordpp::Client& client) const {
+    // The SDK takes the platform's thread priority, on Android a nice value.
+    // Voice stays at the SDK default: we never join calls.
+    int nice = settings().nice;
+    client.SetThreadPriority(discordpp::Client::Thread::Client, nice);
+    client.SetThreadPriority(discordpp::Client::Thread::Network, nice);
+}
+
+discordpp::ClientCreateOptions SchedPolicy::createOptions() const {
+    discordpp::ClientCreateOptions options;
+    uint64_t mask = settings().cpuMask;
+    if (mask) options.SetCpuAffinityMask(mask);
+    return options;
+}
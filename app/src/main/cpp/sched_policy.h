@@ -0,0 +1,50 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include "discordpp.h"
+
+// Where and how eagerly our background threads run: the pump thread
+// (presence_core.cpp) and the SDK's own threads of every client we create.
+// Appending is compatible with DiscordGateway.setSchedProfile callers.
+enum class SchedProfile : int32_t {
+    BatterySaver,  // efficiency cores only, background priority
+    Balanced,      // any core but the fastest cluster, default priority
+    LowLatency,    // any core, foreground priority
+    Count
+};
+
+struct SchedSettings {
+    uint64_t cpuMask;  // 0 = no restriction
+    int nice;
+};
+
+class SchedPolicy {
+public:
+    SchedPolicy();
+
+    void setProfile(SchedProfile profile);
+    SchedProfile profile() const { return (SchedProfile)profile_.load(std::memory_order_relaxed); }
+    SchedSettings settings() const;
+
+    // Affinity and nice of the calling thread
+    void applyToCurrentThread() const;
+    // Thread priorities of an existing client; affinity only takes effect
+    // through createOptions, when a client is made
+    void applyToClient(discordpp::Client& client) const;
+    discordpp::ClientCreateOptions createOptions() const;
+
+    uint64_t littleCores() const { return littleMask_; }
+    uint64_t allCores() const { return allMask_; }
+
+    static const char* name(SchedProfile profile);
+
+private:
+    std::atomic<int32_t> profile_{(int32_t)SchedProfile::Balanced};
+    uint64_t littleMask_ = 0;    // slowest cluster
+    uint64_t allButTopMask_ = 0; // every cluster but the fastest
+    uint64_t allMask_ = 0;
+};
+
+extern SchedPolicy g_schedPolicy;
@@ -0,0 +1,111 @@
+#include "session_store.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "log.h"
+
+SessionStore g_sessionStore;
+
+namespace {
+
+// One field per line; tokens never contain newlines
+constexpr const char* kHeader = "DRPC-SESSION 1";
+
+bool writeAll(int fd, const std::string& data) {
+    size_t written = 0;
+    while (written < data.size()) {
+        ssize_t n = ::write(fd, data.data() + written, data.size() - written);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        written += (size_t)n;
+    }
+    return true;
+}
+
+} // namespace
+
+void SessionStore::setDirectory(const std::string& directory) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    path_ = directory + "/discord_session";
+}
+
+bool SessionStore::load(StoredSession* session) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return loadLocked(session);
+}
+
+bool SessionStore::loadLocked(StoredSession* session) {
+    if (path_.empty()) return false;
+    FILE* file = std::fopen(path_.c_str(), "re");
+    if (!file) return false;
+
+    char lines[5][512];
+    int count = 0;
+    while (count < 5 && std::fgets(lines[count], sizeof(lines[count]), file)) {
+        lines[count][std::strcspn(lines[count], "\n")] = '\0';
+        count++;
+    }
+    std::fclose(file);
+
+    if (count < 5 || std::strcmp(lines[0], kHeader) != 0) {
+        LOGE("Session store: ignoring unreadable %s", path_.c_str());
+        return false;
+    }
+    session->applicationId = std::strtoull(lines[1], nullptr, 10);
+    session->enabled = std::strcmp(lines[2], "1") == 0;
+    session->accessToken = lines[3];
+    session->refreshToken = lines[4];
+    return session->applicationId != 0 && !session->accessToken.empty();
+}
+
+bool SessionStore::save(const StoredSession& session) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    // Every launch hands over the same tokens; skip the fsync when nothing changed
+    StoredSession current;
+    if (loadLocked(&current) && current.applicationId == session.applicationId &&
+        current.enabled == session.enabled && current.accessToken == session.accessToken &&
+        current.refreshToken == session.refreshToken) {
+        return true;
+    }
+    return saveLocked(session);
+}
+
+bool SessionStore::saveLocked(const StoredSession& session) {
+    if (path_.empty()) return false;
+    std::string data = std::string(kHeader) + "\n" + std::to_string(session.applicationId) + "\n" +
+                       (session.enabled ? "1" : "0") + "\n" + session.accessToken + "\n" + session.refreshToken + "\n";
+    std::string temporary = path_ + ".tmp";
+
+    int fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        LOGE("Session store: cannot open %s: %s", temporary.c_str(), std::strerror(errno));
+        return false;
+    }
+    bool ok = writeAll(fd, data) && fsync(fd) == 0;
+    ok = ::close(fd) == 0 && ok;
+    if (!ok || std::rename(temporary.c_str(), path_.c_str()) != 0) {
+        LOGE("Session store: write failed: %s", std::strerror(errno));
+        ::unlink(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+void SessionStore::setEnabled(bool enabled) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    StoredSession session;
+    if (!loadLocked(&session) || session.enabled == enabled) return;
+    session.enabled = enabled;
+    saveLocked(session);
+}
+
+void SessionStore::forget() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!path_.empty()) ::unlink(path_.c_str());
+}
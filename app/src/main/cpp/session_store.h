@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+// The OAuth tokens in a file native code can read without the JVM, so a cold
+// start can restore the session and connect from Application.onCreate instead
+// of waiting for MainActivity to load SharedPreferences. Kotlin's preferences
+// stay the source of truth; this is a copy updated whenever they change.
+//
+// Saves write a temporary file, fsync it and rename it over the old one, so a
+// reader sees either the previous session or the new one, never a mix.
+struct StoredSession {
+    uint64_t applicationId = 0;
+    bool enabled = true;  // the RPC toggle; a disabled session isn't warm-started
+    std::string accessToken;
+    std::string refreshToken;
+};
+
+class SessionStore {
+public:
+    // Sets the directory the store lives in (the app's files dir)
+    void setDirectory(const std::string& directory);
+
+    bool load(StoredSession* session);
+    // No-op when |session| matches what is already stored
+    bool save(const StoredSession& session);
+    // Keeps the tokens but changes the toggle; no-op without a saved session
+    void setEnabled(bool enabled);
+    void forget();
+
+private:
+    bool loadLocked(StoredSession* session);
+    bool saveLocked(const StoredSession& session);
+
+    std::mutex mutex_;
+    std::string path_;
+};
+
+extern SessionStore g_sessionStore;
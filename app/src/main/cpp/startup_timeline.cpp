@@ -0,0 +1,93 @@
+#include "startup_timeline.h"
+
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+
+#include <unistd.h>
+
+#include "log.h"
+
+StartupTimeline g_startupTimeline;
+
+namespace {
+
+const char* kPhaseNames[] = {
+    "library", "warm_start", "session", "client", "token", "ready", "ui", "presence_sent", "presence_acked",
+};
+static_assert(sizeof(kPhaseNames) / sizeof(kPhaseNames[0]) == (size_t)StartupPhase::Count, "phase names");
+
+// Field 22 of /proc/self/stat is the start time in clock ticks since boot,
+// the same origin as CLOCK_BOOTTIME
+int64_t readProcessStartMs() {
+    FILE* file = std::fopen("/proc/self/stat", "r");
+    if (!file) return -1;
+    char buffer[1024];
+    size_t n = std::fread(buffer, 1, sizeof(buffer) - 1, file);
+    std::fclose(file);
+    buffer[n] = '\0';
+
+    // The command name (field 2) may contain spaces, so count from its ')'
+    const char* p = std::strrchr(buffer, ')');
+    if (!p) return -1;
+    int field = 2;
+    while (*p && field < 22) {
+        if (*p++ == ' ') field++;
+    }
+    long long ticks = 0;
+    if (std::sscanf(p, "%lld", &ticks) != 1) return -1;
+    return ticks * 1000 / sysconf(_SC_CLK_TCK);
+}
+
+} // namespace
+
+StartupTimeline::StartupTimeline() : processStartMs_(readProcessStartMs()) {
+    for (auto& mark : marks_) mark.store(-1, std::memory_order_relaxed);
+    if (processStartMs_ < 0) processStartMs_ = bootTimeMs();
+}
+
+int64_t StartupTimeline::bootTimeMs() {
+    struct timespec now;
+    clock_gettime(CLOCK_BOOTTIME, &now);
+    return (int64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+const char* StartupTimeline::name(StartupPhase phase) {
+    return kPhaseNames[(uint32_t)phase];
+}
+
+void StartupTimeline::mark(StartupPhase phase) {
+    auto& slot = marks_[(uint32_t)phase];
+    if (slot.load(std::memory_order_relaxed) >= 0) return;
+    int64_t expected = -1;
+    if (slot.compare_exchange_strong(expected, bootTimeMs() - processStartMs_, std::memory_order_relaxed) &&
+        phase == StartupPhase::FirstPresenceAcked) {
+        log();
+    }
+}
+
+int64_t StartupTimeline::sinceProcessStartMs(StartupPhase phase) const {
+    return marks_[(uint32_t)phase].load(std::memory_order_relaxed);
+}
+
+std::vector<int64_t> StartupTimeline::snapshot() const {
+    std::vector<int64_t> values;
+    for (const auto& mark : marks_) values.push_back(mark.load(std::memory_order_relaxed));
+    return values;
+}
+
+void StartupTimeline::log() const {
+    char line[512];
+    size_t n = 0;
+    int64_t previous = 0;
+    for (uint32_t i = 0; i < (uint32_t)StartupPhase::Count; i++) {
+        int64_t at = sinceProcessStartMs((StartupPhase)i);
+        if (at < 0 || n >= sizeof(line)) continue;
+        int written = std::snprintf(line + n, sizeof(line) - n, " %s=%lld(+%lld)", kPhaseNames[i], (long long)at,
+                                    (long long)(at - previous));
+        if (written > 0) n += (size_t)written;
+        previous = at;
+    }
+    line[n < sizeof(line) ? n : sizeof(line) - 1] = '\0';
+    LOGI("Startup timeline (ms since process start):%s", line);
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+// When each step between process start and the first presence Discord
+// accepted happened, for finding out where cold-start time goes. Each phase
+// keeps its first mark only.
+//
+// Appending is compatible with DiscordGateway.startupTimeline() readers;
+// don't reorder.
+enum class StartupPhase : uint32_t {
+    LibraryLoaded,
+    WarmStart,       // DiscordGateway.warmStart from Application.onCreate
+    SessionLoaded,   // native session store read
+    ClientStarted,
+    TokenRestored,   // UpdateToken callback succeeded
+    Ready,
+    UiReady,         // MainActivity content set
+    FirstPresenceSubmitted,
+    FirstPresenceAcked,
+    Count
+};
+
+class StartupTimeline {
+public:
+    StartupTimeline();
+
+    void mark(StartupPhase phase);
+    // Milliseconds from process start, or -1 if the phase wasn't reached
+    int64_t sinceProcessStartMs(StartupPhase phase) const;
+    std::vector<int64_t> snapshot() const;
+    // One log line with every reached phase, and the delta from the previous
+    void log() const;
+
+    static const char* name(StartupPhase phase);
+
+private:
+    static int64_t bootTimeMs();
+
+    int64_t processStartMs_;
+    std::atomic<int64_t> marks_[(uint32_t)StartupPhase::Count];
+};
+
+extern StartupTimeline g_startupTimeline;
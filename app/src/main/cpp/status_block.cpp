@@ -0,0 +1,100 @@
+#include "status_block.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include "log.h"
+
+StatusBlock g_statusBlock;
+
+template <size_t N>
+void StatusBlock::Text<N>::assign(std::string_view text) {
+    size_t length = std::min(text.size(), N);
+    // Cut at a UTF-8 character boundary so Java gets valid modified UTF-8
+    if (length < text.size()) {
+        while (length > 0 && ((unsigned char)text[length] & 0xC0) == 0x80) length--;
+    }
+    std::memcpy(bytes, text.data(), length);
+    this->length = (uint32_t)length;
+}
+
+StatusBlock::StatusBlock() {
+    current_.activityType = 2;
+    eventFd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (eventFd_ < 0) LOGE("StatusBlock: eventfd failed");
+}
+
+StatusBlock::~StatusBlock() {
+    if (eventFd_ >= 0) close(eventFd_);
+}
+
+void StatusBlock::publishPresence(int status, const PendingActivity& activity) {
+    std::lock_guard<std::mutex> lock(writeMutex_);
+    current_.hasPresence = 1;
+    current_.status = status;
+    current_.activityType = activity.type;
+    current_.start = activity.start;
+    current_.end = activity.end;
+    current_.details.assign(activity.details);
+    current_.state.assign(activity.state);
+    current_.appName.assign(activity.appName);
+    current_.imageKey.assign(activity.imageKey);
+    store();
+}
+
+void StatusBlock::setConnection(int connection) {
+    std::lock_guard<std::mutex> lock(writeMutex_);
+    if (current_.connection == connection) return;
+    current_.connection = connection;
+    store();
+}
+
+void StatusBlock::store() {
+    uint64_t words[kWords] = {};
+    std::memcpy(words, &current_, sizeof(Layout));
+    uint64_t seq = seq_.load(std::memory_order_relaxed);
+    seq_.store(seq + 1, std::memory_order_relaxed);
+    // Release per word rather than a fence: a reader that sees any new word
+    // also sees the odd sequence number
+    for (size_t i = 0; i < kWords; i++) words_[i].store(words[i], std::memory_order_release);
+    seq_.store(seq + 2, std::memory_order_release);
+    if (eventFd_ >= 0) {
+        uint64_t one = 1;
+        (void)write(eventFd_, &one, sizeof(one));
+    }
+}
+
+bool StatusBlock::read(uint64_t afterVersion, StatusView* out) {
+    uint64_t words[kWords];
+    uint64_t seq;
+    while (true) {
+        seq = seq_.load(std::memory_order_acquire);
+        if (seq / 2 == afterVersion) return false;
+        if (seq & 1) continue;  // a writer is mid-copy; it holds the block for well under a µs
+        for (size_t i = 0; i < kWords; i++) words[i] = words_[i].load(std::memory_order_acquire);
+        if (seq_.load(std::memory_order_relaxed) == seq) break;
+    }
+    Layout layout;
+    std::memcpy(&layout, words, sizeof(Layout));
+    out->version = seq / 2;
+    out->status = layout.status;
+    out->activityType = layout.activityType;
+    out->start = layout.start;
+    out->end = layout.end;
+    out->connection = layout.connection;
+    out->hasPresence = layout.hasPresence != 0;
+    out->details = layout.details.str();
+    out->state = layout.state.str();
+    out->appName = layout.appName.str();
+    out->imageKey = layout.imageKey.str();
+    return true;
+}
+
+void StatusBlock::drainEvents() {
+    if (eventFd_ < 0) return;
+    uint64_t count;
+    (void)::read(eventFd_, &count, sizeof(count));
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+#include "presence_core.h"
+
+// One consistent reading of the StatusBlock
+struct StatusView {
+    uint64_t version = 0;  // 0 = nothing published yet
+    int status = 0;        // SurfaceStatus
+    int activityType = 2;
+    int64_t start = 0;
+    int64_t end = 0;
+    int connection = 0;    // discordpp::Client::Status
+    bool hasPresence = false;  // false until the service first posts
+    std::string details;
+    std::string state;
+    std::string appName;
+    std::string imageKey;
+};
+
+// What MainActivity shows, in one fixed-size block the service and the pump
+// write and the UI reads, instead of an eight-extra broadcast per update and
+// static fields the two sides raced on. Writers take a mutex and bump a
+// sequence number to odd and back to even around the copy; a reader retries
+// if it saw an odd number or the number changed while it copied, so it never
+// blocks the writer and never sees half an update. The block lives in atomic
+// words, so the copies a reader retries aren't data races.
+//
+// Each publish also signals one eventfd, which the UI registers with its main
+// Looper (MessageQueue.addOnFileDescriptorEventListener): a single readiness
+// wakeup however many updates landed since the UI last looked.
+class StatusBlock {
+public:
+    StatusBlock();
+    ~StatusBlock();
+
+    // From the status surface (status_surface.cpp) when it posts
+    void publishPresence(int status, const PendingActivity& activity);
+    void setConnection(int connection);
+
+    // False, copying nothing, if the version is still |afterVersion|
+    bool read(uint64_t afterVersion, StatusView* out);
+    // Readable whenever something was published since the last drainEvents()
+    int eventFd() const { return eventFd_; }
+    void drainEvents();
+
+private:
+    template <size_t N>
+    struct Text {
+        uint32_t length;
+        char bytes[N];
+        void assign(std::string_view text);
+        std::string str() const { return std::string(bytes, length); }
+    };
+    struct Layout {
+        int32_t status;
+        int32_t activityType;
+        int32_t connection;
+        int32_t hasPresence;
+        int64_t start;
+        int64_t end;
+        Text<256> details;
+        Text<256> state;
+        Text<128> appName;
+        Text<512> imageKey;
+    };
+    static constexpr size_t kWords = (sizeof(Layout) + 7) / 8;
+
+    // Caller holds writeMutex_
+    void store();
+
+    std::mutex writeMutex_;
+    Layout current_{};  // the writers' copy, under writeMutex_
+    std::atomic<uint64_t> seq_{0};
+    std::atomic<uint64_t> words_[kWords] = {};
+    int eventFd_ = -1;
+};
+
+extern StatusBlock g_statusBlock;
@@ -0,0 +1,73 @@
+#include "status_surface.h"
+
+#include <algorithm>
+
+#include "metrics.h"
+#include "status_block.h"
+
+StatusSurface g_statusSurface;
+
+int64_t StatusSurface::offer(SurfaceStatus status, PendingActivity activity, int64_t nowMs) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (posted_ && posted_->status == status && samePresence(posted_->activity, activity)) {
+        // Back to what's showing: a pending flush has nothing left to post
+        pending_.reset();
+        g_metrics.add(Counter::StatusSkips);
+        return kSkip;
+    }
+    pending_ = State{status, std::move(activity)};
+    if (!posted_ || nowMs - lastPostMs_ >= intervalMs_) return post(nowMs);
+    g_metrics.add(Counter::StatusSkips);
+    if (flushDue_) return kSkip;
+    flushDue_ = true;
+    return lastPostMs_ + intervalMs_ - nowMs;
+}
+
+int64_t StatusSurface::flush(int64_t nowMs) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    flushDue_ = false;
+    if (!pending_) return kSkip;
+    // The interval changed under it, or the caller's timer ran early
+    if (nowMs - lastPostMs_ < intervalMs_) {
+        flushDue_ = true;
+        return lastPostMs_ + intervalMs_ - nowMs;
+    }
+    return post(nowMs);
+}
+
+// Caller holds mutex_
+int64_t StatusSurface::post(int64_t nowMs) {
+    posted_ = std::move(pending_);
+    pending_.reset();
+    lastPostMs_ = nowMs;
+    g_statusBlock.publishPresence((int)posted_->status, posted_->activity);
+    g_metrics.add(Counter::StatusPosts);
+    return kPostNow;
+}
+
+void StatusSurface::reset() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    posted_.reset();
+    pending_.reset();
+    flushDue_ = false;
+}
+
+void StatusSurface::expire(bool clear) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!posted_ || expiryDelayMs(posted_->activity) != 0) return;
+    if (clear) {
+        g_statusBlock.publishPresence((int)SurfaceStatus::Idle, PendingActivity());
+    } else {
+        PendingActivity untimed = posted_->activity;
+        untimed.hasTimestamps = false;
+        untimed.start = 0;
+        untimed.end = 0;
+        g_statusBlock.publishPresence((int)posted_->status, untimed);
+    }
+    posted_.reset();
+}
+
+void StatusSurface::setIntervalMs(int64_t intervalMs) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    intervalMs_ = std::clamp<int64_t>(intervalMs, 0, kMaxIntervalMs);
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <optional>
+
+#include "presence_core.h"
+
+enum class SurfaceStatus { Idle, Playing, Paused };
+
+// Paces the service's status surface, the foreground notification plus what
+// MainActivity shows (status_block.h): media callbacks used to post both,
+// each an IPC, on every callback. Each offer is compared with what
+// was last posted, by samePresence, so the surface and Discord agree on what
+// counts as a change. A change goes out at once if the interval since the last
+// post has passed; otherwise it waits for a trailing-edge flush, and any
+// offers until then only replace the state that flush posts.
+//
+// Kotlin keeps the notification's strings and posts it when told to; a post
+// also publishes the state to the status block. The clock is the caller's
+// steady ms, so host tools can drive it.
+class StatusSurface {
+public:
+    static constexpr int64_t kPostNow = 0;
+    static constexpr int64_t kSkip = -1;
+    // Past a minute the notification would just look stuck
+    static constexpr int64_t kMaxIntervalMs = 60000;
+
+    // kPostNow, kSkip (unchanged, or a flush is already due), or the ms until
+    // flush() should be called
+    int64_t offer(SurfaceStatus status, PendingActivity activity, int64_t nowMs);
+    // The trailing edge: same return values as offer()
+    int64_t flush(int64_t nowMs);
+    // Forgets what was posted, for a new notification
+    void reset();
+    // A presence outlived its end (presence_core.h's expiry). If what was
+    // posted has too, the status block gets it cleared (|clear|) or without
+    // its timestamps, and the surface forgets it: the notification still
+    // shows it, so the next offer has to post even if it's the same.
+    void expire(bool clear);
+
+    // Clamped to 0..kMaxIntervalMs
+    void setIntervalMs(int64_t intervalMs);
+
+private:
+    struct State {
+        SurfaceStatus status;
+        PendingActivity activity;
+    };
+
+    int64_t post(int64_t nowMs);
+
+    std::mutex mutex_;
+    int64_t intervalMs_ = 1000;
+    std::optional<State> posted_;
+    std::optional<State> pending_;
+    bool flushDue_ = false;
+    int64_t lastPostMs_ = 0;
+};
+
+extern StatusSurface g_statusSurface;
@@ -0,0 +1,46 @@
+#include "string_intern.h"
+
+InternPool g_internPool;
+
+uint64_t InternPool::hashOf(std::string_view s) {
+    // FNV-1a; keys are short and this runs once per lookup
+    uint64_t h = 1469598103934665603ull;
+    for (unsigned char c : s) {
+        h ^= c;
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+const InternedString* InternPool::acquire(std::string_view s) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = index_.find(s);
+    if (it != index_.end()) {
+        it->second->refs++;
+        return it->second;
+    }
+    auto* node = new InternedString{std::string(s), hashOf(s), 1};
+    index_.emplace(std::string_view(node->text), node);
+    bytes_ += node->text.size() + sizeof(InternedString);
+    return node;
+}
+
+void InternPool::release(const InternedString* node) {
+    if (!node) return;
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto* owned = const_cast<InternedString*>(node);
+    if (--owned->refs > 0) return;
+    index_.erase(std::string_view(owned->text));
+    bytes_ -= owned->text.size() + sizeof(InternedString);
+    delete owned;
+}
+
+size_t InternPool::size() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return index_.size();
+}
+
+size_t InternPool::bytes() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return bytes_;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// One shared copy per distinct string (package names, track keys) no matter
+// how many caches hold it. Nodes are heap allocated, so a pointer stays valid
+// and readable without locking for as long as the holder keeps its reference.
+struct InternedString {
+    std::string text;
+    uint64_t hash;
+    uint32_t refs;
+};
+
+class InternPool {
+public:
+    static uint64_t hashOf(std::string_view s);
+
+    // Returns the node for |s| with one reference added for the caller
+    const InternedString* acquire(std::string_view s);
+    void release(const InternedString* node);
+
+    size_t size();
+    size_t bytes();
+
+private:
+    std::mutex mutex_;
+    std::unordered_map<std::string_view, InternedString*> index_;
+    size_t bytes_ = 0;
+};
+
+extern InternPool g_internPool;
@@ -0,0 +1,163 @@
+#include "timer_wheel.h"
+
+#include <algorithm>
+
+TimerWheel::TimerWheel() : nodes_(kHeads) {
+    for (uint32_t head = 0; head < kHeads; head++) {
+        nodes_[head].prev = head;
+        nodes_[head].next = head;
+        nodes_[head].list = head;
+    }
+}
+
+TimerId TimerWheel::schedule(int64_t nowMs, int64_t delayMs, Callback fn) {
+    // Nothing placed relative to the old tick, so the wheel can jump ahead
+    // instead of crawling there from whenever it last advanced
+    if (count_ == 0) now_ = std::max(now_, nowMs);
+
+    uint32_t index;
+    if (free_ != kNil) {
+        index = free_;
+        free_ = nodes_[index].next;
+    } else {
+        index = (uint32_t)nodes_.size();
+        nodes_.emplace_back();
+    }
+    Node& node = nodes_[index];
+    node.deadline = nowMs + std::max<int64_t>(delayMs, 0);
+    node.fn = std::move(fn);
+    count_++;
+    place(index);
+    return (TimerId)node.generation << 32 | index;
+}
+
+bool TimerWheel::cancel(TimerId id) {
+    uint32_t index = (uint32_t)id;
+    if (index < kHeads || index >= nodes_.size()) return false;
+    Node& node = nodes_[index];
+    if (node.list == kNil || node.generation != (uint32_t)(id >> 32)) return false;
+    unlink(index);
+    release(index);
+    return true;
+}
+
+void TimerWheel::advance(int64_t nowMs) {
+    while (true) {
+        int64_t tick = nextDeadlineMs();
+        if (tick > nowMs) break;
+        now_ = tick;
+        cascade(tick);
+        // Ticks before this one are done; anything scheduled from a callback
+        // below lands after it and fires no earlier than the next pass
+        now_ = tick + 1;
+        uint32_t head = (uint32_t)(tick & (kSlots - 1));
+        while (nodes_[head].next != head) {
+            uint32_t index = nodes_[head].next;
+            unlink(index);
+            link(kFiring, index);
+        }
+        while (nodes_[kFiring].next != kFiring) {
+            uint32_t index = nodes_[kFiring].next;
+            unlink(index);
+            Callback fn = std::move(nodes_[index].fn);
+            release(index);
+            fn();
+        }
+    }
+    // Not past nowMs itself, so a deadline of nowMs scheduled after this still
+    // fires on the next call
+    now_ = std::max(now_, nowMs);
+}
+
+int64_t TimerWheel::nextDeadlineMs() const {
+    // Every level is looked at: on a boundary the tick hasn't reached yet, a
+    // higher slot due to cascade there can come before the level 0 timers
+    int64_t next = INT64_MAX;
+    for (int level = 0; level < kLevels; level++) {
+        int shift = level * kSlotBits;
+        uint64_t pending = occupied_[level] & (~0ull << ((now_ >> shift) & (kSlots - 1)));
+        if (!pending) continue;
+        int64_t block = now_ >> (shift + kSlotBits) << (shift + kSlotBits);
+        next = std::min(next, std::max(now_, block + ((int64_t)__builtin_ctzll(pending) << shift)));
+    }
+    if (nodes_[kOverflow].next != kOverflow) {
+        // Comes into range at the next top-level boundary
+        constexpr int kRange = kLevels * kSlotBits;
+        next = std::min(next, (now_ + (int64_t{1} << kRange) - 1) >> kRange << kRange);
+    }
+    return next;
+}
+
+void TimerWheel::clear() {
+    for (uint32_t index = kHeads; index < nodes_.size(); index++) {
+        if (nodes_[index].list == kNil) continue;
+        unlink(index);
+        release(index);
+    }
+}
+
+// The lowest level whose slots span the deadline from the current tick: same
+// block of 64 ms goes to level 0, same block of 4096 ms to level 1, and so on
+void TimerWheel::place(uint32_t index) {
+    int64_t deadline = std::max(nodes_[index].deadline, now_);
+    for (int level = 0; level < kLevels; level++) {
+        int shift = level * kSlotBits;
+        if (deadline >> (shift + kSlotBits) != now_ >> (shift + kSlotBits)) continue;
+        link((uint32_t)(level * kSlots + ((deadline >> shift) & (kSlots - 1))), index);
+        return;
+    }
+    link(kOverflow, index);
+}
+
+void TimerWheel::link(uint32_t head, uint32_t index) {
+    Node& node = nodes_[index];
+    node.list = head;
+    node.next = head;
+    node.prev = nodes_[head].prev;
+    nodes_[node.prev].next = index;
+    nodes_[head].prev = index;
+    if (head < kOverflow) occupied_[head / kSlots] |= 1ull << (head % kSlots);
+}
+
+void TimerWheel::unlink(uint32_t index) {
+    Node& node = nodes_[index];
+    nodes_[node.prev].next = node.next;
+    nodes_[node.next].prev = node.prev;
+    uint32_t head = node.list;
+    if (head < kOverflow && nodes_[head].next == head) occupied_[head / kSlots] &= ~(1ull << (head % kSlots));
+}
+
+void TimerWheel::release(uint32_t index) {
+    Node& node = nodes_[index];
+    node.list = kNil;
+    node.generation++;
+    node.fn = nullptr;
+    node.next = free_;
+    free_ = index;
+    count_--;
+}
+
+void TimerWheel::replace(uint32_t head) {
+    while (nodes_[head].next != head) {
+        uint32_t index = nodes_[head].next;
+        unlink(index);
+        link(kFiring, index);
+    }
+    while (nodes_[kFiring].next != kFiring) {
+        uint32_t index = nodes_[kFiring].next;
+        unlink(index);
+        place(index);
+    }
+}
+
+// At a block boundary the slot of each level that starts there comes due:
+// its timers move down, highest level first so they can keep falling
+void TimerWheel::cascade(int64_t tick) {
+    constexpr int kRange = kLevels * kSlotBits;
+    if ((tick & ((int64_t{1} << kRange) - 1)) == 0) replace(kOverflow);
+    for (int level = kLevels - 1; level > 0; level--) {
+        int shift = level * kSlotBits;
+        if (tick & ((int64_t{1} << shift) - 1)) continue;
+        replace((uint32_t)(level * kSlots + ((tick >> shift) & (kSlots - 1))));
+    }
+}
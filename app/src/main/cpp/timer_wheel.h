@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// 0 is never handed out, so it can stand for "no timer"
+using TimerId = uint64_t;
+
+// Hierarchical timer wheel on a millisecond monotonic clock (the caller's
+// steady_clock, in ms). Four levels of 64 slots cover 2^24 ms (~4.6 h) ahead
+// of the current tick; anything further waits in an overflow list until it
+// comes within range. Timers sit in intrusive lists threaded through one node
+// vector, and each level keeps a bitmap of its non-empty slots, so schedule
+// and cancel are O(1) and finding the next deadline is a bit scan per level.
+//
+// Not thread-safe: the pump owns it (schedulePumpTimer in presence_core.h).
+// Callbacks run from advance() and may schedule or cancel freely.
+class TimerWheel {
+public:
+    using Callback = std::function<void()>;
+
+    TimerWheel();
+
+    // Fires |fn| from the first advance() whose time reaches nowMs + delayMs,
+    // or the tick after, if advance() already fired that tick's timers
+    TimerId schedule(int64_t nowMs, int64_t delayMs, Callback fn);
+    // False if |id| already fired or was cancelled
+    bool cancel(TimerId id);
+    // Fires everything due by |nowMs|, earliest first
+    void advance(int64_t nowMs);
+    // When advance() next has something to do, INT64_MAX if nothing is
+    // scheduled. Exact for timers within the next 64 ms; further out it is the
+    // start of their slot, where advance() moves them down a level and this
+    // gets more precise, so a sleeper wakes at most once per level early.
+    int64_t nextDeadlineMs() const;
+    // Drops every timer without running it
+    void clear();
+
+    size_t size() const { return count_; }
+    bool empty() const { return count_ == 0; }
+
+private:
+    static constexpr int kLevels = 4;
+    static constexpr int kSlotBits = 6;
+    static constexpr int kSlots = 1 << kSlotBits;
+    static constexpr uint32_t kNil = UINT32_MAX;
+    // List heads: one per slot, then the overflow list and the batch advance()
+    // is firing; real nodes come after them
+    static constexpr uint32_t kOverflow = kLevels * kSlots;
+    static constexpr uint32_t kFiring = kOverflow + 1;
+    static constexpr uint32_t kHeads = kFiring + 1;
+
+    struct Node {
+        uint32_t prev;
+        uint32_t next;
+        uint32_t list = kNil;  // head it hangs off, kNil when free
+        uint32_t generation = 0;
+        int64_t deadline = 0;
+        Callback fn;
+    };
+
+    void place(uint32_t index);
+    void link(uint32_t head, uint32_t index);
+    void unlink(uint32_t index);
+    void release(uint32_t index);
+    // Moves every node on |head| to where it belongs relative to now_
+    void replace(uint32_t head);
+    void cascade(int64_t tick);
+
+    std::vector<Node> nodes_;
+    uint32_t free_ = kNil;
+    uint64_t occupied_[kLevels] = {};
+    // Next tick to process; everything before it has fired
+    int64_t now_ = 0;
+    size_t count_ = 0;
+};
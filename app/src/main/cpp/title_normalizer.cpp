@@ -0,0 +1,304 @@
+#include "title_normalizer.h"
+
+#include <deque>
+
+#include "log.h"
+
+TitleNormalizer g_titleNormalizer;
+
+namespace {
+
+constexpr int kMaxDepth = 8;
+constexpr int kMaxSpans = 16;
+constexpr size_t kNone = std::string_view::npos;
+
+struct Span {
+    size_t begin, end;  // [begin, end)
+};
+
+struct Group {
+    size_t open;
+    char close;
+    bool noisy;
+};
+
+std::string_view trim(std::string_view s) {
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t' || s.front() == '\r')) s.remove_prefix(1);
+    while (!s.empty() && (s.back() == ' ' || s.back() == '\t' || s.back() == '\r')) s.remove_suffix(1);
+    return s;
+}
+
+bool isWordByte(unsigned char c) {
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c >= 0x80;
+}
+
+bool isEdgeJunk(char c) {
+    return c == ' ' || c == '\t' || c == '-' || c == '|' || c == ':' || c == '~' || c == '/' || c == ',';
+}
+
+// Copies text[from, to) minus |spans|, collapsing whitespace runs and dropping
+// separators left dangling at either end by the removals
+std::string clean(std::string_view text, size_t from, size_t to, const Span* spans, int spanCount) {
+    std::string out;
+    out.reserve(to - from);
+    int span = 0;
+    for (size_t i = from; i < to; i++) {
+        while (span < spanCount && spans[span].end <= i) span++;
+        if (span < spanCount && spans[span].begin <= i) {
+            i = spans[span].end - 1;
+            continue;
+        }
+        char c = text[i];
+        if (c == ' ' || c == '\t') {
+            if (out.empty() || out.back() == ' ') continue;
+            c = ' ';
+        }
+        out += c;
+    }
+    size_t first = 0;
+    while (first < out.size() && isEdgeJunk(out[first])) first++;
+    size_t last = out.size();
+    while (last > first && isEdgeJunk(out[last - 1])) last--;
+    return out.substr(first, last - first);
+}
+
+std::string stripArtistSuffix(const NoiseAutomaton& automaton, std::string_view artist) {
+    // Only a match ending on the last byte counts; take the longest one
+    int state = automaton.start();
+    for (unsigned char c : artist) state = automaton.step(state, c);
+    size_t cut = artist.size();
+    automaton.forEachMatch(state, [&](int id) {
+        const auto& p = automaton.pattern(id);
+        if (p.kind == NoiseAutomaton::ArtistSuffix && artist.size() - p.text.size() < cut) cut = artist.size() - p.text.size();
+    });
+    std::string stripped = clean(artist, 0, cut, nullptr, 0);
+    return stripped.empty() ? std::string(trim(artist)) : stripped;
+}
+
+} // namespace
+
+void NoiseAutomaton::build(std::vector<Pattern> patterns) {
+    patterns_ = std::move(patterns);
+
+    // Compress the alphabet to the bytes the dictionary actually uses
+    std::fill(std::begin(classOf_), std::end(classOf_), 0);
+    classes_ = 1;
+    for (const auto& p : patterns_) {
+        for (unsigned char c : p.text) {
+            if (!classOf_[c]) classOf_[c] = (uint8_t)classes_++;
+        }
+    }
+
+    // Trie, with -1 for missing edges
+    std::vector<int> next(classes_, -1);
+    ownPattern_.assign(1, -1);
+    for (size_t id = 0; id < patterns_.size(); id++) {
+        int s = 0;
+        for (unsigned char c : patterns_[id].text) {
+            size_t edge = (size_t)s * classes_ + classOf_[c];
+            if (next[edge] < 0) {
+                next[edge] = (int)ownPattern_.size();
+                ownPattern_.push_back(-1);
+                next.resize(next.size() + classes_, -1);
+            }
+            s = next[edge];
+        }
+        if (ownPattern_[s] < 0) ownPattern_[s] = (int)id;
+    }
+
+    // BFS fills failure links and turns the trie into a full transition table
+    size_t states = ownPattern_.size();
+    std::vector<int> fail(states, 0);
+    outLink_.assign(states, 0);
+    delta_.assign(states * classes_, 0);
+    std::deque<int> queue;
+    for (int c = 0; c < classes_; c++) {
+        int child = next[c];
+        if (child > 0) {
+            delta_[c] = child;
+            queue.push_back(child);
+        }
+    }
+    while (!queue.empty()) {
+        int s = queue.front();
+        queue.pop_front();
+        int f = fail[s];
+        outLink_[s] = ownPattern_[f] >= 0 ? f : outLink_[f];
+        for (int c = 0; c < classes_; c++) {
+            int child = next[(size_t)s * classes_ + c];
+            if (child > 0) {
+                fail[child] = delta_[(size_t)f * classes_ + c];
+                delta_[(size_t)s * classes_ + c] = child;
+                queue.push_back(child);
+            } else {
+                delta_[(size_t)s * classes_ + c] = delta_[(size_t)f * classes_ + c];
+            }
+        }
+    }
+}
+
+bool TitleNormalizer::load(std::string_view text, std::string* error) {
+    auto dictionary = std::make_shared<NoiseDictionary>();
+    std::vector<NoiseAutomaton::Pattern> patterns;
+    std::string section;
+    int lineNo = 0;
+
+    auto fail = [&](const std::string& message) {
+        *error = "line " + std::to_string(lineNo) + ": " + message;
+        return false;
+    };
+
+    size_t pos = 0;
+    while (pos <= text.size()) {
+        size_t eol = text.find('\n', pos);
+        if (eol == std::string_view::npos) eol = text.size();
+        std::string_view line = trim(text.substr(pos, eol - pos));
+        pos = eol + 1;
+        lineNo++;
+        if (line.empty() || line[0] == '#') continue;
+
+        if (line.front() == '[' && line.back() == ']') {
+            section = std::string(trim(line.substr(1, line.size() - 2)));
+            if (section != "apps" && section != "bracket" && section != "tail" && section != "split" && section != "artist_suffix") {
+                return fail("unknown section " + section);
+            }
+            continue;
+        }
+        if (section.empty()) return fail("entry outside a section");
+        if (section == "apps") {
+            dictionary->apps.emplace(line);
+            continue;
+        }
+
+        // Quotes keep leading/trailing spaces, which matter for " #shorts" or " - "
+        std::string_view phrase = line;
+        std::string_view rest;
+        if (line.front() == '"') {
+            size_t close = line.find('"', 1);
+            if (close == std::string_view::npos) return fail("unterminated quote");
+            phrase = line.substr(1, close - 1);
+            rest = trim(line.substr(close + 1));
+        } else if (section == "split") {
+            return fail("split separators must be quoted");
+        }
+        if (phrase.empty()) return fail("empty phrase");
+
+        NoiseAutomaton::Pattern pattern;
+        for (unsigned char c : phrase) pattern.text += (char)NoiseAutomaton::lower(c);
+        if (section == "bracket") {
+            pattern.kind = NoiseAutomaton::Bracket;
+        } else if (section == "tail") {
+            pattern.kind = NoiseAutomaton::Tail;
+        } else if (section == "artist_suffix") {
+            pattern.kind = NoiseAutomaton::ArtistSuffix;
+        } else if (rest == "artist_first") {
+            pattern.kind = NoiseAutomaton::SplitArtistFirst;
+        } else if (rest == "title_first") {
+            pattern.kind = NoiseAutomaton::SplitTitleFirst;
+        } else {
+            return fail("split order must be artist_first or title_first");
+        }
+        if (!rest.empty() && section != "split") return fail("unexpected text after phrase");
+        patterns.push_back(std::move(pattern));
+    }
+
+    size_t patternCount = patterns.size();
+    dictionary->automaton.build(std::move(patterns));
+    LOGI("Loaded %zu title noise phrases (%zu states) for %zu apps", patternCount,
+         dictionary->automaton.stateCount(), dictionary->apps.size());
+    std::atomic_store(&dictionary_, std::shared_ptr<const NoiseDictionary>(std::move(dictionary)));
+    return true;
+}
+
+bool TitleNormalizer::enabledFor(std::string_view package) const {
+    auto dictionary = snapshot();
+    if (!dictionary) return false;
+    return dictionary->apps.count(std::string(package)) || dictionary->apps.count("*");
+}
+
+bool TitleNormalizer::normalize(std::string_view title, std::string_view artist, NormalizedTitle* out) const {
+    auto dictionary = snapshot();
+    if (!dictionary) return false;
+    return normalizeWith(*dictionary, title, artist, out);
+}
+
+bool TitleNormalizer::normalizeWith(const NoiseDictionary& dictionary, std::string_view title, std::string_view artist, NormalizedTitle* out) {
+    const NoiseAutomaton& automaton = dictionary.automaton;
+    Group groups[kMaxDepth];
+    int depth = 0;
+    Span spans[kMaxSpans];
+    int spanCount = 0;
+    size_t splitBegin = kNone, splitEnd = kNone;
+    bool artistFirst = false;
+    size_t tailBeforeSplit = kNone, tailAfterSplit = kNone;
+
+    int state = automaton.start();
+    for (size_t i = 0; i < title.size(); i++) {
+        char c = title[i];
+        if (c == '(' || c == '[' || c == '{') {
+            if (depth < kMaxDepth) groups[depth++] = {i, c == '(' ? ')' : c == '[' ? ']' : '}', false};
+        } else if (depth > 0 && c == groups[depth - 1].close) {
+            const Group& group = groups[--depth];
+            if (group.noisy) {
+                // Inner groups already removed are swallowed by this one
+                while (spanCount > 0 && spans[spanCount - 1].begin > group.open) spanCount--;
+                if (spanCount < kMaxSpans) spans[spanCount++] = {group.open, i + 1};
+            }
+        }
+
+        state = automaton.step(state, (unsigned char)c);
+        automaton.forEachMatch(state, [&](int id) {
+            const auto& p = automaton.pattern(id);
+            size_t begin = i + 1 - p.text.size();
+            switch (p.kind) {
+            case NoiseAutomaton::Bracket:
+                if (depth > 0 && (begin == 0 || !isWordByte(title[begin - 1])) &&
+                    (i + 1 == title.size() || !isWordByte(title[i + 1]))) {
+                    groups[depth - 1].noisy = true;
+                }
+                break;
+            case NoiseAutomaton::Tail:
+                if (depth > 0) break;
+                if (splitBegin == kNone) {
+                    if (tailBeforeSplit == kNone) tailBeforeSplit = begin;
+                } else if (tailAfterSplit == kNone && begin >= splitEnd) {
+                    tailAfterSplit = begin;
+                }
+                break;
+            case NoiseAutomaton::SplitArtistFirst:
+            case NoiseAutomaton::SplitTitleFirst:
+                if (depth == 0 && splitBegin == kNone) {
+                    splitBegin = begin;
+                    splitEnd = i + 1;
+                    artistFirst = p.kind == NoiseAutomaton::SplitArtistFirst;
+                }
+                break;
+            case NoiseAutomaton::ArtistSuffix:
+                break;
+            }
+        });
+    }
+
+    std::string cleanTitle, cleanArtist;
+    if (splitBegin != kNone) {
+        size_t leftEnd = artistFirst || tailBeforeSplit == kNone ? splitBegin : tailBeforeSplit;
+        size_t rightEnd = !artistFirst || tailAfterSplit == kNone ? title.size() : tailAfterSplit;
+        std::string left = clean(title, 0, leftEnd, spans, spanCount);
+        std::string right = clean(title, splitEnd, rightEnd, spans, spanCount);
+        if (!left.empty() && !right.empty()) {
+            cleanTitle = artistFirst ? std::move(right) : std::move(left);
+            cleanArtist = artistFirst ? std::move(left) : std::move(right);
+        }
+    }
+    if (cleanTitle.empty()) {
+        cleanTitle = clean(title, 0, tailBeforeSplit == kNone ? title.size() : tailBeforeSplit, spans, spanCount);
+        if (cleanTitle.empty()) cleanTitle = std::string(trim(title));
+        cleanArtist = std::string(artist);
+    }
+    cleanArtist = stripArtistSuffix(automaton, cleanArtist);
+
+    bool changed = cleanTitle != title || cleanArtist != artist;
+    out->title = std::move(cleanTitle);
+    out->artist = std::move(cleanArtist);
+    return changed;
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+// Cleans YouTube-style titles ("Artist - Song (Official Music Video) [4K]")
+// into a plain title and artist, using the dictionary in
+// assets/title_noise.conf.
+//
+// Every dictionary phrase goes into one Aho-Corasick automaton (dense
+// transition table over a compressed byte alphabet), so a title is cleaned in
+// a single left-to-right pass no matter how many phrases are configured:
+//   [bracket]        (...) / [...] groups containing one of these words are dropped
+//   [tail]           the title is cut where one of these starts (" #shorts")
+//   [split]          first separator outside brackets splits artist from title
+//   [artist_suffix]  stripped from the end of the artist (" - Topic", "VEVO")
+//   [apps]           packages the stage is enabled for
+
+struct NormalizedTitle {
+    std::string title;
+    std::string artist;
+};
+
+class NoiseAutomaton {
+public:
+    enum Kind : uint8_t { Bracket, Tail, SplitArtistFirst, SplitTitleFirst, ArtistSuffix };
+
+    struct Pattern {
+        std::string text;  // lowercase
+        Kind kind;
+    };
+
+    void build(std::vector<Pattern> patterns);
+
+    int start() const { return 0; }
+    int step(int state, unsigned char c) const { return delta_[(size_t)state * classes_ + classOf_[lower(c)]]; }
+    // Patterns ending at |state|: first is |ownPattern_|, then follow |outLink_|
+    template <typename F>
+    void forEachMatch(int state, F&& f) const;
+
+    const Pattern& pattern(int id) const { return patterns_[id]; }
+    size_t patternCount() const { return patterns_.size(); }
+    size_t stateCount() const { return ownPattern_.size(); }
+
+    static unsigned char lower(unsigned char c) { return c >= 'A' && c <= 'Z' ? c + 32 : c; }
+
+private:
+    std::vector<Pattern> patterns_;
+    uint8_t classOf_[256] = {};
+    int classes_ = 1;
+    std::vector<int> delta_;
+    std::vector<int> ownPattern_;
+    std::vector<int> outLink_;
+};
+
+struct NoiseDictionary {
+    NoiseAutomaton automaton;
+    std::unordered_set<std::string> apps;
+};
+
+class TitleNormalizer {
+public:
+    bool load(std::string_view text, std::string* error);
+
+    bool enabledFor(std::string_view package) const;
+
+    // Returns false if the dictionary changed nothing
+    bool normalize(std::string_view title, std::string_view artist, NormalizedTitle* out) const;
+
+    std::shared_ptr<const NoiseDictionary> snapshot() const { return std::atomic_load(&dictionary_); }
+    static bool normalizeWith(const NoiseDictionary& dictionary, std::string_view title, std::string_view artist, NormalizedTitle* out);
+
+private:
+    std::shared_ptr<const NoiseDictionary> dictionary_;
+};
+
+extern TitleNormalizer g_titleNormalizer;
+
+template <typename F>
+void NoiseAutomaton::forEachMatch(int state, F&& f) const {
+    int s = ownPattern_[state] >= 0 ? state : outLink_[state];
+    while (s > 0) {
+        f(ownPattern_[s]);
+        s = outLink_[s];
+    }
+}
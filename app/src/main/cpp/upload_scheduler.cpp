@@ -0,0 +1,98 @@
+#include "upload_scheduler.h"
+
+#include <algorithm>
+
+#include "log.h"
+
+UploadScheduler g_uploadScheduler;
+
+void UploadScheduler::configure(const std::vector<std::string>& names) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<UploadHostStats> next;
+    next.reserve(names.size());
+    for (const auto& name : names) {
+        auto it = std::find_if(hosts_.begin(), hosts_.end(), [&](const UploadHostStats& h) { return h.name == name; });
+        if (it != hosts_.end()) {
+            next.push_back(*it);
+        } else {
+            UploadHostStats stats;
+            stats.name = name;
+            next.push_back(stats);
+        }
+    }
+    hosts_ = std::move(next);
+    LOGI("Upload hosts configured: %zu", hosts_.size());
+}
+
+double UploadScheduler::score(const UploadHostStats& h, int64_t nowMs) const {
+    // Hosts with no recent samples sort first (in configured order) so each
+    // one gets probed, otherwise a slow first pick would never be displaced.
+    if (h.successes + h.failures == 0 || nowMs - h.lastReportMs > kReprobeMs) return 0;
+    return h.latencyEwmaMs * (1.0 + 4.0 * h.errorEwma);
+}
+
+std::vector<int> UploadScheduler::plan(int64_t nowMs) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<int> order(hosts_.size());
+    for (size_t i = 0; i < order.size(); i++) order[i] = (int)i;
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+        bool coolA = hosts_[a].cooldownUntilMs > nowMs;
+        bool coolB = hosts_[b].cooldownUntilMs > nowMs;
+        if (coolA != coolB) return coolB;
+        return score(hosts_[a], nowMs) < score(hosts_[b], nowMs);
+    });
+    return order;
+}
+
+int64_t UploadScheduler::percentile95(const UploadHostStats& h) const {
+    if (h.sampleCount < 8) return kDefaultHedgeMs;
+    uint32_t sorted[UploadHostStats::kSamples];
+    std::copy(h.samples, h.samples + h.sampleCount, sorted);
+    int rank = (h.sampleCount * 95 + 99) / 100 - 1;
+    std::nth_element(sorted, sorted + rank, sorted + h.sampleCount);
+    return sorted[rank];
+}
+
+int64_t UploadScheduler::hedgeDelayMs(int host) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (host < 0 || host >= (int)hosts_.size()) return kDefaultHedgeMs;
+    return std::clamp(percentile95(hosts_[host]), kMinHedgeMs, kMaxHedgeMs);
+}
+
+void UploadScheduler::report(int host, bool success, int64_t latencyMs, int64_t nowMs) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (host < 0 || host >= (int)hosts_.size()) return;
+    auto& h = hosts_[host];
+    bool first = h.successes + h.failures == 0;
+    h.lastReportMs = nowMs;
+
+    h.errorEwma = first ? (success ? 0.0 : 1.0) : h.errorEwma + kAlpha * ((success ? 0.0 : 1.0) - h.errorEwma);
+    if (success) {
+        h.latencyEwmaMs = h.successes == 0 ? (double)latencyMs : h.latencyEwmaMs + kAlpha * ((double)latencyMs - h.latencyEwmaMs);
+        h.samples[h.sampleHead] = (uint32_t)std::max<int64_t>(latencyMs, 0);
+        h.sampleHead = (h.sampleHead + 1) % UploadHostStats::kSamples;
+        h.sampleCount = std::min(h.sampleCount + 1, UploadHostStats::kSamples);
+        h.successes++;
+        h.consecutiveFailures = 0;
+        h.cooldownUntilMs = 0;
+    } else {
+        // A failure still costs the time we spent on it
+        if (h.successes > 0) h.latencyEwmaMs += kAlpha * ((double)latencyMs - h.latencyEwmaMs);
+        h.failures++;
+        if (++h.consecutiveFailures >= kFailuresBeforeCooldown && h.cooldownUntilMs <= nowMs) {
+            h.cooldownUntilMs = nowMs + kCooldownMs;
+            LOGE("Upload host %s failed %d times in a row, cooling down", h.name.c_str(), h.consecutiveFailures);
+        }
+    }
+}
+
+UploadHostStats UploadScheduler::stats(int host) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (host < 0 || host >= (int)hosts_.size()) return {};
+    return hosts_[host];
+}
+
+size_t UploadScheduler::size() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return hosts_.size();
+}
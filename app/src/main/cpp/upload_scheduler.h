@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Picks which image host to try for a cover-art upload and when to hedge.
+// The transfer itself happens in Kotlin (OkHttp); this only keeps score.
+struct UploadHostStats {
+    std::string name;
+    double latencyEwmaMs = 0;
+    double errorEwma = 0;
+    uint64_t successes = 0;
+    uint64_t failures = 0;
+    int consecutiveFailures = 0;
+    int64_t cooldownUntilMs = 0;
+    int64_t lastReportMs = 0;
+
+    // Ring of recent successful latencies, used for the p95 hedge deadline
+    static constexpr int kSamples = 64;
+    uint32_t samples[kSamples] = {};
+    int sampleCount = 0;
+    int sampleHead = 0;
+};
+
+class UploadScheduler {
+public:
+    static constexpr double kAlpha = 0.2;
+    static constexpr int64_t kDefaultHedgeMs = 4000;
+    static constexpr int64_t kMinHedgeMs = 750;
+    static constexpr int64_t kMaxHedgeMs = 15000;
+    static constexpr int kFailuresBeforeCooldown = 3;
+    static constexpr int64_t kCooldownMs = 60000;
+    static constexpr int64_t kReprobeMs = 10 * 60000;
+
+    // Replaces the configured hosts; stats are kept for names that survive
+    void configure(const std::vector<std::string>& names);
+
+    // Host indices ordered best first. Hosts in cooldown go last rather
+    // than being dropped, so an upload is never refused outright.
+    std::vector<int> plan(int64_t nowMs);
+
+    // How long to wait on |host| before firing a hedged request elsewhere
+    int64_t hedgeDelayMs(int host);
+
+    void report(int host, bool success, int64_t latencyMs, int64_t nowMs);
+
+    UploadHostStats stats(int host);
+    size_t size();
+
+private:
+    double score(const UploadHostStats& h, int64_t nowMs) const;
+    int64_t percentile95(const UploadHostStats& h) const;
+
+    std::mutex mutex_;
+    std::vector<UploadHostStats> hosts_;
+};
+
+extern UploadScheduler g_uploadScheduler;
@@ -0,0 +1,156 @@
+package com.thepotato.discordrpc
+
+import android.content.ContentResolver
+import android.content.Context
+import android.graphics.Bitmap
+import android.graphics.BitmapFactory
+import android.media.MediaMetadata
+import android.media.session.MediaController
+import android.media.session.MediaSession
+import android.os.Process
+import android.util.Log
+import com.thepotato.discordrpc.parsing.MetadataParserFactory
+import kotlinx.coroutines.CoroutineScope
+import kotlinx.coroutines.SupervisorJob
+import kotlinx.coroutines.asCoroutineDispatcher
+import kotlinx.coroutines.cancel
+import kotlinx.coroutines.launch
+import java.util.concurrent.Executors
+import java.util.concurrent.atomic.AtomicLong
+
+/**
+ * Uploads cover art for the next few queue items before they play, so the
+ * art URL is usually cached by the time the track changes.
+ *
+ * Runs on a single background-priority thread. A prefetch counts as a hit
+ * when its track later becomes the current one (even if the upload is still
+ * finishing), and as waste when it ages out of the tracking window without
+ * ever playing. The counts also go to the native metrics registry, for the
+ * status card's health line.
+ */
+class ArtPrefetcher(
+    private val context: Context,
+    private val urlCache: ArtUrlCache,
+    private val uploadingTracks: MutableSet<String>,
+    private val onUploaded: (trackId: String) -> Unit
+) {
+    companion object {
+        const val LOOKAHEAD = 3
+        // Prefetched-but-unplayed entries kept before the oldest counts as waste
+        private const val MAX_OUTSTANDING = 16
+    }
+
+    private val dispatcher = Executors.newSingleThreadExecutor { runnable ->
+        Thread({
+            Process.setThreadPriority(Process.THREAD_PRIORITY_BACKGROUND)
+            runnable.run()
+        }, "ArtPrefetch")
+    }.asCoroutineDispatcher()
+    private val scope = CoroutineScope(SupervisorJob() + dispatcher)
+
+    // Prefetched tracks not yet shown, oldest first for waste eviction
+    private val outstanding = LinkedHashSet<String>()
+
+    val issued = AtomicLong()
+    val hits = AtomicLong()
+    val wasted = AtomicLong()
+
+    fun hitRatio(): Float = issued.get().let { if (it == 0L) 0f else hits.get().toFloat() / it }
+    fun wasteRatio(): Float = issued.get().let { if (it == 0L) 0f else wasted.get().toFloat() / it }
+
+    /** Call whenever |trackId| becomes the track being shown. */
+    fun onTrackShown(trackId: String) {
+        val wasPrefetched = synchronized(outstanding) { outstanding.remove(trackId) }
+        if (wasPrefetched) {
+            hits.incrementAndGet()
+            DiscordGateway.recordPrefetch(DiscordGateway.PREFETCH_HIT)
+            Log.d("ArtPrefetcher", "Prefetch hit (hit ${"%.2f".format(hitRatio())}, waste ${"%.2f".format(wasteRatio())})")
+        }
+    }
+
+    /** Queues uploads for the items after the active one in |controller|'s queue. */
+    fun prefetch(controller: MediaController) {
+        val queue = controller.queue ?: return
+        if (queue.isEmpty()) return
+        val activeId = controller.playbackState?.activeQueueItemId ?: MediaSession.QueueItem.UNKNOWN_ID.toLong()
+        val activeIndex = queue.indexOfFirst { it.queueId == activeId }
+        val upcoming = queue.drop(activeIndex + 1).take(LOOKAHEAD)
+        val packageName = controller.packageName
+        val parser = MetadataParserFactory.getParser(packageName)
+
+        for (item in upcoming) {
+            val description = item.description
+            val title = description.title?.toString() ?: continue
+            // Queue items only carry a description; shape it like the metadata
+            // the session will publish so the parser yields the same track key
+            val metadata = MediaMetadata.Builder()
+                .putString(MediaMetadata.METADATA_KEY_TITLE, title)
+                .putString(MediaMetadata.METADATA_KEY_ARTIST, description.subtitle?.toString())
+                .build()
+            val parsed = parser.parse(metadata)
+            val trackId = DiscordMediaService.trackKey(parsed.details, parsed.state, packageName)
+
+            if (urlCache.containsKey(trackId) || !uploadingTracks.add(trackId)) continue
+            // Tracked now rather than on the executor: the track can start
+            // playing before the upload gets there, and that's still a hit
+            issued.incrementAndGet()
+            DiscordGateway.recordPrefetch(DiscordGateway.PREFETCH_ISSUED)
+            track(trackId)
+
+            scope.launch {
+                try {
+                    val bitmap = description.iconBitmap ?: loadIcon(description.iconUri)
+                    if (bitmap == null) {
+                        untrack(trackId)
+                        return@launch
+                    }
+                    val url = ImageUploader(context).uploadImage(bitmap) ?: return@launch
+                    urlCache[trackId] = url
+                    onUploaded(trackId)
+                } finally {
+                    uploadingTracks.remove(trackId)
+                }
+            }
+        }
+    }
+
+    fun shutdown() {
+        scope.cancel()
+        dispatcher.close()
+    }
+
+    private fun track(trackId: String) {
+        synchronized(outstanding) {
+            outstanding.add(trackId)
+            while (outstanding.size > MAX_OUTSTANDING) {
+                val oldest = outstanding.first()
+                outstanding.remove(oldest)
+                wasted.incrementAndGet()
+                DiscordGateway.recordPrefetch(DiscordGateway.PREFETCH_WASTED)
+            }
+        }
+    }
+
+    // No art to upload after all; unless it already played, it never counted
+    private fun untrack(trackId: String) {
+        if (synchronized(outstanding) { outstanding.remove(trackId) }) {
+            issued.decrementAndGet()
+            // Native counters only go up; the status card subtracts these
+            DiscordGateway.recordPrefetch(DiscordGateway.PREFETCH_NO_ART)
+        }
+    }
+
+    private fun loadIcon(uri: android.net.Uri?): Bitmap? {
+        if (uri == null) return null
+        // Only local URIs; remote art would need its own fetch and is rare in queues
+        if (uri.scheme != ContentResolver.SCHEME_CONTENT &&
+            uri.scheme != ContentResolver.SCHEME_FILE &&
+            uri.scheme != ContentResolver.SCHEME_ANDROID_RESOURCE) return null
+        return try {
+            context.contentResolver.openInputStream(uri)?.use { BitmapFactory.decodeStream(it) }
+        } catch (e: Exception) {
+            Log.w("ArtPrefetcher", "Could not load queue art $uri: ${e.message}")
+            null
+        }
+    }
+}
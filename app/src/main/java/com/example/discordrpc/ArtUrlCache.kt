@@ -0,0 +1,14 @@
+package com.thepotato.discordrpc
+
+/**
+ * Track key -> uploaded cover-art URL. Lives in native memory under a byte
+ * budget (lru_cache.cpp) so a day of playback can't grow it without bound;
+ * the least recently used tracks are evicted first and onTrimMemory shrinks it.
+ */
+object ArtUrlCache {
+    operator fun get(trackId: String): String? = DiscordGateway.artCacheGet(trackId)
+
+    operator fun set(trackId: String, url: String) = DiscordGateway.artCachePut(trackId, url)
+
+    fun containsKey(trackId: String): Boolean = DiscordGateway.artCacheContains(trackId)
+}
@@ -4,20 +4,139 @@ import android.util.Log
 
 object DiscordGateway {
     // Native method declarations
+    external fun openPresenceJournal(path: String): Boolean
     external fun initDiscord(clientId: Long)
+    // Returns at once; the native pump clears, disconnects and calls onShutdownComplete
     external fun shutdownDiscord()
     external fun startAuthorization()
     external fun handleOAuthCallback(code: String, redirectUri: String)
     external fun connect()
-    external fun updateRichPresence(appName: String, details: String, state: String, imageKey: String, type: Int, statusDisplayType: Int)
-    external fun updateRichPresenceWithTimestamps(appName: String, details: String, state: String, imageKey: String, start: Long, end: Long, type: Int, statusDisplayType: Int)
+    // applicationId 0 = the global client; another id is served by the native client pool.
+    // appLabelId is from appLabelId/putAppLabel.
+    external fun updateRichPresence(appLabelId: Int, details: String, state: String, imageKey: String, type: Int, statusDisplayType: Int, applicationId: Long)
+    external fun updateRichPresenceWithTimestamps(appLabelId: Int, details: String, state: String, imageKey: String, start: Long, end: Long, type: Int, statusDisplayType: Int, applicationId: Long)
     external fun clearActivity()
     external fun restoreSession(accessToken: String, refreshToken: String)
     external fun requestUserUpdate()
 
+    // Cold-start session restore (session_store.cpp) and where startup time
+    // went (startup_timeline.cpp): ms since process start per phase, -1 if not reached
+    external fun warmStart(filesDir: String)
+    external fun setWarmStartEnabled(enabled: Boolean)
+    external fun forgetSession()
+    external fun markStartupUiReady()
+    external fun startupTimeline(): LongArray
+
+    // Per-application clients (client_pool.cpp): [clients, created, evicted,
+    // exchangeFailures, threadsPerClient, rssKbPerClient]
+    external fun clientPoolStats(): LongArray
+
+    // Affinity and priority of the pump and SDK threads (sched_policy.cpp):
+    // SCHED_BATTERY_SAVER, SCHED_BALANCED or SCHED_LOW_LATENCY
+    external fun setSchedProfile(profile: Int)
+    const val SCHED_BATTERY_SAVER = 0
+    const val SCHED_BALANCED = 1
+    const val SCHED_LOW_LATENCY = 2
+
+    // What a presence with an end timestamp becomes when the track is over and
+    // nothing replaced it (the player stopped silently): EXPIRY_CLEAR removes
+    // it, EXPIRY_UNTIMED keeps it without the countdown. Handled natively.
+    external fun setPresenceExpiryAction(action: Int)
+    const val EXPIRY_CLEAR = 0
+    const val EXPIRY_UNTIMED = 1
+
+    // Pacing of the notification and status broadcast (status_surface.cpp):
+    // offerStatus gives STATUS_POST_NOW, STATUS_SKIP, or the ms after which
+    // flushStatus should be asked again, which answers the same way
+    external fun offerStatus(status: Int, details: String, state: String, imageKey: String, appLabelId: Int,
+                             start: Long, end: Long, type: Int): Long
+    external fun flushStatus(): Long
+    external fun resetStatus()
+    external fun setStatusInterval(intervalMs: Long)
+    const val STATUS_IDLE = 0
+    const val STATUS_PLAYING = 1
+    const val STATUS_PAUSED = 2
+    const val STATUS_POST_NOW = 0L
+    const val STATUS_SKIP = -1L
+    // What a post published (status_block.cpp), decoded by NativeStatus; the
+    // eventfd is readable after each publish until readStatus
+    external fun statusEventFd(): Int
+    external fun readStatus(afterVersion: Long, out: LongArray): Array<String>?
+
+    // SDK callbacks on SDK threads, handed to the native pump, instead of a
+    // 16 ms RunCallbacks poll. False once a client exists.
+    external fun enableFreeThreadedSdk(): Boolean
+
+    // Called on a HandlerThread: its Looper runs the native pump instead of a
+    // thread of its own (looper_pump.cpp), until detached from that thread
+    external fun attachPumpToLooper(): Boolean
+    external fun detachPumpFromLooper()
+
+    // Settings the media callbacks need, held natively (config_store.cpp) so
+    // they don't read SharedPreferences: pushConfig republishes all of them,
+    // one array element per package with any setting, whenever one changes
+    external fun pushConfig(rpcEnabled: Boolean, packages: Array<String>, allowed: BooleanArray,
+                            activityTypes: IntArray, applicationIds: LongArray)
+    external fun configRpcEnabled(): Boolean
+    // Fills out[0..2] with [CONFIG_* flags, activity type, application id]
+    external fun appConfig(packageName: String, out: LongArray)
+    const val CONFIG_RPC_ENABLED = 1L
+    const val CONFIG_ALLOWED = 2L
+    // Metadata rules or the title noise dictionary cover the package
+    const val CONFIG_NATIVE_PARSER = 4L
+
+    // Application labels (label_cache.cpp), kept until a package broadcast
+    // invalidates them: appLabelId is -1 when PackageManager has to be asked
+    // and the answer given to putAppLabel. Null drops every label.
+    external fun appLabelId(packageName: String): Int
+    external fun putAppLabel(packageName: String, label: String): Int
+    external fun invalidateAppLabel(packageName: String?)
+    // [entries, hits, misses, invalidations, hitsPerHour]; a hit is a binder call avoided
+    external fun labelCacheStats(): LongArray
+
+    // Image host selection (upload_scheduler.cpp)
+    external fun configureUploadHosts(names: Array<String>)
+    external fun uploadPlan(): IntArray
+    external fun uploadHedgeDelayMs(host: Int): Long
+    external fun reportUploadResult(host: Int, success: Boolean, latencyMs: Long, bytes: Long)
+
+    // Byte-bounded native caches (lru_cache.cpp)
+    external fun artCacheGet(trackId: String): String?
+    external fun artCacheContains(trackId: String): Boolean
+    external fun artCachePut(trackId: String, url: String)
+    external fun artCacheStats(): LongArray
+    external fun trimNativeMemory(level: Int)
+
+    // Friends list changes since a version (relationship_store.cpp), decoded by
+    // NativeFriends; null while nothing changed
+    external fun friendChanges(afterVersion: Long): Array<Any>?
+    // User ids of friends whose display name or username has a word starting
+    // with query (friend_search.cpp), best first
+    external fun searchFriends(query: String, limit: Int): LongArray
+
+    // Counters, gauges and histograms (metrics.cpp), decoded by NativeMetrics
+    external fun metricsSnapshot(): LongArray
+    external fun recordPrefetch(event: Int)
+    const val PREFETCH_ISSUED = 0
+    const val PREFETCH_HIT = 1
+    const val PREFETCH_WASTED = 2
+    const val PREFETCH_NO_ART = 3
+
+    // Asynchronous native log (log_ring.cpp): android.util.Log priority filter
+    // and a dump of the retained records for bug reports
+    external fun setNativeLogLevel(priority: Int)
+    external fun dumpNativeLog(path: String): Boolean
+
+    // Per-app title rules (metadata_rules.cpp) and noise stripping (title_normalizer.cpp)
+    external fun loadMetadataRules(text: String): Boolean
+    external fun loadTitleNoise(text: String): Boolean
+    external fun parseMetadata(packageName: String, title: String, artist: String): Array<String>?
+
     var tokenSaver: ((String, String) -> Unit)? = null
     var startUserCallback: ((String, String, Long, String?) -> Unit)? = null
     var currentUser: com.thepotato.discordrpc.models.DiscordUser? = null
+    // Set from the main thread, called (and cleared) on the pump
+    @Volatile var shutdownListener: ((Boolean) -> Unit)? = null
 
     // Called from C++
     fun onTokenReceived(accessToken: String, refreshToken: String) {
@@ -31,6 +150,12 @@ object DiscordGateway {
         startUserCallback?.invoke(username, discriminator, currentUserId, avatarHash)
     }
 
+    // On the native pump thread; clean is false if the deadline cut the disconnect short
+    fun onShutdownComplete(clean: Boolean) {
+        Log.i("DiscordGateway", "Discord shutdown complete (clean=$clean)")
+        shutdownListener?.invoke(clean)
+    }
+
     init {
         try {
             System.loadLibrary("discord")
@@ -32,34 +32,85 @@ class DiscordMediaService : NotificationListenerService() {
     private val NOTIFICATION_ID = 1
     
     private val serviceScope = CoroutineScope(Dispatchers.Main)
+    // Filled by DiscordGateway.appConfig; media callbacks all run on the main thread
+    private val appConfig = LongArray(3)
+    // Title and text of the latest status given to updateNotification; posted
+    // whenever DiscordGateway.offerStatus or flushStatus says it's time
+    private var pendingNotification: Pair<String, String>? = null
+    private val statusHandler = android.os.Handler(android.os.Looper.getMainLooper())
+    private val flushStatus = Runnable { handleStatusDecision(DiscordGateway.flushStatus()) }
+    // The Exit action stops the service once the native shutdown reports back,
+    // or after this long if the pump never does
+    private val stopService = Runnable { stopSelf() }
+    // Held here: SharedPreferences only keeps a weak reference to listeners
+    private val prefsListener = android.content.SharedPreferences.OnSharedPreferenceChangeListener { _, key ->
+        if (key == null || key == KEY_RPC_ENABLED || key == KEY_ALLOWED_APPS ||
+            key.startsWith(KEY_APP_TYPE_PREFIX) || key.startsWith(KEY_APP_CLIENT_ID_PREFIX)) {
+            pushNativeConfig()
+        }
+    }
+    // Runs the native presence pump when KEY_LOOPER_PUMP is set (looper_pump.cpp)
+    private var pumpThread: android.os.HandlerThread? = null
     
     companion object {
-        const val ACTION_STATUS_UPDATE = "com.thepotato.discordrpc.STATUS_UPDATE"
         const val ACTION_REFRESH_SESSIONS = "com.thepotato.discordrpc.REFRESH_SESSIONS"
         const val ACTION_STOP_SERVICE = "com.thepotato.discordrpc.STOP_SERVICE"
+        // adb shell am broadcast -a <action> [--ei priority 3], on a debuggable
+        // build; a release build only takes them from inside the app
+        const val ACTION_DUMP_NATIVE_LOG = "com.thepotato.discordrpc.DUMP_NATIVE_LOG"
+        const val ACTION_SET_NATIVE_LOG_LEVEL = "com.thepotato.discordrpc.SET_NATIVE_LOG_LEVEL"
+        const val EXTRA_LOG_PRIORITY = "priority"
+        const val ACTION_SET_SCHED_PROFILE = "com.thepotato.discordrpc.SET_SCHED_PROFILE"
+        const val EXTRA_SCHED_PROFILE = "profile"
+        const val KEY_SCHED_PROFILE = "sched_profile"
+        const val ACTION_SET_FREE_THREADED_SDK = "com.thepotato.discordrpc.SET_FREE_THREADED_SDK"
+        const val ACTION_SET_LOOPER_PUMP = "com.thepotato.discordrpc.SET_LOOPER_PUMP"
+        const val KEY_LOOPER_PUMP = "looper_pump"
+        const val ACTION_SET_PRESENCE_EXPIRY = "com.thepotato.discordrpc.SET_PRESENCE_EXPIRY"
+        const val EXTRA_EXPIRY_ACTION = "action"
+        const val KEY_PRESENCE_EXPIRY = "presence_expiry"
+        const val ACTION_SET_STATUS_INTERVAL = "com.thepotato.discordrpc.SET_STATUS_INTERVAL"
+        const val EXTRA_INTERVAL_MS = "ms"
+        const val KEY_STATUS_INTERVAL_MS = "status_interval_ms"
+        const val DEFAULT_STATUS_INTERVAL_MS = 1000L
+        const val MAX_STATUS_INTERVAL_MS = 60_000L  // StatusSurface::kMaxIntervalMs
+        // Past kShutdownBudget (main.cpp), which bounds the native shutdown
+        const val SHUTDOWN_FALLBACK_MS = 3000L
+        const val ACTION_SET_UPLOAD_STANDIN = "com.thepotato.discordrpc.SET_UPLOAD_STANDIN"
+        const val EXTRA_URL = "url"
+        const val EXTRA_ENABLED = "enabled"
         const val KEY_RPC_ENABLED = "rpc_enabled"
-        const val EXTRA_STATUS = "status"
-        const val EXTRA_DETAILS = "details"
-        const val EXTRA_IMAGE = "image"
-        const val EXTRA_START_TIME = "start_time"
-        const val EXTRA_END_TIME = "end_time"
-        const val EXTRA_STATE = "state"
-        const val EXTRA_APP_NAME = "app_name"
-        const val EXTRA_ACTIVITY_TYPE = "activity_type"
+        const val KEY_APP_TYPE_PREFIX = "app_type_"
+        const val KEY_APP_CLIENT_ID_PREFIX = "app_client_id_"
         const val ACTION_APPS_UPDATE = "com.thepotato.discordrpc.APPS_UPDATE"
         const val EXTRA_APPS_LIST = "apps_list"
         
-        var currentStatus: String? = null
-        var currentDetails: String? = null
-        var currentState: String? = null
-        var currentAppName: String? = null
-        var currentActivityType: Int = ActivityType.LISTENING.value
-        var currentImage: String? = null
+        fun trackKey(details: String, state: String, packageName: String) = "$details|$state|$packageName"
     }
     
     override fun onCreate() {
         super.onCreate()
+        com.thepotato.discordrpc.parsing.MetadataParserFactory.loadRules(this)
+        getSharedPreferences(PREFS_NAME, MODE_PRIVATE).registerOnSharedPreferenceChangeListener(prefsListener)
+        pushNativeConfig()
+        artPrefetcher = ArtPrefetcher(this, urlCache, uploadingTracks) { trackId ->
+            // The track may have started while its prefetch was still uploading
+            serviceScope.launch {
+                if (trackId == currentTrackId) updatePresenceFromController(currentController)
+            }
+        }
+        if (getSharedPreferences(PREFS_NAME, MODE_PRIVATE).getBoolean(KEY_LOOPER_PUMP, false)) {
+            pumpThread = android.os.HandlerThread("discord-pump").apply {
+                start()
+                android.os.Handler(looper).post { DiscordGateway.attachPumpToLooper() }
+            }
+        }
         createNotificationChannel()
+        // The notification starts over, whatever an earlier instance posted
+        DiscordGateway.resetStatus()
+        DiscordGateway.setStatusInterval(
+            getSharedPreferences(PREFS_NAME, MODE_PRIVATE).getLong(KEY_STATUS_INTERVAL_MS, DEFAULT_STATUS_INTERVAL_MS)
+        )
         startForeground(NOTIFICATION_ID, createNotification("Initializing...", "Waiting for media sessions"))
         
         // Register receiver for refresh
@@ -69,13 +120,70 @@ class DiscordMediaService : NotificationListenerService() {
         } else {
             registerReceiver(refreshReceiver, filter)
         }
+        // The debug and tuning actions write prefs and retune native threads,
+        // so no other app gets to send them; adb only can on a debuggable build
+        val debuggable = applicationInfo.flags and android.content.pm.ApplicationInfo.FLAG_DEBUGGABLE != 0
+        val tuningFilter = android.content.IntentFilter(android.os.PowerManager.ACTION_POWER_SAVE_MODE_CHANGED).apply {
+            addAction(Intent.ACTION_LOCALE_CHANGED)
+            // Before 13 a runtime receiver is always exported, so a release
+            // build there goes without them
+            if (debuggable || Build.VERSION.SDK_INT >= Build.VERSION_CODES.TIRAMISU) {
+                addAction(ACTION_DUMP_NATIVE_LOG)
+                addAction(ACTION_SET_NATIVE_LOG_LEVEL)
+                addAction(ACTION_SET_SCHED_PROFILE)
+                addAction(ACTION_SET_FREE_THREADED_SDK)
+                addAction(ACTION_SET_LOOPER_PUMP)
+                addAction(ACTION_SET_PRESENCE_EXPIRY)
+                addAction(ACTION_SET_STATUS_INTERVAL)
+                addAction(ACTION_SET_UPLOAD_STANDIN)
+            }
+        }
+        if (Build.VERSION.SDK_INT >= Build.VERSION_CODES.TIRAMISU) {
+            registerReceiver(tuningReceiver, tuningFilter, if (debuggable) RECEIVER_EXPORTED else RECEIVER_NOT_EXPORTED)
+        } else {
+            registerReceiver(tuningReceiver, tuningFilter)
+        }
+        val packageFilter = android.content.IntentFilter(Intent.ACTION_PACKAGE_ADDED).apply {
+            addAction(Intent.ACTION_PACKAGE_REMOVED)
+            addAction(Intent.ACTION_PACKAGE_REPLACED)
+            addDataScheme("package")
+        }
+        if (Build.VERSION.SDK_INT >= Build.VERSION_CODES.TIRAMISU) {
+            registerReceiver(packageReceiver, packageFilter, RECEIVER_NOT_EXPORTED)
+        } else {
+            registerReceiver(packageReceiver, packageFilter)
+        }
+        applySchedProfile()
+        DiscordGateway.setPresenceExpiryAction(
+            getSharedPreferences(PREFS_NAME, MODE_PRIVATE).getInt(KEY_PRESENCE_EXPIRY, DiscordGateway.EXPIRY_CLEAR)
+        )
     }
 
     override fun onDestroy() {
         super.onDestroy()
         unregisterReceiver(refreshReceiver)
+        unregisterReceiver(tuningReceiver)
+        unregisterReceiver(packageReceiver)
+        statusHandler.removeCallbacks(flushStatus)
+        statusHandler.removeCallbacks(stopService)
+        DiscordGateway.shutdownListener = null
+        val labels = DiscordGateway.labelCacheStats()
+        Log.i("DiscordMediaService", "App labels: ${labels[1]} binder calls avoided (${labels[4]}/h), ${labels[2]} lookups")
+        getSharedPreferences(PREFS_NAME, MODE_PRIVATE).unregisterOnSharedPreferenceChangeListener(prefsListener)
         serviceScope.cancel()
+        artPrefetcher.shutdown()
         DiscordGateway.shutdownDiscord()
+        // The shutdown finishes on the pump's own thread once it's detached
+        pumpThread?.let { thread ->
+            android.os.Handler(thread.looper).post { DiscordGateway.detachPumpFromLooper() }
+            thread.quitSafely()
+        }
+        pumpThread = null
+    }
+
+    override fun onTrimMemory(level: Int) {
+        super.onTrimMemory(level)
+        DiscordGateway.trimNativeMemory(level)
     }
 
     private val refreshReceiver = object : android.content.BroadcastReceiver() {
@@ -90,6 +198,113 @@ class DiscordMediaService : NotificationListenerService() {
         }
     }
 
+    private val tuningReceiver = object : android.content.BroadcastReceiver() {
+        override fun onReceive(context: Context, intent: Intent) {
+            if (intent.action == ACTION_DUMP_NATIVE_LOG) {
+                // App-specific external storage, so it can be pulled without root
+                val file = java.io.File(getExternalFilesDir(null) ?: filesDir, "native-log.txt")
+                if (DiscordGateway.dumpNativeLog(file.absolutePath)) {
+                    Log.i("DiscordMediaService", "Native log written to ${file.absolutePath}")
+                }
+            } else if (intent.action == ACTION_SET_NATIVE_LOG_LEVEL) {
+                DiscordGateway.setNativeLogLevel(intent.getIntExtra(EXTRA_LOG_PRIORITY, Log.INFO))
+            } else if (intent.action == ACTION_SET_SCHED_PROFILE) {
+                getSharedPreferences(PREFS_NAME, MODE_PRIVATE).edit()
+                    .putInt(KEY_SCHED_PROFILE, intent.getIntExtra(EXTRA_SCHED_PROFILE, DiscordGateway.SCHED_BALANCED))
+                    .apply()
+                applySchedProfile()
+            } else if (intent.action == ACTION_SET_FREE_THREADED_SDK) {
+                // Read by DiscordRpcApplication, so it applies from the next process start
+                getSharedPreferences(PREFS_NAME, MODE_PRIVATE).edit()
+                    .putBoolean(DiscordRpcApplication.KEY_FREE_THREADED_SDK, intent.getBooleanExtra(EXTRA_ENABLED, false))
+                    .apply()
+            } else if (intent.action == ACTION_SET_LOOPER_PUMP) {
+                // Applies from the next service start
+                getSharedPreferences(PREFS_NAME, MODE_PRIVATE).edit()
+                    .putBoolean(KEY_LOOPER_PUMP, intent.getBooleanExtra(EXTRA_ENABLED, false))
+                    .apply()
+            } else if (intent.action == ACTION_SET_PRESENCE_EXPIRY) {
+                val action = intent.getIntExtra(EXTRA_EXPIRY_ACTION, DiscordGateway.EXPIRY_CLEAR)
+                getSharedPreferences(PREFS_NAME, MODE_PRIVATE).edit().putInt(KEY_PRESENCE_EXPIRY, action).apply()
+                DiscordGateway.setPresenceExpiryAction(action)
+            } else if (intent.action == android.os.PowerManager.ACTION_POWER_SAVE_MODE_CHANGED) {
+                applySchedProfile()
+            } else if (intent.action == ACTION_SET_STATUS_INTERVAL) {
+                val intervalMs = intent.getLongExtra(EXTRA_INTERVAL_MS, DEFAULT_STATUS_INTERVAL_MS)
+                    .coerceIn(0L, MAX_STATUS_INTERVAL_MS)
+                getSharedPreferences(PREFS_NAME, MODE_PRIVATE).edit().putLong(KEY_STATUS_INTERVAL_MS, intervalMs).apply()
+                DiscordGateway.setStatusInterval(intervalMs)
+            } else if (intent.action == ACTION_SET_UPLOAD_STANDIN) {
+                // Read by the next ImageUploader; no url goes back to the real hosts
+                getSharedPreferences(PREFS_NAME, MODE_PRIVATE).edit()
+                    .putString(ImageUploader.KEY_STANDIN_URL, intent.getStringExtra(EXTRA_URL))
+                    .apply()
+            } else if (intent.action == Intent.ACTION_LOCALE_CHANGED) {
+                // Labels are localized
+                DiscordGateway.invalidateAppLabel(null)
+            }
+        }
+    }
+
+    // An install, update or uninstall can change the label the cache holds
+    private val packageReceiver = object : android.content.BroadcastReceiver() {
+        override fun onReceive(context: Context, intent: Intent) {
+            intent.data?.schemeSpecificPart?.let { DiscordGateway.invalidateAppLabel(it) }
+        }
+    }
+
+    // Label id for the presence; PackageManager is only asked (two calls, the
+    // first a binder transaction to system_server) when the native cache has
+    // nothing for the package
+    private fun resolveAppLabel(packageName: String): Int {
+        var id = DiscordGateway.appLabelId(packageName)
+        if (id < 0) {
+            var label = "Unknown App"
+            try {
+                val appInfo = packageManager.getApplicationInfo(packageName, 0)
+                label = packageManager.getApplicationLabel(appInfo).toString()
+            } catch (e: Exception) {
+                Log.w("DiscordMediaService", "Could not get app label for $packageName")
+            }
+            id = DiscordGateway.putAppLabel(packageName, label)
+        }
+        return id
+    }
+
+    // Everything appConfig answers from, read once here instead of per callback
+    private fun pushNativeConfig() {
+        val prefs = getSharedPreferences(PREFS_NAME, MODE_PRIVATE)
+        val allowedApps = prefs.getStringSet(KEY_ALLOWED_APPS, emptySet()) ?: emptySet()
+        val types = HashMap<String, Int>()
+        val applicationIds = HashMap<String, Long>()
+        for ((key, value) in prefs.all) {
+            if (key.startsWith(KEY_APP_TYPE_PREFIX) && value is Int) {
+                types[key.removePrefix(KEY_APP_TYPE_PREFIX)] = value
+            } else if (key.startsWith(KEY_APP_CLIENT_ID_PREFIX) && value is Long) {
+                applicationIds[key.removePrefix(KEY_APP_CLIENT_ID_PREFIX)] = value
+            }
+        }
+        val packages = (allowedApps + types.keys + applicationIds.keys).toTypedArray()
+        DiscordGateway.pushConfig(
+            prefs.getBoolean(KEY_RPC_ENABLED, true),
+            packages,
+            BooleanArray(packages.size) { packages[it] in allowedApps },
+            IntArray(packages.size) { types[packages[it]] ?: ActivityType.LISTENING.value },
+            LongArray(packages.size) { applicationIds[packages[it]] ?: 0L }
+        )
+    }
+
+    // Battery saver mode overrides the chosen profile while it's on
+    private fun applySchedProfile() {
+        val powerManager = getSystemService(Context.POWER_SERVICE) as android.os.PowerManager
+        val profile = if (powerManager.isPowerSaveMode) {
+            DiscordGateway.SCHED_BATTERY_SAVER
+        } else {
+            getSharedPreferences(PREFS_NAME, MODE_PRIVATE).getInt(KEY_SCHED_PROFILE, DiscordGateway.SCHED_BALANCED)
+        }
+        DiscordGateway.setSchedProfile(profile)
+    }
+
 
 
 
@@ -134,52 +349,59 @@ class DiscordMediaService : NotificationListenerService() {
         if (intent?.action == ACTION_STOP_SERVICE) {
             Log.i("DiscordMediaService", "Stop service action received")
             unregisterCurrent()
-            DiscordGateway.shutdownDiscord()
             if (Build.VERSION.SDK_INT >= Build.VERSION_CODES.N) {
                 stopForeground(STOP_FOREGROUND_REMOVE)
             } else {
                 stopForeground(true)
             }
-            stopSelf()
+            // Stopping at once lets the process go with the presence still
+            // showing; the pump clears it and disconnects within its budget
+            DiscordGateway.shutdownListener = { clean ->
+                DiscordGateway.shutdownListener = null
+                Log.i("DiscordMediaService", "Discord shut down (${if (clean) "clean" else "forced"}); stopping")
+                statusHandler.post {
+                    statusHandler.removeCallbacks(stopService)
+                    stopSelf()
+                }
+            }
+            statusHandler.postDelayed(stopService, SHUTDOWN_FALLBACK_MS)
+            DiscordGateway.shutdownDiscord()
             return START_NOT_STICKY
         }
         return super.onStartCommand(intent, flags, startId)
     }
 
+    // Posting the notification is an IPC, so it only goes out when the native
+    // side sees a change and the interval since the last post allows it; a
+    // change inside the interval is flushed at its end. The same post
+    // publishes the status natively (status_block.cpp) for MainActivity.
     private fun updateNotification(
+        status: Int,
         title: String, 
         text: String, 
         image: String? = null, 
         start: Long = 0, 
         end: Long = 0,
         state: String? = null,
-        appName: String? = null,
-        activityType: Int = 2
+        activityType: Int = 2,
+        labelId: Int = -1
     ) {
-        val notificationManager = getSystemService(Context.NOTIFICATION_SERVICE) as NotificationManager
-        notificationManager.notify(NOTIFICATION_ID, createNotification(title, text))
-        
-        // Update Static Cache
-        currentStatus = title.replace("Discord RPC: ", "")
-        currentDetails = text
-        currentState = state
-        currentAppName = appName
-        currentActivityType = activityType
-        currentImage = image
-        
-        // Also broadcast to MainActivity
-        val intent = Intent(ACTION_STATUS_UPDATE).apply {
-            setPackage(packageName)
-            putExtra(EXTRA_STATUS, currentStatus)
-            putExtra(EXTRA_DETAILS, currentDetails)
-            putExtra(EXTRA_STATE, currentState)
-            putExtra(EXTRA_APP_NAME, currentAppName)
-            putExtra(EXTRA_ACTIVITY_TYPE, currentActivityType)
-            putExtra(EXTRA_IMAGE, currentImage)
-            putExtra(EXTRA_START_TIME, start)
-            putExtra(EXTRA_END_TIME, end)
+        pendingNotification = title to text
+        handleStatusDecision(
+            DiscordGateway.offerStatus(status, text, state ?: "", image ?: "", labelId, start, end, activityType)
+        )
+    }
+
+    private fun handleStatusDecision(decision: Long) {
+        if (decision == DiscordGateway.STATUS_POST_NOW) {
+            pendingNotification?.let { (title, text) ->
+                val notificationManager = getSystemService(Context.NOTIFICATION_SERVICE) as NotificationManager
+                notificationManager.notify(NOTIFICATION_ID, createNotification(title, text))
+            }
+        } else if (decision > 0) {
+            statusHandler.removeCallbacks(flushStatus)
+            statusHandler.postDelayed(flushStatus, decision)
         }
-        sendBroadcast(intent)
     }
 
     override fun onListenerConnected() {
@@ -210,8 +432,7 @@ class DiscordMediaService : NotificationListenerService() {
 
     private fun onActiveSessionsChanged(controllers: List<MediaController>?) {
         
-        val prefs = getSharedPreferences(PREFS_NAME, MODE_PRIVATE)
-        if (!prefs.getBoolean(KEY_RPC_ENABLED, true)) {
+        if (!DiscordGateway.configRpcEnabled()) {
             Log.d("DiscordMediaService", "RPC is disabled, clearing activity and shutting down")
             unregisterCurrent()
             currentController = null // Force re-registration on re-enable
@@ -220,16 +441,18 @@ class DiscordMediaService : NotificationListenerService() {
             return
         }
 
-        val allowedApps = prefs.getStringSet(KEY_ALLOWED_APPS, emptySet()) ?: emptySet()
         Log.i("DiscordMediaService", "Found sessions: ${controllers?.map { it.packageName }}")
 
-        val filteredControllers = controllers?.filter { allowedApps.contains(it.packageName) }
+        val filteredControllers = controllers?.filter {
+            DiscordGateway.appConfig(it.packageName, appConfig)
+            (appConfig[0] and DiscordGateway.CONFIG_ALLOWED) != 0L
+        }
 
         if (filteredControllers.isNullOrEmpty()) {
             broadcastAppsList(controllers) // Broadcast all found controllers so UI can show them
             unregisterCurrent()
             DiscordGateway.clearActivity()
-            updateNotification("Discord RPC: Idle", "Waiting for media playback", null, 0, 0, "Waiting for media playback", "Discord RPC", ActivityType.LISTENING.value)
+            updateNotification(DiscordGateway.STATUS_IDLE, "Discord RPC: Idle", "Waiting for media playback", null, 0, 0, "Waiting for media playback", ActivityType.LISTENING.value)
             return
         }
 
@@ -279,6 +502,10 @@ class DiscordMediaService : NotificationListenerService() {
                 updatePresenceFromController(controller)
             }
             
+            override fun onQueueChanged(queue: MutableList<android.media.session.MediaSession.QueueItem>?) {
+                artPrefetcher.prefetch(controller)
+            }
+
             override fun onSessionDestroyed() {
                  Log.d("DiscordMediaService", "Session destroyed")
                  unregisterCurrent()
@@ -294,8 +521,10 @@ class DiscordMediaService : NotificationListenerService() {
             return
         }
         
-        val prefs = getSharedPreferences(PREFS_NAME, MODE_PRIVATE)
-        if (!prefs.getBoolean(KEY_RPC_ENABLED, true)) {
+        val packageName = controller.packageName
+        DiscordGateway.appConfig(packageName, appConfig)
+        val flags = appConfig[0]
+        if ((flags and DiscordGateway.CONFIG_RPC_ENABLED) == 0L) {
             Log.d("DiscordMediaService", "RPC is disabled, clearing activity and shutting down")
             unregisterCurrent()
             DiscordGateway.clearActivity()
@@ -304,14 +533,16 @@ class DiscordMediaService : NotificationListenerService() {
         }
         val metadata = controller.metadata
         if (metadata == null) {
-             Log.w("DiscordMediaService", "updatePresence: Metadata is null for ${controller.packageName}")
+             Log.w("DiscordMediaService", "updatePresence: Metadata is null for ${packageName}")
              return
         }
         
-        val packageName = controller.packageName
-        
-        // Delegate parsing to modular system
-        val parser = com.thepotato.discordrpc.parsing.MetadataParserFactory.getParser(packageName)
+        // Delegate parsing to modular system; apps no rule covers skip the native call
+        val parser = if ((flags and DiscordGateway.CONFIG_NATIVE_PARSER) != 0L) {
+            com.thepotato.discordrpc.parsing.MetadataParserFactory.getParser(packageName)
+        } else {
+            com.thepotato.discordrpc.parsing.MetadataParserFactory.defaultParser
+        }
         val parsed = parser.parse(metadata)
         
         val details = parsed.details
@@ -321,12 +552,18 @@ class DiscordMediaService : NotificationListenerService() {
         val duration = metadata.getLong(MediaMetadata.METADATA_KEY_DURATION)
         val position = controller.playbackState?.position ?: 0L
         
-        // Helper to get type
-        val type = prefs.getInt("app_type_$packageName", ActivityType.LISTENING.value)
+        val type = appConfig[1].toInt()
+        // 0 = the global client; otherwise shown through its own pooled client
+        val applicationId = appConfig[2]
         
         // Handle Album Art
         var imageKey = "" // Default to no image
-        val trackId = "$details|$state|$packageName"
+        val trackId = trackKey(details, state, packageName)
+        if (trackId != currentTrackId) {
+            currentTrackId = trackId
+            artPrefetcher.onTrackShown(trackId)
+            artPrefetcher.prefetch(controller)
+        }
         val cachedUrl = urlCache[trackId]
         
         if (cachedUrl != null) {
@@ -335,8 +572,7 @@ class DiscordMediaService : NotificationListenerService() {
              // Not in cache, try to get bitmap and upload
              val bitmap = getCoverArt(metadata)
              if (bitmap != null) {
-                 if (!uploadingTracks.contains(trackId)) {
-                     uploadingTracks.add(trackId)
+                 if (uploadingTracks.add(trackId)) {
                      // Launch upload
                      serviceScope.launch(Dispatchers.IO) {
                          val url = ImageUploader(this@DiscordMediaService).uploadImage(bitmap)
@@ -354,13 +590,7 @@ class DiscordMediaService : NotificationListenerService() {
              }
         }
         
-        var appName = "Unknown App"
-        try {
-            val appInfo = packageManager.getApplicationInfo(packageName, 0)
-            appName = packageManager.getApplicationLabel(appInfo).toString()
-        } catch (e: Exception) {
-            Log.w("DiscordMediaService", "Could not get app label for $packageName")
-        }
+        val labelId = resolveAppLabel(packageName)
 
         val playbackState = controller.playbackState?.state
         val isPlaying = playbackState == android.media.session.PlaybackState.STATE_PLAYING
@@ -373,10 +603,10 @@ class DiscordMediaService : NotificationListenerService() {
             val startTs = now - position
             val endTs = startTs + duration
             Log.d("DiscordMediaService", "Sending presence update with timestamps")
-            DiscordGateway.updateRichPresenceWithTimestamps(appName, details, state, imageKey, startTs, endTs, type, displayType)
+            DiscordGateway.updateRichPresenceWithTimestamps(labelId, details, state, imageKey, startTs, endTs, type, displayType, applicationId)
         } else {
             Log.d("DiscordMediaService", "Sending standard presence update")
-            DiscordGateway.updateRichPresence(appName, details, state, imageKey, type, displayType)
+            DiscordGateway.updateRichPresence(labelId, details, state, imageKey, type, displayType, applicationId)
         }
         
         val statusText = if (playbackState == android.media.session.PlaybackState.STATE_PLAYING) "Playing" else "Paused"
@@ -385,7 +615,8 @@ class DiscordMediaService : NotificationListenerService() {
         val s = if (isPlaying && duration > 0) (System.currentTimeMillis() - (controller.playbackState?.position ?: 0)) else 0L
         val e = if (isPlaying && duration > 0) s + duration else 0L
         
-        updateNotification("Discord RPC: $statusText", details, imageKey, s, e, state, appName, type)
+        val status = if (isPlaying) DiscordGateway.STATUS_PLAYING else DiscordGateway.STATUS_PAUSED
+        updateNotification(status, "Discord RPC: $statusText", details, imageKey, s, e, state, type, labelId)
     }
 
     private fun broadcastAppsList(controllers: List<MediaController>?) {
@@ -400,8 +631,11 @@ class DiscordMediaService : NotificationListenerService() {
         Log.d("DiscordMediaService", "Broadcasted apps list: ${packages.size} apps")
     }
 
-    private val urlCache = mutableMapOf<String, String>()
-    private val uploadingTracks = mutableSetOf<String>()
+    private val urlCache = ArtUrlCache
+    // Shared with the prefetcher's background thread
+    private val uploadingTracks = java.util.concurrent.ConcurrentHashMap.newKeySet<String>()
+    private lateinit var artPrefetcher: ArtPrefetcher
+    private var currentTrackId: String? = null
 
     private fun getCoverArt(metadata: MediaMetadata?): Bitmap? {
         if (metadata == null) return null
@@ -0,0 +1,27 @@
+package com.thepotato.discordrpc
+
+import android.app.Application
+
+/**
+ * Starts restoring the Discord session before any activity or service exists:
+ * on a cold launch the client handshake then overlaps with Compose inflating
+ * MainActivity, and a service restarted after process death gets its presence
+ * back without the UI at all. MainActivity's initDiscord/restoreSession adopt
+ * the warm-started client rather than replacing it.
+ */
+class DiscordRpcApplication : Application() {
+    companion object {
+        /** Free-threaded SDK callbacks (presence_core.cpp); takes effect on the next process start */
+        const val KEY_FREE_THREADED_SDK = "free_threaded_sdk"
+    }
+
+    override fun onCreate() {
+        super.onCreate()
+        // Opt-in, and only possible before the first client exists
+        val prefs = getSharedPreferences("discord_rpc_prefs", MODE_PRIVATE)
+        if (prefs.getBoolean(KEY_FREE_THREADED_SDK, false)) {
+            DiscordGateway.enableFreeThreadedSdk()
+        }
+        DiscordGateway.warmStart(filesDir.absolutePath)
+    }
+}
@@ -2,71 +2,189 @@ package com.thepotato.discordrpc
 
 import android.content.Context
 import android.graphics.Bitmap
+import android.os.SystemClock
 import android.util.Log
+import kotlinx.coroutines.Job
+import kotlinx.coroutines.channels.Channel
+import kotlinx.coroutines.coroutineScope
+import kotlinx.coroutines.launch
+import kotlinx.coroutines.suspendCancellableCoroutine
+import kotlinx.coroutines.withTimeoutOrNull
+import okhttp3.Call
+import okhttp3.Callback
 import okhttp3.MediaType.Companion.toMediaTypeOrNull
 import okhttp3.MultipartBody
 import okhttp3.OkHttpClient
 import okhttp3.Request
-import okhttp3.RequestBody.Companion.asRequestBody
-import java.io.File
-import java.io.FileOutputStream
+import okhttp3.RequestBody.Companion.toRequestBody
+import okhttp3.Response
+import java.io.ByteArrayOutputStream
 import java.io.IOException
+import kotlin.coroutines.resume
 
 import java.util.concurrent.TimeUnit
 
+data class UploadHost(
+    val name: String,
+    val url: String,
+    val fileField: String,
+    val formFields: Map<String, String> = emptyMap()
+)
+
+private class AttemptResult(val url: String?)
+
 class ImageUploader(private val context: Context) {
 
-    private val client = OkHttpClient.Builder()
-        .connectTimeout(30, TimeUnit.SECONDS)
-        .writeTimeout(30, TimeUnit.SECONDS)
-        .readTimeout(30, TimeUnit.SECONDS)
-        .build()
+    companion object {
+        // Debug override: a local image_host_standin (see host/ in the native sources)
+        const val KEY_STANDIN_URL = "debug_upload_host_url"
+        // The "Backup image host" setting, off until the user opts in: each
+        // extra host is one more third party the cover art goes to. Without
+        // it there is one host, so nothing to hedge or fail over to.
+        const val KEY_EXTRA_HOSTS = "upload_extra_hosts"
+
+        private val DEFAULT_HOSTS = listOf(
+            UploadHost("catbox", "https://catbox.moe/user/api.php", "fileToUpload", mapOf("reqtype" to "fileupload"))
+        )
+        // Fallbacks for hedging and failover when the defaults are slow or down
+        private val EXTRA_HOSTS = listOf(
+            UploadHost("0x0", "https://0x0.st", "file")
+        )
+
+        // Shared so the connection pool survives between tracks. Hedging, not
+        // these timeouts, bounds how long a track waits on one slow host.
+        private val client = OkHttpClient.Builder()
+            .connectTimeout(10, TimeUnit.SECONDS)
+            .writeTimeout(30, TimeUnit.SECONDS)
+            .readTimeout(30, TimeUnit.SECONDS)
+            .build()
+
+        private var configuredHosts: List<UploadHost>? = null
+    }
+
+    private val hosts: List<UploadHost> = resolveHosts()
+
+    private fun resolveHosts(): List<UploadHost> {
+        val prefs = context.getSharedPreferences("discord_rpc_prefs", Context.MODE_PRIVATE)
+        val standin = prefs.getString(KEY_STANDIN_URL, null)
+        val defaults = if (prefs.getBoolean(KEY_EXTRA_HOSTS, false)) DEFAULT_HOSTS + EXTRA_HOSTS else DEFAULT_HOSTS
+        val list = if (standin.isNullOrBlank()) defaults else listOf(UploadHost("standin", standin, "fileToUpload")) + defaults
+        synchronized(Companion) {
+            if (configuredHosts != list) {
+                DiscordGateway.configureUploadHosts(list.map { it.name }.toTypedArray())
+                configuredHosts = list
+            }
+        }
+        return list
+    }
+
+    // Tries hosts in the order the native scheduler ranks them. If the current
+    // attempt outlives that host's p95 a hedged request goes to the next host;
+    // if it fails outright we fail over. First URL back wins.
+    suspend fun uploadImage(bitmap: Bitmap): String? = coroutineScope {
+        val bytes = encodeBitmap(bitmap) ?: return@coroutineScope null
+        Log.i("ImageUploader", "Uploading image: ${bytes.size} bytes")
+
+        val plan = DiscordGateway.uploadPlan()
+        if (plan.isEmpty()) return@coroutineScope null
 
-    fun uploadImage(bitmap: Bitmap): String? {
-        val file = saveBitmapToCache(bitmap) ?: return null
-        
-        Log.i("ImageUploader", "Uploading image: ${file.length()} bytes")
+        val results = Channel<AttemptResult>(Channel.UNLIMITED)
+        val attempts = mutableListOf<Job>()
+        var next = 0
+        var inFlight = 0
+        fun launchNext() {
+            val host = plan[next++]
+            inFlight++
+            attempts += launch { results.send(AttemptResult(attempt(host, bytes))) }
+        }
+
+        launchNext()
+        var url: String? = null
+        while (inFlight > 0 && url == null) {
+            val done = if (next < plan.size) {
+                withTimeoutOrNull(DiscordGateway.uploadHedgeDelayMs(plan[next - 1])) { results.receive() }
+            } else {
+                results.receive()
+            }
+            if (done == null) {
+                Log.i("ImageUploader", "Hedging upload on ${hosts[plan[next]].name}")
+                launchNext()
+                continue
+            }
+            inFlight--
+            url = done.url
+            if (url == null && inFlight == 0 && next < plan.size) {
+                Log.w("ImageUploader", "Failing over to ${hosts[plan[next]].name}")
+                launchNext()
+            }
+        }
+        attempts.forEach { it.cancel() }
+        url
+    }
 
+    private suspend fun attempt(index: Int, bytes: ByteArray): String? {
+        val host = hosts[index]
         val requestBody = MultipartBody.Builder()
             .setType(MultipartBody.FORM)
-            .addFormDataPart("reqtype", "fileupload")
-            .addFormDataPart("fileToUpload", "cover_art.png", 
-                file.asRequestBody("image/png".toMediaTypeOrNull()))
+            .apply { host.formFields.forEach { (key, value) -> addFormDataPart(key, value) } }
+            .addFormDataPart(host.fileField, "cover_art.png",
+                bytes.toRequestBody("image/png".toMediaTypeOrNull()))
             .build()
 
         val request = Request.Builder()
-            .url("https://catbox.moe/user/api.php")
+            .url(host.url)
             .post(requestBody)
             .build()
 
-        return try {
-            client.newCall(request).execute().use { response ->
-                if (!response.isSuccessful) {
-                    Log.e("ImageUploader", "Upload failed: ${response.code} ${response.message}")
-                    null
-                } else {
-                    val url = response.body?.string()
-                    Log.i("ImageUploader", "Upload successful: $url")
-                    url
-                }
+        val started = SystemClock.elapsedRealtime()
+        val call = client.newCall(request)
+        // A cancelled attempt (lost a hedge race) throws out of here without
+        // reporting; losing says nothing about the host's health.
+        val url = suspendCancellableCoroutine<String?> { cont ->
+            cont.invokeOnCancellation { call.cancel() }
+            // Exactly once, whatever OkHttp's callback thread runs into: an
+            // unresumed attempt would hang the whole hedge race
+            fun finish(url: String?) {
+                if (cont.isActive) cont.resume(url)
             }
-        } catch (e: IOException) {
-            Log.e("ImageUploader", "Network error during upload", e)
-            null
+            call.enqueue(object : Callback {
+                override fun onFailure(call: Call, e: IOException) {
+                    Log.e("ImageUploader", "Network error during upload to ${host.name}", e)
+                    finish(null)
+                }
+
+                override fun onResponse(call: Call, response: Response) {
+                    try {
+                        response.use {
+                            if (!it.isSuccessful) {
+                                Log.e("ImageUploader", "Upload to ${host.name} failed: ${it.code} ${it.message}")
+                                finish(null)
+                            } else {
+                                val body = it.body?.string()?.trim()
+                                finish(body?.takeIf { url -> url.startsWith("http") })
+                            }
+                        }
+                    } catch (e: Exception) {
+                        // A truncated or reset body throws out of string()
+                        Log.e("ImageUploader", "Could not read the response from ${host.name}", e)
+                        finish(null)
+                    }
+                }
+            })
         }
+
+        DiscordGateway.reportUploadResult(index, url != null, SystemClock.elapsedRealtime() - started, bytes.size.toLong())
+        if (url != null) Log.i("ImageUploader", "Upload successful via ${host.name}: $url")
+        return url
     }
 
-    private fun saveBitmapToCache(bitmap: Bitmap): File? {
+    private fun encodeBitmap(bitmap: Bitmap): ByteArray? {
         return try {
-            val cacheDir = context.cacheDir
-            val file = File(cacheDir, "temp_cover_art.png")
-            val outputStream = FileOutputStream(file)
+            val outputStream = ByteArrayOutputStream()
             bitmap.compress(Bitmap.CompressFormat.PNG, 100, outputStream)
-            outputStream.flush()
-            outputStream.close()
-            file
-        } catch (e: IOException) {
-            Log.e("ImageUploader", "Failed to save bitmap to cache", e)
+            outputStream.toByteArray()
+        } catch (e: Exception) {
+            Log.e("ImageUploader", "Failed to encode bitmap", e)
             null
         }
     }
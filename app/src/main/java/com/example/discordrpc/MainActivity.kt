@@ -59,6 +59,8 @@ class MainActivity : ComponentActivity() {
         // Init Discord
         DiscordSocialSdkInit.setEngineActivity(this)
         val clientId = prefs.getString("global_client_id", "1435558259892293662")?.toLongOrNull() ?: 1435558259892293662L
+        // Before initDiscord, so the first Ready can restore the last presence
+        DiscordGateway.openPresenceJournal(java.io.File(filesDir, "presence.journal").absolutePath)
         DiscordGateway.initDiscord(clientId)
         
         // Handle Token Persistence
@@ -77,18 +79,19 @@ class MainActivity : ComponentActivity() {
         if (savedAccess != null && savedRefresh != null) {
             DiscordGateway.restoreSession(savedAccess, savedRefresh)
         }
+        DiscordGateway.setWarmStartEnabled(prefs.getBoolean(DiscordMediaService.KEY_RPC_ENABLED, true))
         
         // Set Compose content
         setContent {
             DiscordRPCTheme {
                 val apps = remember { mutableStateListOf<com.thepotato.discordrpc.ui.screens.AppItem>() }
                 var isLoading by remember { mutableStateOf(true) }
-                var statusText by remember { mutableStateOf(DiscordMediaService.currentStatus ?: "Connected to Discord") }
-                var detailsText by remember { mutableStateOf(DiscordMediaService.currentDetails ?: "Waiting for service...") }
-                var stateText by remember { mutableStateOf(DiscordMediaService.currentState ?: "") }
-                var appNameText by remember { mutableStateOf(DiscordMediaService.currentAppName ?: "Discord RPC") }
+                var statusText by remember { mutableStateOf("Connected to Discord") }
+                var detailsText by remember { mutableStateOf("Waiting for service...") }
+                var stateText by remember { mutableStateOf("") }
+                var appNameText by remember { mutableStateOf("Discord RPC") }
                 var activityTypeText by remember { mutableIntStateOf(ActivityType.LISTENING.value) }
-                var imageKey by remember { mutableStateOf(DiscordMediaService.currentImage) }
+                var imageKey by remember { mutableStateOf<String?>(null) }
                 var startTime by remember { mutableStateOf(0L) }
                 var endTime by remember { mutableIntStateOf(0).let { mutableStateOf(0L) } }
                 
@@ -96,6 +99,9 @@ class MainActivity : ComponentActivity() {
                 var isRpcEnabled by remember { 
                     mutableStateOf(prefs.getBoolean(DiscordMediaService.KEY_RPC_ENABLED, true)) 
                 }
+                var isBackupHostEnabled by remember {
+                    mutableStateOf(prefs.getBoolean(ImageUploader.KEY_EXTRA_HOSTS, false))
+                }
                 
                 // User State
                 var currentUser by remember { mutableStateOf(DiscordGateway.currentUser) }
@@ -174,7 +180,8 @@ class MainActivity : ComponentActivity() {
                                         packageName = appInfo.packageName,
                                         icon = pm.getApplicationIcon(appInfo),
                                         isEnabled = allowedApps.contains(appInfo.packageName),
-                                        activityType = prefs.getInt("app_type_${appInfo.packageName}", 2)
+                                        activityType = prefs.getInt("app_type_${appInfo.packageName}", 2),
+                                        applicationId = prefs.getLong("app_client_id_${appInfo.packageName}", 0L)
                                     )
                                     batch.add(item)
 
@@ -216,40 +223,59 @@ class MainActivity : ComponentActivity() {
                 // Stream apps in
 // ... (lines 92-185 preserved automatically by context match if I skip them, but simpler to just focus on the Receiver part)
 
-                // Observe broadcast for status updates
+                // The service's status, from the native status block: its eventfd
+                // wakes the main looper once however many posts landed meanwhile
                 DisposableEffect(Unit) {
-                    val receiver = object : android.content.BroadcastReceiver() {
-                        override fun onReceive(context: android.content.Context, intent: android.content.Intent) {
-                            if (intent.action == DiscordMediaService.ACTION_STATUS_UPDATE) {
-                                statusText = intent.getStringExtra(DiscordMediaService.EXTRA_STATUS) ?: statusText
-                                detailsText = intent.getStringExtra(DiscordMediaService.EXTRA_DETAILS) ?: detailsText
-                                stateText = intent.getStringExtra(DiscordMediaService.EXTRA_STATE) ?: ""
-                                appNameText = intent.getStringExtra(DiscordMediaService.EXTRA_APP_NAME) ?: "Discord RPC"
-                                activityTypeText = intent.getIntExtra(DiscordMediaService.EXTRA_ACTIVITY_TYPE, ActivityType.LISTENING.value)
-                                imageKey = intent.getStringExtra(DiscordMediaService.EXTRA_IMAGE)
-                                startTime = intent.getLongExtra(DiscordMediaService.EXTRA_START_TIME, 0L)
-                                endTime = intent.getLongExtra(DiscordMediaService.EXTRA_END_TIME, 0L)
-                            }
-                        }
+                    var version = 0L
+                    fun refresh() {
+                        val status = NativeStatus.read(version) ?: return
+                        version = status.version
+                        if (!status.hasPresence) return
+                        statusText = status.statusText
+                        detailsText = status.details
+                        stateText = status.state
+                        appNameText = status.appName.ifEmpty { "Discord RPC" }
+                        activityTypeText = status.activityType
+                        imageKey = status.imageKey.ifEmpty { null }
+                        startTime = status.startTime
+                        endTime = status.endTime
                     }
 
-                    val filter = android.content.IntentFilter().apply {
-                        addAction(DiscordMediaService.ACTION_STATUS_UPDATE)
+                    // A dup, so closing it leaves the native fd alone
+                    val eventFd = DiscordGateway.statusEventFd().takeIf { it >= 0 }
+                        ?.let { android.os.ParcelFileDescriptor.fromFd(it) }
+                    val queue = android.os.Looper.getMainLooper().queue
+                    eventFd?.let {
+                        queue.addOnFileDescriptorEventListener(
+                            it.fileDescriptor,
+                            android.os.MessageQueue.OnFileDescriptorEventListener.EVENT_INPUT
+                        ) { _, events ->
+                            refresh()
+                            events
+                        }
                     }
-                    if (Build.VERSION.SDK_INT >= Build.VERSION_CODES.TIRAMISU) {
-                        registerReceiver(receiver, filter, RECEIVER_NOT_EXPORTED)
-                    } else {
-                        registerReceiver(receiver, filter)
+                    refresh()
+                    onDispose {
+                        eventFd?.let {
+                            queue.removeOnFileDescriptorEventListener(it.fileDescriptor)
+                            it.close()
+                        }
                     }
-                    onDispose { unregisterReceiver(receiver) }
                 }
 
                 MainScreen(
                     isRpcEnabled = isRpcEnabled,
+                    isBackupHostEnabled = isBackupHostEnabled,
+                    onBackupHostToggle = { enabled ->
+                        isBackupHostEnabled = enabled
+                        // Read by the next ImageUploader, so from the next upload
+                        prefs.edit().putBoolean(ImageUploader.KEY_EXTRA_HOSTS, enabled).apply()
+                    },
                     onRpcToggle = { enabled ->
                         Log.i("MainActivity", "Global RPC Toggled: $enabled")
                         isRpcEnabled = enabled
                         prefs.edit().putBoolean(DiscordMediaService.KEY_RPC_ENABLED, enabled).apply()
+                        DiscordGateway.setWarmStartEnabled(enabled)
                         
                         if (enabled) {
                             // Re-initialize Discord SDK since it was shut down
@@ -298,8 +324,18 @@ class MainActivity : ComponentActivity() {
                             apps[index] = apps[index].copy(activityType = type)
                         }
                     },
+                    onApplicationIdChanged = { packageName, applicationId ->
+                        updateApplicationId(packageName, applicationId)
+                        // Trigger service refresh
+                        sendBroadcast(Intent(DiscordMediaService.ACTION_REFRESH_SESSIONS))
+                        val index = apps.indexOfFirst { it.packageName == packageName }
+                        if (index != -1) {
+                            apps[index] = apps[index].copy(applicationId = applicationId)
+                        }
+                    },
                     onLogout = {
                         prefs.edit().clear().apply()
+                        DiscordGateway.forgetSession()
                         DiscordGateway.shutdownDiscord()
                         startActivity(Intent(this@MainActivity, OnboardingActivity::class.java))
                         finish()
@@ -307,6 +343,8 @@ class MainActivity : ComponentActivity() {
                 )
             }
         }
+        // Posted behind the first layout pass, so this marks the first frame
+        window.decorView.post { DiscordGateway.markStartupUiReady() }
     }
     
     
@@ -324,6 +362,10 @@ class MainActivity : ComponentActivity() {
         prefs.edit().putInt("app_type_$packageName", type).apply()
     }
     
+    private fun updateApplicationId(packageName: String, applicationId: Long) {
+        prefs.edit().putLong("app_client_id_$packageName", applicationId).apply()
+    }
+    
     private fun getAllowedApps(): Set<String> {
         return prefs.getStringSet(KEY_ALLOWED_APPS, emptySet()) ?: emptySet()
     }
@@ -0,0 +1,81 @@
+package com.thepotato.discordrpc
+
+import androidx.compose.runtime.mutableStateMapOf
+import com.thepotato.discordrpc.models.ActivityType
+
+/**
+ * The friends list as the native relationship store (relationship_store.cpp)
+ * last published it. [refresh] asks only for what changed since the version
+ * held and replaces just those entries of [friends], so a composable keyed on
+ * the user id recomposes for the friends that actually changed.
+ */
+class NativeFriends {
+    data class Friend(
+        val userId: Long,
+        val displayName: String,
+        val username: String,
+        /** discordpp::StatusType */
+        val status: Int,
+        /** ActivityType value, -1 if they aren't doing anything in this app */
+        val activityType: Int,
+        val activityName: String,
+        val details: String,
+        val state: String
+    ) {
+        val isListening get() = activityType == ActivityType.LISTENING.value && status != STATUS_OFFLINE
+    }
+
+    val friends = mutableStateMapOf<Long, Friend>()
+    private var version = 0L
+
+    /** False if nothing changed (also if the native library isn't loaded) */
+    fun refresh(): Boolean {
+        val changes = try {
+            DiscordGateway.friendChanges(version)
+        } catch (e: UnsatisfiedLinkError) {
+            return false
+        } ?: return false
+        val meta = changes[0] as LongArray
+        @Suppress("UNCHECKED_CAST")
+        val texts = changes[1] as Array<String>
+        val changed = meta[2].toInt()
+        val removed = meta[3].toInt()
+        if (meta[1] != 0L) friends.clear()
+        for (i in 0 until removed) friends.remove(meta[4 + changed * 3 + i])
+        for (i in 0 until changed) {
+            val friend = Friend(
+                userId = meta[4 + i * 3],
+                displayName = texts[i * 5],
+                username = texts[i * 5 + 1],
+                status = meta[5 + i * 3].toInt(),
+                activityType = meta[6 + i * 3].toInt(),
+                activityName = texts[i * 5 + 2],
+                details = texts[i * 5 + 3],
+                state = texts[i * 5 + 4]
+            )
+            friends[friend.userId] = friend
+        }
+        version = meta[0]
+        return true
+    }
+
+    /**
+     * Friends matching [query] by a word prefix of either name, from the native
+     * index; only those [refresh] has already brought into [friends]
+     */
+    fun search(query: String, limit: Int): List<Friend> {
+        val userIds = try {
+            DiscordGateway.searchFriends(query, limit)
+        } catch (e: UnsatisfiedLinkError) {
+            return emptyList()
+        }
+        return userIds.mapNotNull { friends[it] }
+    }
+
+    companion object {
+        const val STATUS_ONLINE = 0
+        const val STATUS_OFFLINE = 1
+        const val STATUS_IDLE = 3
+        const val STATUS_DND = 4
+    }
+}
@@ -0,0 +1,85 @@
+package com.thepotato.discordrpc
+
+import android.util.Log
+
+/**
+ * One reading of the native metrics registry (metrics.cpp). The snapshot is a
+ * flat LongArray whose header gives the size of each section, so indices here
+ * only need to match the enum order in metrics.h, not its length.
+ */
+class NativeMetrics private constructor(private val values: LongArray) {
+    private val counters = values[1].toInt()
+    private val gauges = values[2].toInt()
+    private val histograms = values[3].toInt()
+    private val buckets = values[4].toInt()
+
+    val presenceSubmits get() = counter(0)
+    val presenceAcks get() = counter(1)
+    val presenceFailures get() = counter(2)
+    val reconnects get() = counter(3)
+    val callbackWakeups get() = counter(4)
+    val uploadAttempts get() = counter(5)
+    val uploadFailures get() = counter(6)
+    val uploadBytes get() = counter(7)
+    val artCacheHits get() = counter(8)
+    val artCacheMisses get() = counter(9)
+    val logDropped get() = counter(10)
+    val logSuppressed get() = counter(11)
+    val presenceExpiries get() = counter(12)
+    val labelCacheHits get() = counter(13)
+    val labelCacheMisses get() = counter(14)
+    val presenceDeduped get() = counter(15)
+    val statusPosts get() = counter(16)
+    val statusSkips get() = counter(17)
+    val prefetchIssued get() = counter(18)
+    val prefetchHits get() = counter(19)
+    val prefetchWasted get() = counter(20)
+    val prefetchNoArt get() = counter(21)
+
+    val clientStatus get() = gauge(0)
+    val presenceInFlight get() = gauge(1)
+    val schedProfile get() = gauge(2)
+    val pumpCpuUs get() = gauge(3)
+    val processCpuUs get() = gauge(4)
+
+    /** Upper bound of the bucket holding the [quantile] presence ack latency, in ms */
+    fun presenceAckMs(quantile: Double) = histogramQuantile(0, quantile)
+    fun uploadLatencyMs(quantile: Double) = histogramQuantile(1, quantile)
+
+    private fun counter(index: Int) = if (index < counters) values[HEADER + index] else 0L
+
+    private fun gauge(index: Int) = if (index < gauges) values[HEADER + counters + index] else 0L
+
+    private fun histogramQuantile(index: Int, quantile: Double): Long {
+        if (index >= histograms) return 0
+        val base = HEADER + counters + gauges + index * (2 + buckets)
+        val count = values[base]
+        if (count == 0L) return 0
+        val target = (count * quantile).toLong().coerceAtLeast(1)
+        var seen = 0L
+        for (bucket in 0 until buckets) {
+            seen += values[base + 2 + bucket]
+            if (seen >= target) return if (bucket == 0) 0 else 1L shl bucket
+        }
+        return 1L shl buckets
+    }
+
+    companion object {
+        private const val HEADER = 5
+        private const val LAYOUT_VERSION = 1L
+
+        /** Current values, or null if the native library isn't loaded */
+        fun read(): NativeMetrics? {
+            val values = try {
+                DiscordGateway.metricsSnapshot()
+            } catch (e: UnsatisfiedLinkError) {
+                return null
+            }
+            if (values.size < HEADER || values[0] != LAYOUT_VERSION) {
+                Log.w("NativeMetrics", "Unexpected snapshot layout (${values.size} values)")
+                return null
+            }
+            return NativeMetrics(values)
+        }
+    }
+}
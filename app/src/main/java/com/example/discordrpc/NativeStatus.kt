@@ -0,0 +1,44 @@
+package com.thepotato.discordrpc
+
+/**
+ * One consistent reading of the native status block (status_block.cpp): what
+ * the service last posted to its notification, and the Discord client's
+ * connection status. Published natively, so the UI reads it instead of a
+ * broadcast; [DiscordGateway.statusEventFd] becomes readable when it changes.
+ */
+class NativeStatus private constructor(private val values: LongArray, texts: Array<String>) {
+    val version get() = values[0]
+    val status get() = values[1].toInt()
+    val activityType get() = values[2].toInt()
+    val startTime get() = values[3]
+    val endTime get() = values[4]
+    /** discordpp::Client::Status */
+    val connection get() = values[5].toInt()
+    /** False until the service first posts; only [connection] means anything before that */
+    val hasPresence get() = values[6] != 0L
+
+    val details = texts[0]
+    val state = texts[1]
+    val appName = texts[2]
+    val imageKey = texts[3]
+
+    /** As the notification title words it */
+    val statusText get() = when (status) {
+        DiscordGateway.STATUS_PLAYING -> "Playing"
+        DiscordGateway.STATUS_PAUSED -> "Paused"
+        else -> "Idle"
+    }
+
+    companion object {
+        /** The block if its version moved past [after], else null (also if the native library isn't loaded) */
+        fun read(after: Long = 0): NativeStatus? {
+            val values = LongArray(7)
+            val texts = try {
+                DiscordGateway.readStatus(after, values)
+            } catch (e: UnsatisfiedLinkError) {
+                return null
+            } ?: return null
+            return NativeStatus(values, texts)
+        }
+    }
+}
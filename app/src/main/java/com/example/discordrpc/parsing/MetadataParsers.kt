@@ -1,8 +1,13 @@
 package com.thepotato.discordrpc.parsing
 
+import android.content.Context
 import android.media.MediaMetadata
+import android.util.Log
 
+import com.thepotato.discordrpc.DiscordGateway
 import com.thepotato.discordrpc.models.StatusDisplayTypes
+import java.io.IOException
+import java.util.concurrent.ConcurrentHashMap
 
 data class ParsedMetadata(
     val details: String, // Top Line
@@ -26,35 +31,49 @@ class DefaultParser : MetadataParser {
     }
 }
 
-class StremioParser : MetadataParser {
+// Matches the title against the package's rules in assets/metadata_rules.conf,
+// then strips assets/title_noise.conf phrases for apps that enable it. Both are
+// compiled once in native code, so nothing is built per call.
+class RuleParser(private val packageName: String, private val fallback: MetadataParser) : MetadataParser {
     override fun parse(metadata: MediaMetadata): ParsedMetadata {
-        val rawTitle = metadata.getString(MediaMetadata.METADATA_KEY_TITLE) ?: "Unknown Title"
-        // Native format: "Show Name - S01E01 - Episode Title"
-        val regex = Regex("^(.*?) - (S\\d+E\\d+) - (.*)$")
-        val match = regex.find(rawTitle)
-        
-        return if (match != null) {
-            val (showName, seasonEpisode, episodeTitle) = match.destructured
-            ParsedMetadata(
-                details = showName,
-                state = "$seasonEpisode - $episodeTitle",
-                displayType = StatusDisplayTypes.DETAILS
-            )
-        } else {
-            // Fallback to default if regex fails
-            DefaultParser().parse(metadata)
-        }
+        val title = metadata.getString(MediaMetadata.METADATA_KEY_TITLE) ?: "Unknown Title"
+        val artist = metadata.getString(MediaMetadata.METADATA_KEY_ARTIST) ?: ""
+        val result = DiscordGateway.parseMetadata(packageName, title, artist)
+            ?: return fallback.parse(metadata)
+
+        return ParsedMetadata(
+            details = result[0],
+            state = result[1],
+            displayType = StatusDisplayTypes.valueOf(result[2])
+        )
     }
 }
 
 object MetadataParserFactory {
-    private val parsers = mapOf(
-        "com.stremio.one" to StremioParser()
-    )
-    
-    private val defaultParser = DefaultParser()
+    private const val RULES_ASSET = "metadata_rules.conf"
+    private const val NOISE_ASSET = "title_noise.conf"
+
+    val defaultParser = DefaultParser()
+    private val ruleParsers = ConcurrentHashMap<String, RuleParser>()
+
+    fun loadRules(context: Context) {
+        loadAsset(context, RULES_ASSET, DiscordGateway::loadMetadataRules)
+        loadAsset(context, NOISE_ASSET, DiscordGateway::loadTitleNoise)
+    }
+
+    private fun loadAsset(context: Context, name: String, load: (String) -> Boolean) {
+        try {
+            val text = context.assets.open(name).bufferedReader().use { it.readText() }
+            if (!load(text)) {
+                Log.e("MetadataParserFactory", "$name was rejected, using default parsing")
+            }
+        } catch (e: IOException) {
+            Log.e("MetadataParserFactory", "Could not read $name", e)
+        }
+    }
 
     fun getParser(packageName: String?): MetadataParser {
-        return parsers[packageName] ?: defaultParser
+        if (packageName == null) return defaultParser
+        return ruleParsers.getOrPut(packageName) { RuleParser(packageName, defaultParser) }
     }
 }
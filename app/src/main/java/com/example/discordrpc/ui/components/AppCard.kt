@@ -10,6 +10,7 @@ import androidx.compose.foundation.Image
 import androidx.compose.foundation.clickable
 import androidx.compose.foundation.layout.*
 import androidx.compose.foundation.shape.RoundedCornerShape
+import androidx.compose.foundation.text.KeyboardOptions
 import androidx.compose.material.icons.Icons
 import androidx.compose.material.icons.filled.Check
 import androidx.compose.material.icons.filled.Headset
@@ -18,10 +19,14 @@ import androidx.compose.material.icons.filled.Tv
 import androidx.compose.material3.*
 import androidx.compose.runtime.Composable
 import androidx.compose.runtime.getValue
+import androidx.compose.runtime.mutableStateOf
+import androidx.compose.runtime.remember
+import androidx.compose.runtime.setValue
 import androidx.compose.ui.Alignment
 import androidx.compose.ui.Modifier
 import androidx.compose.ui.graphics.asImageBitmap
 import androidx.compose.ui.text.font.FontWeight
+import androidx.compose.ui.text.input.KeyboardType
 import androidx.compose.ui.unit.dp
 import androidx.core.graphics.drawable.toBitmap
 
@@ -35,6 +40,8 @@ fun AppCard(
     onCheckedChange: (Boolean) -> Unit,
     activityType: Int,
     onActivityTypeChange: (Int) -> Unit,
+    applicationId: Long = 0L,
+    onApplicationIdChange: (Long) -> Unit = {},
     modifier: Modifier = Modifier
 ) {
     val containerColor by animateColorAsState(
@@ -199,6 +206,26 @@ fun AppCard(
                             }
                         }
                     }
+
+                    // Optional Discord application of its own (a child of the
+                    // signed-in one); blank shows it under the global client ID
+                    var applicationIdText by remember(applicationId) {
+                        mutableStateOf(if (applicationId != 0L) applicationId.toString() else "")
+                    }
+                    OutlinedTextField(
+                        value = applicationIdText,
+                        onValueChange = { text ->
+                            val digits = text.filter { it.isDigit() }.take(19)
+                            applicationIdText = digits
+                            onApplicationIdChange(digits.toLongOrNull() ?: 0L)
+                        },
+                        label = { Text("Discord application ID (optional)") },
+                        singleLine = true,
+                        keyboardOptions = KeyboardOptions(keyboardType = KeyboardType.Number),
+                        modifier = Modifier
+                            .fillMaxWidth()
+                            .padding(top = 12.dp)
+                    )
                 }
             }
         }
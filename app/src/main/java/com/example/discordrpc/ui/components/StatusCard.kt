@@ -19,6 +19,7 @@ import androidx.compose.ui.unit.dp
 import androidx.compose.ui.unit.sp
 import coil.compose.AsyncImage
 import coil.request.ImageRequest
+import com.thepotato.discordrpc.NativeMetrics
 import com.thepotato.discordrpc.models.DiscordUser
 import com.thepotato.discordrpc.models.ActivityType
 import kotlinx.coroutines.delay
@@ -35,6 +36,7 @@ fun StatusCard(
     start: Long = 0,
     end: Long = 0,
     user: DiscordUser? = null,
+    metrics: NativeMetrics? = null,
     modifier: Modifier = Modifier
 ) {
     Card(
@@ -141,10 +143,46 @@ fun StatusCard(
                     }
                 }
             }
+
+            if (metrics != null) {
+                Spacer(modifier = Modifier.height(12.dp))
+                HealthLine(metrics)
+            }
         }
     }
 }
 
+@Composable
+fun HealthLine(metrics: NativeMetrics) {
+    val lookups = metrics.artCacheHits + metrics.artCacheMisses
+    val parts = buildList {
+        add("${metrics.presenceAcks}/${metrics.presenceSubmits} updates")
+        if (metrics.presenceFailures > 0) add("${metrics.presenceFailures} failed")
+        if (metrics.presenceAcks > 0) add("ack p50 ${metrics.presenceAckMs(0.5)} ms")
+        if (metrics.reconnects > 0) add("${metrics.reconnects} reconnects")
+        if (metrics.presenceExpiries > 0) add("${metrics.presenceExpiries} expired")
+        if (metrics.uploadAttempts > 0) add("${formatBytes(metrics.uploadBytes)} uploaded")
+        if (lookups > 0) add("art cache ${metrics.artCacheHits * 100 / lookups}% hits")
+        if (metrics.statusSkips > 0) add("${metrics.statusSkips}/${metrics.statusSkips + metrics.statusPosts} status updates coalesced")
+        if (metrics.labelCacheHits > 0) add("${metrics.labelCacheHits} label lookups saved")
+        val prefetched = metrics.prefetchIssued - metrics.prefetchNoArt
+        if (prefetched > 0) add("art prefetch ${metrics.prefetchHits * 100 / prefetched}% hits, ${metrics.prefetchWasted * 100 / prefetched}% wasted")
+        if (metrics.processCpuUs > 0) add("native CPU ${metrics.processCpuUs / 1000} ms")
+    }
+    Text(
+        text = parts.joinToString(" · "),
+        color = Color(0xFF949BA4),
+        style = MaterialTheme.typography.bodySmall,
+        maxLines = 2
+    )
+}
+
+fun formatBytes(bytes: Long): String = when {
+    bytes >= 1 shl 20 -> String.format("%.1f MB", bytes / 1048576.0)
+    bytes >= 1 shl 10 -> String.format("%.1f KB", bytes / 1024.0)
+    else -> "$bytes B"
+}
+
 @Composable
 fun PresenceTimer(start: Long, end: Long) {
     var timeText by remember { mutableStateOf("") }
@@ -3,6 +3,7 @@ package com.thepotato.discordrpc.ui.screens
 import com.frosch2010.fuzzywuzzy_kotlin.Ratio
 import com.frosch2010.fuzzywuzzy_kotlin.diffutils.DiffUtils
 import android.graphics.drawable.Drawable
+import kotlinx.coroutines.delay
 import kotlinx.coroutines.launch
 import androidx.compose.animation.*
 import androidx.compose.animation.core.*
@@ -16,6 +17,7 @@ import androidx.compose.material.icons.Icons
 import androidx.compose.material.icons.filled.Clear
 import androidx.compose.material.icons.filled.Logout
 import androidx.compose.material.icons.filled.Search
+import androidx.compose.material.icons.filled.Settings
 import androidx.compose.material.icons.filled.Tv
 import androidx.compose.material3.*
 import androidx.compose.material3.ExperimentalMaterial3ExpressiveApi
@@ -36,15 +38,19 @@ import androidx.compose.foundation.shape.CircleShape
 import androidx.compose.foundation.background
 import androidx.compose.ui.draw.clip
 import com.thepotato.discordrpc.ui.components.AppCard
+import com.thepotato.discordrpc.ui.components.FriendRow
 import com.thepotato.discordrpc.ui.components.StatusCard
 import com.frosch2010.fuzzywuzzy_kotlin.FuzzySearch
+import com.thepotato.discordrpc.NativeFriends
+import com.thepotato.discordrpc.NativeMetrics
 
 data class AppItem(
     val name: String,
     val packageName: String,
     val icon: Drawable?,
     val isEnabled: Boolean,
-    val activityType: Int
+    val activityType: Int,
+    val applicationId: Long = 0L
 )
 
 @OptIn(ExperimentalMaterial3Api::class, ExperimentalMaterial3ExpressiveApi::class)
@@ -60,16 +66,20 @@ fun MainScreen(
     end: Long = 0,
     user: com.thepotato.discordrpc.models.DiscordUser? = null,
     isRpcEnabled: Boolean = true,
+    isBackupHostEnabled: Boolean = false,
     apps: List<AppItem>,
     isLoading: Boolean = false,
     onAppToggled: (String, Boolean) -> Unit,
     onRpcToggle: (Boolean) -> Unit,
+    onBackupHostToggle: (Boolean) -> Unit = {},
     onActivityTypeChanged: (String, Int) -> Unit,
+    onApplicationIdChanged: (String, Long) -> Unit = { _, _ -> },
     onLogout: () -> Unit
 ) {
     android.util.Log.i("MainScreen", "Recomposing with user: ${user?.username ?: "NULL"}")
     var searchQuery by remember { mutableStateOf("") }
     var searchActive by remember { mutableStateOf(false) }
+    var showSettings by remember { mutableStateOf(false) }
 
     val listState = rememberLazyListState()
     val searchListState = rememberLazyListState()
@@ -116,6 +126,37 @@ fun MainScreen(
         }
     }
 
+    // Live native health for the status card; a snapshot is one JNI call
+    val metrics by produceState<NativeMetrics?>(initialValue = null) {
+        while (true) {
+            value = NativeMetrics.read()
+            delay(2000)
+        }
+    }
+
+    // Friends from the native relationship store: each poll applies only the
+    // rows that changed, so unchanged friends keep their composition
+    val nativeFriends = remember { NativeFriends() }
+    LaunchedEffect(Unit) {
+        while (true) {
+            nativeFriends.refresh()
+            delay(2000)
+        }
+    }
+    val listeningFriends by remember {
+        derivedStateOf {
+            nativeFriends.friends.values.filter { it.isListening }.sortedBy { it.displayName.lowercase() }
+        }
+    }
+
+    // Natively indexed, so a query per keystroke costs microseconds
+    val matchedFriends by remember(searchQuery) {
+        derivedStateOf {
+            val query = searchQuery.trim()
+            if (query.isBlank()) emptyList() else nativeFriends.search(query, 5)
+        }
+    }
+
     val enabledApps by remember(apps) {
         derivedStateOf { apps.filter { it.isEnabled } }
     }
@@ -125,7 +166,9 @@ fun MainScreen(
         searchActive = false
         searchQuery = "" // Clear search so list restores before scroll
         coroutineScope.launch {
-            val index = if (app.isEnabled) {
+            // The friends section (header and rows) comes first when shown
+            val friendsItems = if (listeningFriends.isNotEmpty()) listeningFriends.size + 1 else 0
+            val index = friendsItems + if (app.isEnabled) {
                 1 + enabledApps.indexOfFirst { it.packageName == targetPackageName }
             } else {
                 val offset = if (enabledApps.isNotEmpty()) (enabledApps.size + 3) else 1
@@ -155,6 +198,31 @@ fun MainScreen(
         searchQuery = ""
     }
 
+    if (showSettings) {
+        AlertDialog(
+            onDismissRequest = { showSettings = false },
+            confirmButton = {
+                TextButton(onClick = { showSettings = false }) { Text("Done") }
+            },
+            title = { Text("Settings") },
+            text = {
+                Row(verticalAlignment = Alignment.CenterVertically) {
+                    Column(modifier = Modifier.weight(1f)) {
+                        Text("Backup image host", style = MaterialTheme.typography.titleSmall)
+                        Text(
+                            text = "Cover art is uploaded to catbox.moe so Discord can show it. With this on, " +
+                                "it may also go to 0x0.st when catbox is slow or down, so album art shows up sooner.",
+                            style = MaterialTheme.typography.bodySmall,
+                            color = MaterialTheme.colorScheme.onSurfaceVariant
+                        )
+                    }
+                    Spacer(modifier = Modifier.width(12.dp))
+                    Switch(checked = isBackupHostEnabled, onCheckedChange = onBackupHostToggle)
+                }
+            }
+        )
+    }
+
     Scaffold(
         topBar = {
             TopAppBar(
@@ -217,6 +285,9 @@ fun MainScreen(
                             } else null
                         )
                     }
+                    IconButton(onClick = { showSettings = true }) {
+                        Icon(Icons.Filled.Settings, contentDescription = "Settings")
+                    }
                     IconButton(onClick = onLogout) {
                         Icon(Icons.Filled.Logout, contentDescription = "Logout")
                     }
@@ -252,7 +323,8 @@ fun MainScreen(
                     image = image,
                     start = start,
                     end = end,
-                    user = user
+                    user = user,
+                    metrics = metrics
                 )
 
                 // Gap for the SearchBar integrated position
@@ -275,6 +347,21 @@ fun MainScreen(
                         modifier = Modifier.fillMaxSize(),
                         contentPadding = PaddingValues(bottom = 16.dp)
                     ) {
+                        if (listeningFriends.isNotEmpty() && searchQuery.isBlank()) {
+                            item {
+                                Text(
+                                    text = "Friends Listening",
+                                    style = MaterialTheme.typography.titleLarge,
+                                    fontWeight = FontWeight.Bold,
+                                    modifier = Modifier.padding(horizontal = 24.dp, vertical = 12.dp)
+                                )
+                            }
+
+                            items(listeningFriends, key = { "friend_${it.userId}" }) { friend ->
+                                FriendRow(friend, modifier = Modifier.animateItem())
+                            }
+                        }
+
                         // Active Apps Section
                         if (enabledApps.isNotEmpty() && searchQuery.isBlank()) {
                             item {
@@ -299,6 +386,10 @@ fun MainScreen(
                                         activityType = app.activityType,
                                         onActivityTypeChange = { type ->
                                             onActivityTypeChanged(app.packageName, type)
+                                        },
+                                        applicationId = app.applicationId,
+                                        onApplicationIdChange = { id ->
+                                            onApplicationIdChanged(app.packageName, id)
                                         }
                                     )
                                 }
@@ -340,6 +431,10 @@ fun MainScreen(
                                     activityType = app.activityType,
                                     onActivityTypeChange = { type ->
                                         onActivityTypeChanged(app.packageName, type)
+                                    },
+                                    applicationId = app.applicationId,
+                                    onApplicationIdChange = { id ->
+                                        onApplicationIdChanged(app.packageName, id)
                                     }
                                 )
                             }
@@ -364,7 +459,7 @@ fun MainScreen(
                         onActiveChange = { searchActive = it },
                         placeholder = {
                             Text(
-                                "Search apps...",
+                                "Search apps and friends...",
                                 style = MaterialTheme.typography.bodyLarge,
                                 color = MaterialTheme.colorScheme.onSurfaceVariant.copy(alpha = 0.6f)
                             )
@@ -409,6 +504,10 @@ fun MainScreen(
                             ),
                             verticalArrangement = Arrangement.spacedBy(10.dp)
                         ) {
+                            items(matchedFriends, key = { "friend_${it.userId}" }) { friend ->
+                                FriendRow(friend)
+                            }
+
                             items(filteredApps, key = { it.packageName }) { app ->
                                 Card(
                                     onClick = { jumpToApp(app) },